@@ -0,0 +1,138 @@
+#include "Analysis_cache.h"
+
+#include "Fen.h"
+
+#include <memory>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// Estimate the memory used by an entry with the given key and result.
+size_t estimate_memory(const std::string& position, const std::vector<Analyzed_line>& lines)
+{
+	// Key is stored both in the map and in the LRU list, and there's some overhead for map and list nodes
+	size_t memory = 2 * (sizeof(std::string) + position.capacity()) + 128;
+	memory += lines.capacity() * sizeof(Analyzed_line);
+	for (const Analyzed_line& line : lines) {
+		memory += line.moves.capacity() * sizeof(std::string);
+		for (const std::string& move : line.moves)
+			// Moves normally fit in the string itself
+			if (move.capacity() >= sizeof(std::string))
+				memory += move.capacity();
+	}
+	return memory;
+}
+
+} // Anonymous namespace
+
+Analysis_cache::Analysis_cache(Engine_pool& pool, size_t max_memory_bytes)
+	: pool_(pool)
+	, max_memory_bytes_(max_memory_bytes)
+{}
+
+std::shared_future<std::vector<Analyzed_line>> Analysis_cache::analyze(const Analysis_job& job)
+{
+	std::string position = normalize_fen(job.fen);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries_.find(position);
+	if (it != entries_.end() && answers(it->second, job)) {
+		Entry& entry = it->second;
+		if (entry.finished) {
+			statistics_.hits += 1;
+			// Mark as most recently used
+			lru_.splice(lru_.begin(), lru_, entry.lru_position);
+		} else {
+			statistics_.coalesced += 1;
+		}
+		return entry.result;
+	}
+
+	// Start a new analysis, replacing any result from a shorter (or otherwise limited) analysis
+	statistics_.misses += 1;
+	if (it != entries_.end())
+		erase(it);
+	auto promise = std::make_shared<std::promise<std::vector<Analyzed_line>>>();
+	Entry& entry = entries_[position];
+	entry.id = next_id_++;
+	entry.calculation_time = job.calculation_time;
+	entry.limits = job.limits;
+	entry.result = promise->get_future().share();
+
+	pool_.execute([this, job, position, id = entry.id, promise](Engine& engine) {
+		try {
+			std::vector<Analyzed_line> lines = run_analysis_job(engine, job);
+			on_analysis_finished(position, id, &lines);
+			promise->set_value(std::move(lines));
+		} catch (...) {
+			on_analysis_finished(position, id, nullptr);
+			promise->set_exception(std::current_exception());
+		}
+	});
+	return entry.result;
+}
+
+Analysis_cache::Statistics Analysis_cache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return statistics_;
+}
+
+size_t Analysis_cache::memory_usage() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return memory_usage_;
+}
+
+size_t Analysis_cache::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+bool Analysis_cache::answers(const Entry& entry, const Analysis_job& job)
+{
+	if (entry.limits.has_value() || job.limits.has_value())
+		return entry.limits == job.limits;
+	return entry.calculation_time >= job.calculation_time;
+}
+
+void Analysis_cache::on_analysis_finished(const std::string& position, uint64_t id, const std::vector<Analyzed_line>* lines)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries_.find(position);
+	if (it == entries_.end() || it->second.id != id)
+		// Entry has been replaced by a longer analysis
+		return;
+	if (lines == nullptr) {
+		// Don't keep failed analyses, so that the position can be requested again
+		erase(it);
+		return;
+	}
+
+	Entry& entry = it->second;
+	entry.finished = true;
+	entry.memory = estimate_memory(position, *lines);
+	entry.lru_position = lru_.insert(lru_.begin(), position);
+	memory_usage_ += entry.memory;
+
+	// Evict least recently used entries until we are within the memory limit
+	while (memory_usage_ > max_memory_bytes_ && !lru_.empty()) {
+		erase(entries_.find(lru_.back()));
+		statistics_.evictions += 1;
+	}
+}
+
+void Analysis_cache::erase(std::unordered_map<std::string, Entry>::iterator entry)
+{
+	if (entry->second.finished) {
+		memory_usage_ -= entry->second.memory;
+		lru_.erase(entry->second.lru_position);
+	}
+	entries_.erase(entry);
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,126 @@
+/**
+ * \file Analysis_cache.h
+ * \brief Contains an in-memory cache of engine analysis results in front of an engine pool.
+ */
+
+#pragma once
+
+#include "Engine_pool.h"
+#include "Line.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Analysis_cache
+ * \brief Remembers the results of analysis jobs run on an engine pool, so that positions which are
+ * asked for again don't need to be analyzed again.
+ *
+ * Results are keyed by the normalized position (see normalize_fen()). All results come from the
+ * same pool, so they all contain the number of best lines the pool's engines calculate. A stored
+ * result is used for any request for the same position with at most the calculation time of the
+ * stored result, so the result of a long calculation also answers requests for shorter ones.
+ * Requests with other search limits (see Analysis_job::limits) are only answered by a result
+ * calculated with the same limits.
+ *
+ * If a position is requested while an analysis of it with at least the requested calculation time
+ * is already running, the request shares the result of the running analysis instead of starting
+ * another one.
+ *
+ * Finished results are evicted in least recently used order when the memory used by the stored
+ * results exceeds the given limit. The memory use is estimated from the sizes of the stored lines.
+ * All member functions are thread safe.
+ */
+class Analysis_cache
+{
+public:
+	/// Counters for how requests have been served.
+	struct Statistics
+	{
+		/// Requests answered by a stored result.
+		uint64_t hits{0};
+		/// Requests which shared the result of an analysis that was already running.
+		uint64_t coalesced{0};
+		/// Requests which started a new analysis.
+		uint64_t misses{0};
+		/// Results which have been evicted to stay within the memory limit.
+		uint64_t evictions{0};
+	};
+
+	/**
+	 * \param pool Engine pool running the analyses. Must outlive the cache.
+	 * \param max_memory_bytes Approximate maximum number of bytes used by stored results.
+	 */
+	Analysis_cache(Engine_pool& pool, size_t max_memory_bytes);
+
+	Analysis_cache(const Analysis_cache&) = delete;
+	Analysis_cache& operator=(const Analysis_cache&) = delete;
+
+	/**
+	 * Get the analysis of a position, from the cache if possible.
+	 *
+	 * \param job Position to analyze and how long to analyze it.
+	 * \return Future holding the top suggested lines for the position. If the analysis fails the
+	 * future holds the exception thrown by the engine, and nothing is stored for the position.
+	 */
+	std::shared_future<std::vector<Analyzed_line>> analyze(const Analysis_job& job);
+
+	/// Get counters for how requests have been served so far.
+	Statistics statistics() const;
+	/// Approximate number of bytes used by the stored results.
+	size_t memory_usage() const;
+	/// Number of stored results, including analyses which are still running.
+	size_t size() const;
+
+private:
+	/// Stored or running analysis of a position.
+	struct Entry
+	{
+		/// Identifies the analysis, so that a finished analysis doesn't update an entry which has since been replaced.
+		uint64_t id{0};
+		/// Calculation time of the analysis.
+		std::chrono::milliseconds calculation_time{0};
+		/// Search limits of the analysis, if other than calculation_time.
+		std::optional<Search_limits> limits;
+		/// Result of the analysis.
+		std::shared_future<std::vector<Analyzed_line>> result;
+		/// Whether or not the analysis has finished.
+		bool finished{false};
+		/// Estimated memory use of the finished entry.
+		size_t memory{0};
+		/// Position of the entry in lru_ (only valid when finished).
+		std::list<std::string>::iterator lru_position;
+	};
+
+	/// Whether or not the result of the given entry answers the given job.
+	static bool answers(const Entry& entry, const Analysis_job& job);
+	/// Update the entry for the given position when its analysis has finished.
+	void on_analysis_finished(const std::string& position, uint64_t id, const std::vector<Analyzed_line>* lines);
+	/// Remove the given entry.
+	void erase(std::unordered_map<std::string, Entry>::iterator entry);
+
+	Engine_pool& pool_;
+	const size_t max_memory_bytes_;
+
+	mutable std::mutex mutex_;
+	/// Entries by normalized position.
+	std::unordered_map<std::string, Entry> entries_;
+	/// Positions of the finished entries, most recently used first.
+	std::list<std::string> lru_;
+	size_t memory_usage_{0};
+	uint64_t next_id_{1};
+	Statistics statistics_;
+};
+
+} // namespace uci
+} // namespace chess
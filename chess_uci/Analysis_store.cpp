@@ -0,0 +1,301 @@
+#include "Analysis_store.h"
+
+#include "Fen.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace chess {
+namespace uci {
+
+struct Analysis_store::Header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t slot_size;
+	uint64_t num_slots;
+	/// Number of entries in the store, only updated by the writer.
+	std::atomic<uint64_t> num_entries;
+	char reserved[32];
+};
+
+struct Analysis_store::Slot
+{
+	/// Hash of the position, or 0 if the slot is empty. Written last, so that a non-zero key
+	/// means that the rest of the slot is complete.
+	std::atomic<uint64_t> key;
+	/// Second hash of the position, to detect collisions of the first hash.
+	uint32_t check;
+	uint16_t depth;
+	uint8_t num_lines;
+	uint8_t line_lengths[max_lines];
+	/// Evaluation of each line (see Packed_evaluation::bits()).
+	uint32_t evaluations[max_lines];
+	/// Moves of each line (see Move::bits()).
+	uint16_t moves[max_lines][max_moves_per_line];
+};
+
+namespace {
+
+constexpr char store_magic[8] = {'U', 'C', 'I', 'S', 'T', 'O', 'R', 'E'};
+constexpr uint32_t store_version = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Entries must be published without locks to be shared between processes");
+
+/// FNV-1a hash of the given string, starting from the given offset basis.
+uint64_t fnv1a(std::string_view string, uint64_t hash)
+{
+	for (char c : string) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+struct Position_hash
+{
+	uint64_t key;
+	uint32_t check;
+};
+
+Position_hash hash_position(std::string_view fen)
+{
+	std::string position = normalize_fen(fen);
+	uint64_t key = fnv1a(position, 0xcbf29ce484222325ULL);
+	// Zero marks an empty slot
+	if (key == 0)
+		key = 1;
+	uint64_t check = fnv1a(position, 0x84222325cbf29ce4ULL);
+	return {key, static_cast<uint32_t>(check ^ (check >> 32))};
+}
+
+[[noreturn]] void throw_system_error(const std::string& what)
+{
+	throw std::system_error(errno, std::generic_category(), "Analysis store error: " + what);
+}
+
+} // Anonymous namespace
+
+Analysis_store Analysis_store::create(const std::filesystem::path& path, uint64_t capacity)
+{
+	// Keep the table at most 3/4 full, and use a power of two size so that slots are found by masking
+	uint64_t num_slots = 8;
+	while (num_slots < capacity + capacity / 3)
+		num_slots *= 2;
+
+	Analysis_store store;
+	store.fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (store.fd_ < 0)
+		throw_system_error("Failed to create " + path.string());
+	if (::flock(store.fd_, LOCK_EX | LOCK_NB) != 0)
+		throw_system_error("Failed to lock " + path.string() + " for writing");
+	// Truncate only once we are the only writer
+	if (::ftruncate(store.fd_, 0) != 0 || ::ftruncate(store.fd_, sizeof(Header) + num_slots * sizeof(Slot)) != 0)
+		throw_system_error("Failed to resize " + path.string());
+
+	// Write the header through a mapping of the new (zero filled) file
+	void* mapping = ::mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, store.fd_, 0);
+	if (mapping == MAP_FAILED)
+		throw_system_error("Failed to map " + path.string());
+	Header* header = static_cast<Header*>(mapping);
+	std::memcpy(header->magic, store_magic, sizeof(store_magic));
+	header->version = store_version;
+	header->slot_size = sizeof(Slot);
+	header->num_slots = num_slots;
+	::munmap(mapping, sizeof(Header));
+
+	store.map(Access::read_write);
+	return store;
+}
+
+Analysis_store::Analysis_store(const std::filesystem::path& path, Access access)
+{
+	fd_ = ::open(path.c_str(), access == Access::read_write ? O_RDWR : O_RDONLY);
+	if (fd_ < 0)
+		throw_system_error("Failed to open " + path.string());
+	if (access == Access::read_write && ::flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+		int error = errno;
+		close();
+		errno = error;
+		throw_system_error("Failed to lock " + path.string() + " for writing");
+	}
+	try {
+		map(access);
+	} catch (...) {
+		close();
+		throw;
+	}
+}
+
+Analysis_store::~Analysis_store()
+{
+	close();
+}
+
+Analysis_store::Analysis_store(Analysis_store&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+Analysis_store& Analysis_store::operator=(Analysis_store&& other) noexcept
+{
+	if (this != &other) {
+		close();
+		fd_ = other.fd_;
+		mapping_ = other.mapping_;
+		mapping_size_ = other.mapping_size_;
+		access_ = other.access_;
+		other.fd_ = -1;
+		other.mapping_ = nullptr;
+		other.mapping_size_ = 0;
+	}
+	return *this;
+}
+
+bool Analysis_store::insert(std::string_view fen, uint16_t depth, const std::vector<Analyzed_line>& lines)
+{
+	if (access_ != Access::read_write)
+		throw std::logic_error("Analysis store error: Store is not open for writing");
+
+	Header& store_header = *header();
+	// Always leave an empty slot, so that looking up a missing position ends
+	if (store_header.num_entries.load(std::memory_order_relaxed) + 1 >= store_header.num_slots)
+		return false;
+
+	Position_hash hash = hash_position(fen);
+	uint64_t mask = store_header.num_slots - 1;
+	for (uint64_t index = hash.key & mask;; index = (index + 1) & mask) {
+		Slot& slot = slots()[index];
+		uint64_t key = slot.key.load(std::memory_order_acquire);
+		if (key == hash.key && slot.check == hash.check)
+			return false;
+		if (key != 0)
+			continue;
+
+		// Fill in the entry before publishing it by setting the key
+		slot.check = hash.check;
+		slot.depth = depth;
+		slot.num_lines = static_cast<uint8_t>(std::min(lines.size(), max_lines));
+		for (size_t i = 0; i < slot.num_lines; ++i) {
+			const Analyzed_line& line = lines[i];
+			slot.evaluations[i] = Packed_evaluation(line.evaluation).bits();
+			slot.line_lengths[i] = static_cast<uint8_t>(std::min(line.moves.size(), max_moves_per_line));
+			for (size_t j = 0; j < slot.line_lengths[i]; ++j)
+				slot.moves[i][j] = Move::from_lan(line.moves[j]).bits();
+		}
+		slot.key.store(hash.key, std::memory_order_release);
+		store_header.num_entries.fetch_add(1, std::memory_order_release);
+		return true;
+	}
+}
+
+std::optional<Stored_analysis> Analysis_store::find(std::string_view fen) const
+{
+	const Header& store_header = *header();
+	Position_hash hash = hash_position(fen);
+	uint64_t mask = store_header.num_slots - 1;
+	uint64_t index = hash.key & mask;
+	for (uint64_t probe = 0; probe < store_header.num_slots; ++probe, index = (index + 1) & mask) {
+		const Slot& slot = slots()[index];
+		uint64_t key = slot.key.load(std::memory_order_acquire);
+		if (key == 0)
+			return std::nullopt;
+		if (key != hash.key || slot.check != hash.check)
+			continue;
+
+		Stored_analysis analysis;
+		analysis.depth = slot.depth;
+		analysis.lines.resize(std::min<size_t>(slot.num_lines, max_lines));
+		for (size_t i = 0; i < analysis.lines.size(); ++i) {
+			analysis.lines[i].evaluation = Packed_evaluation::from_bits(slot.evaluations[i]);
+			size_t length = std::min<size_t>(slot.line_lengths[i], max_moves_per_line);
+			for (size_t j = 0; j < length; ++j)
+				analysis.lines[i].moves.push_back(Move::from_bits(slot.moves[i][j]));
+		}
+		return analysis;
+	}
+	return std::nullopt;
+}
+
+uint64_t Analysis_store::size() const
+{
+	return header()->num_entries.load(std::memory_order_acquire);
+}
+
+uint64_t Analysis_store::num_slots() const
+{
+	return header()->num_slots;
+}
+
+void Analysis_store::flush()
+{
+	if (::msync(mapping_, mapping_size_, MS_SYNC) != 0)
+		throw_system_error("Failed to write store to disk");
+}
+
+void Analysis_store::map(Access access)
+{
+	static_assert(sizeof(Header) == 64, "Store header must have a fixed size");
+	static_assert(sizeof(Slot) == 128, "Store slots must have a fixed size");
+
+	access_ = access;
+	struct stat file_status;
+	if (::fstat(fd_, &file_status) != 0)
+		throw_system_error("Failed to get file size");
+	if (static_cast<size_t>(file_status.st_size) < sizeof(Header))
+		throw std::runtime_error("Analysis store error: File is too small to be a store");
+
+	mapping_size_ = static_cast<size_t>(file_status.st_size);
+	int protection = access == Access::read_write ? PROT_READ | PROT_WRITE : PROT_READ;
+	mapping_ = ::mmap(nullptr, mapping_size_, protection, MAP_SHARED, fd_, 0);
+	if (mapping_ == MAP_FAILED) {
+		mapping_ = nullptr;
+		throw_system_error("Failed to map store file");
+	}
+
+	const Header& store_header = *header();
+	if (std::memcmp(store_header.magic, store_magic, sizeof(store_magic)) != 0 || store_header.version != store_version)
+		throw std::runtime_error("Analysis store error: File is not a store, or was written by an incompatible version");
+	bool valid_size = store_header.slot_size == sizeof(Slot)
+		&& store_header.num_slots > 0
+		&& (store_header.num_slots & (store_header.num_slots - 1)) == 0
+		&& mapping_size_ == sizeof(Header) + store_header.num_slots * sizeof(Slot);
+	if (!valid_size)
+		throw std::runtime_error("Analysis store error: Store file is truncated or corrupt");
+}
+
+void Analysis_store::close()
+{
+	if (mapping_ != nullptr)
+		::munmap(mapping_, mapping_size_);
+	if (fd_ >= 0)
+		// Also releases the write lock
+		::close(fd_);
+	mapping_ = nullptr;
+	mapping_size_ = 0;
+	fd_ = -1;
+}
+
+Analysis_store::Header* Analysis_store::header() const
+{
+	return static_cast<Header*>(mapping_);
+}
+
+Analysis_store::Slot* Analysis_store::slots() const
+{
+	return reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + sizeof(Header));
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,139 @@
+/**
+ * \file Analysis_store.h
+ * \brief Contains a persistent, memory mapped store of analyzed positions.
+ */
+
+#pragma once
+
+#include "Line.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/// Analysis of a position, as kept in an Analysis_store.
+struct Stored_analysis
+{
+	/// Depth the position was analyzed to.
+	uint16_t depth{0};
+	/// Best lines from the position, best line first.
+	std::vector<Compact_analyzed_line> lines;
+};
+
+/**
+ * \class Analysis_store
+ * \brief Hash table of analyzed positions kept in a memory mapped file, so that analysis results
+ * survive restarts and can be shared between processes.
+ *
+ * The file is mapped into memory rather than read, so opening even a very large store is
+ * instantaneous and only the parts which are used are loaded (by the operating system). Positions
+ * are found in constant time by open addressing on a 64 bit hash of the normalized position (see
+ * normalize_fen()), with a second 32 bit hash to guard against collisions.
+ *
+ * Any number of processes can open the store for reading, while at most one process at a time can
+ * open it for writing. The writer only adds entries, and each entry is published atomically, so
+ * readers never need to lock and always see complete entries. Entries are never replaced or
+ * removed.
+ *
+ * Each entry holds up to max_lines lines of up to max_moves_per_line moves each, which is 128 bytes
+ * per entry.
+ */
+class Analysis_store
+{
+public:
+	/// Maximum number of lines stored per position.
+	static constexpr size_t max_lines = 3;
+	/// Maximum number of moves stored per line. Longer lines are truncated.
+	static constexpr size_t max_moves_per_line = 16;
+
+	enum class Access
+	{
+		read_only,
+		read_write
+	};
+
+	/**
+	 * Create a new, empty store.
+	 *
+	 * The file is created with its full size up front, but as a sparse file, so disk space is only
+	 * used for the parts of the table which are written to.
+	 *
+	 * \param path Path of the file to create. Any existing file is overwritten.
+	 * \param capacity Number of positions the store should have room for. The table is sized so
+	 * that it's at most 3/4 full when holding this many positions.
+	 * \return Store opened for writing.
+	 * \throw std::system_error if the file can't be created.
+	 */
+	static Analysis_store create(const std::filesystem::path& path, uint64_t capacity);
+
+	/**
+	 * Open an existing store.
+	 *
+	 * \param path Path of the store file.
+	 * \param access Whether to open the store for reading or writing.
+	 * \throw std::system_error if the file can't be opened, or if another process already has
+	 * it open for writing.
+	 * \throw std::runtime_error if the file isn't a valid store.
+	 */
+	Analysis_store(const std::filesystem::path& path, Access access);
+	~Analysis_store();
+
+	Analysis_store(Analysis_store&& other) noexcept;
+	Analysis_store& operator=(Analysis_store&& other) noexcept;
+	Analysis_store(const Analysis_store&) = delete;
+	Analysis_store& operator=(const Analysis_store&) = delete;
+
+	/**
+	 * Add the analysis of a position.
+	 *
+	 * \param fen Position in Forsyth-Edwards Notation.
+	 * \param depth Depth the position was analyzed to.
+	 * \param lines Best lines from the position, best line first. Only the first max_lines lines
+	 * are stored.
+	 * \return true if the analysis was added, false if the position was already in the store or the
+	 * store is full.
+	 * \throw std::logic_error if the store isn't open for writing.
+	 */
+	bool insert(std::string_view fen, uint16_t depth, const std::vector<Analyzed_line>& lines);
+
+	/**
+	 * Look up the analysis of a position.
+	 *
+	 * \param fen Position in Forsyth-Edwards Notation.
+	 * \return Stored analysis, or nullopt if the position isn't in the store.
+	 */
+	std::optional<Stored_analysis> find(std::string_view fen) const;
+
+	/// Number of positions in the store.
+	uint64_t size() const;
+	/// Number of slots in the hash table.
+	uint64_t num_slots() const;
+
+	/// Write changes to disk, instead of waiting for the operating system to do so.
+	void flush();
+
+private:
+	struct Header;
+	struct Slot;
+
+	Analysis_store() = default;
+	/// Map the opened file into memory and validate it.
+	void map(Access access);
+	void close();
+
+	Header* header() const;
+	Slot* slots() const;
+
+	int fd_{-1};
+	void* mapping_{nullptr};
+	size_t mapping_size_{0};
+	Access access_{Access::read_only};
+};
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,76 @@
+#include "Convergence.h"
+
+#include <cstdlib>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+bool is_bound(const Evaluation& evaluation)
+{
+	return evaluation.centi_pawns_lower_bound.has_value() || evaluation.centi_pawns_upper_bound.has_value();
+}
+
+/// Whether or not the score has changed by at most the given number of centi pawns.
+bool is_stable_score(const Evaluation& previous, const Evaluation& current, int max_score_change)
+{
+	if (previous.centi_pawns.has_value() && current.centi_pawns.has_value())
+		return std::abs(*current.centi_pawns - *previous.centi_pawns) <= max_score_change;
+	if (previous.white_can_mate_in.has_value() && current.white_can_mate_in.has_value())
+		return *previous.white_can_mate_in == *current.white_can_mate_in;
+	if (previous.black_can_mate_in.has_value() && current.black_can_mate_in.has_value())
+		return *previous.black_can_mate_in == *current.black_can_mate_in;
+	return false;
+}
+
+} // Anonymous namespace
+
+Convergence_tracker::Convergence_tracker(const Convergence_policy& policy)
+	: policy_(policy)
+{}
+
+bool Convergence_tracker::update(const Info& info)
+{
+	if (has_converged_)
+		return true;
+	// Only follow the best line, and only messages which describe it completely
+	if (info.line_index.value_or(0) != 0 || !info.depth.has_value() || !info.evaluation.has_value())
+		return false;
+	if (!info.sequence_of_moves.has_value() || info.sequence_of_moves->empty())
+		return false;
+
+	const Evaluation& evaluation = *info.evaluation;
+	if (is_bound(evaluation)) {
+		// The engine is re-searching, so the score isn't settled. Start over with the next exact score.
+		num_stable_depths_ = 0;
+		best_move_.reset();
+		return false;
+	}
+	const std::string& move = info.sequence_of_moves->front();
+	bool is_stable = best_move_.has_value() && move == *best_move_ && is_stable_score(evaluation_, evaluation, policy_.max_score_change);
+	if (!is_stable)
+		num_stable_depths_ = 1;
+	else if (*info.depth > depth_)
+		num_stable_depths_ += 1;
+	best_move_ = move;
+	evaluation_ = evaluation;
+	if (*info.depth > depth_)
+		depth_ = *info.depth;
+
+	has_converged_ = num_stable_depths_ >= policy_.stable_depths && depth_ >= policy_.min_depth;
+	return has_converged_;
+}
+
+bool Convergence_tracker::has_converged() const
+{
+	return has_converged_;
+}
+
+unsigned Convergence_tracker::num_stable_depths() const
+{
+	return num_stable_depths_;
+}
+
+} // namespace uci
+} // namespace chess
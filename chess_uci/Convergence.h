@@ -0,0 +1,75 @@
+/**
+ * \file Convergence.h
+ * \brief Contains a policy for stopping engine calculations early once their result has converged.
+ */
+
+#pragma once
+
+#include "Evaluation.h"
+#include "Parse_messages.h"
+
+#include <optional>
+#include <string>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \struct Convergence_policy
+ * \brief Thresholds for when the result of a calculation is considered stable enough to stop.
+ *
+ * The result has converged when the best move has stayed the same, and its score has changed by
+ * at most max_score_change between consecutive depths, for stable_depths depths in a row, and the
+ * search has reached at least min_depth.
+ */
+struct Convergence_policy
+{
+	/// Minimum search depth in plies before the calculation may be stopped.
+	unsigned min_depth{10};
+	/// Number of consecutive depths with the same best move, including the latest one.
+	unsigned stable_depths{5};
+	/// Maximum change in centi pawns of the score of the best move from one depth to the next.
+	/// Mate scores are only considered stable if they're unchanged.
+	int max_score_change{15};
+};
+
+/**
+ * \class Convergence_tracker
+ * \brief Follows the info messages of a calculation, and tells when its result has converged
+ * according to a Convergence_policy.
+ *
+ * Only the best line (the first multipv slot) is followed. Scores which are only bounds, as sent
+ * while the engine re-searches a move whose score has changed a lot, count as unstable.
+ */
+class Convergence_tracker
+{
+public:
+	explicit Convergence_tracker(const Convergence_policy& policy = Convergence_policy());
+
+	/**
+	 * Take an info message of the calculation into account.
+	 *
+	 * \param info Info message sent by the engine.
+	 * \return Whether or not the result has converged. Once it has, it stays converged.
+	 */
+	bool update(const Info& info);
+
+	/// Whether or not the result has converged.
+	bool has_converged() const;
+	/// Number of consecutive depths the best move has been stable for so far.
+	unsigned num_stable_depths() const;
+
+private:
+	Convergence_policy policy_;
+	/// Deepest depth seen so far.
+	unsigned depth_{0};
+	/// First move of the latest best line.
+	std::optional<std::string> best_move_;
+	/// Score of the latest best line.
+	Evaluation evaluation_;
+	unsigned num_stable_depths_{0};
+	bool has_converged_{false};
+};
+
+} // namespace uci
+} // namespace chess
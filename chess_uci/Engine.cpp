@@ -1,168 +1,744 @@
 #include "Engine.h"
 
+#include "Line_reader.h"
 #include "Parse_messages.h"
+#include "Process_reaper.h"
 #include "Read_messages.h"
+#include "Sigpipe_guard.h"
 
 #include <boost/process.hpp>
 
-#include <cassert>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
 
 namespace chess {
 namespace uci {
 
-struct Engine_process_manager
+namespace {
+
+bool equal_ignoring_case(std::string_view lhs, std::string_view rhs)
 {
-	Engine_process_manager(const std::filesystem::path& engine_executable)
-		: engine_child_process_(engine_executable.string(), boost::process::std_out > engine_to_host_, boost::process::std_in < host_to_engine_)
-	{}
+	return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char a, char b) {
+		return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+	});
+}
+
+/// Check that the given value is valid for the given option, and throw std::invalid_argument if not.
+void validate_option_value(const Engine_option& option, const std::string& value)
+{
+	auto invalid = [&](const std::string& reason) {
+		return std::invalid_argument("Engine error: Invalid value '" + value + "' for option " + option.name + ": " + reason);
+	};
+	if (value.find_first_of("\r\n") != std::string::npos)
+		throw invalid("Values can't contain line breaks");
+
+	switch (option.type) {
+	case Engine_option::Type::check:
+		if (value != "true" && value != "false")
+			throw invalid("Expected true or false");
+		break;
+	case Engine_option::Type::spin: {
+		int64_t number = 0;
+		auto result = std::from_chars(value.data(), value.data() + value.size(), number);
+		if (value.empty() || result.ec != std::errc() || result.ptr != value.data() + value.size())
+			throw invalid("Expected an integer");
+		if ((option.min.has_value() && number < *option.min) || (option.max.has_value() && number > *option.max))
+			throw invalid("Out of range");
+		break;
+	}
+	case Engine_option::Type::combo: {
+		bool is_allowed = std::any_of(option.values.begin(), option.values.end(), [&value](const std::string& allowed) {
+			return equal_ignoring_case(allowed, value);
+		});
+		if (!is_allowed)
+			throw invalid("Not one of the allowed values");
+		break;
+	}
+	case Engine_option::Type::button:
+		if (!value.empty())
+			throw invalid("Button options have no value");
+		break;
+	case Engine_option::Type::string:
+		break;
+	}
+}
+
+/// No deadline, i.e. wait for as long as it takes.
+constexpr std::chrono::steady_clock::time_point no_deadline = std::chrono::steady_clock::time_point::max();
 
-	/// Stream which the engine writes it's messages to.
-	boost::process::pstream engine_to_host_;
+/// Get the deadline for something that should be done within the given time from now, if any.
+std::chrono::steady_clock::time_point deadline_after(std::optional<std::chrono::milliseconds> timeout)
+{
+	if (!timeout.has_value())
+		return no_deadline;
+	return std::chrono::steady_clock::now() + *timeout;
+}
+
+int64_t now_since_epoch()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // Anonymous namespace
+
+/**
+ * \struct Engine_connection
+ * \brief Connection to a running engine: where to write commands and read replies (pimpl).
+ */
+struct Engine_connection
+{
+	virtual ~Engine_connection() = default;
+
+	/// Stream to write commands to the engine to.
+	virtual std::ostream& commands() = 0;
+	/// Reader for the messages the engine writes.
+	virtual Line_reader& replies() = 0;
+	/**
+	 * Ask the engine to quit, and close the connection for writing. The connection is closed
+	 * completely when it's destroyed.
+	 */
+	virtual void quit() = 0;
+	/// Cut off the engine right away. Its output then ends, which wakes up anyone reading it.
+	virtual void kill() = 0;
+
+	/// When the engine was started or connected to.
+	std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+};
+
+namespace {
+
+/// Connection to an engine running in a child process, through its standard input and output.
+struct Process_connection : Engine_connection
+{
+	Process_connection(const std::filesystem::path& engine_executable)
+		: engine_child_process_(engine_executable.string(), boost::process::std_out > engine_to_host_pipe_, boost::process::std_in < host_to_engine_)
+		, engine_to_host_(engine_to_host_pipe_.native_source())
+	{
+		// Boost closes our copy of the engine's end of the pipe when the process has been started,
+		// so make sure that the pipe doesn't close it again
+		engine_to_host_pipe_.assign_sink(-1);
+	}
+
+	std::ostream& commands() override
+	{
+		return host_to_engine_;
+	}
+
+	Line_reader& replies() override
+	{
+		return engine_to_host_;
+	}
+
+	/// Also hands the process over to the reaper, which kills it if it doesn't exit in time.
+	void quit() override
+	{
+		{
+			// The engine may already have exited
+			Sigpipe_guard sigpipe_guard;
+			host_to_engine_ << "quit\n"
+							<< std::flush;
+			// Close the pipe, so that the engine sees the end of its input. This also drops anything
+			// which couldn't be written, which the stream would otherwise try to write again when
+			// it's destroyed.
+			host_to_engine_.pipe().close();
+		}
+		Process_reaper::instance().reap(std::move(engine_child_process_), Process_reaper::default_timeout);
+	}
+
+	void kill() override
+	{
+		Process_reaper::kill(engine_child_process_);
+	}
+
+	/// Pipe which the engine writes it's messages to.
+	boost::process::pipe engine_to_host_pipe_;
 	/// Stream which the engine reads commands from.
 	boost::process::pstream host_to_engine_;
 
 	/// Child process running the engine.
 	boost::process::child engine_child_process_;
+
+	/// Reader for the messages the engine writes to engine_to_host_pipe_.
+	Line_reader engine_to_host_;
+};
+
+/**
+ * Connection to an engine served on a socket, e.g. by Engine_server.
+ *
+ * The engine process belongs to the server, so killing the engine only cuts the connection. The
+ * server is expected to stop the engine when its connection ends.
+ */
+struct Socket_connection : Engine_connection
+{
+	Socket_connection(const Engine_endpoint& endpoint)
+		: host_to_engine_(boost::process::pipe(-1, connect_to(endpoint)))
+		, socket_(host_to_engine_.pipe().native_sink())
+		, engine_to_host_(socket_)
+	{}
+
+	~Socket_connection() override
+	{
+		// Close the socket without writing anything left in the stream, as for Process_connection
+		host_to_engine_.pipe().close();
+	}
+
+	std::ostream& commands() override
+	{
+		return host_to_engine_;
+	}
+
+	Line_reader& replies() override
+	{
+		return engine_to_host_;
+	}
+
+	void quit() override
+	{
+		Sigpipe_guard sigpipe_guard;
+		host_to_engine_ << "quit\n"
+						<< std::flush;
+		// Let the engine see the end of its input, while its last messages can still be read
+		::shutdown(socket_, SHUT_WR);
+	}
+
+	void kill() override
+	{
+		::shutdown(socket_, SHUT_RDWR);
+	}
+
+	/// Stream writing commands to the socket. Owns the socket.
+	boost::process::opstream host_to_engine_;
+	/// Connected socket.
+	int socket_;
+	/// Reader for the messages the engine writes to the socket.
+	Line_reader engine_to_host_;
 };
 
-Engine::Engine(const std::filesystem::path& engine_executable, uint8_t num_best_lines, std::optional<uint16_t> max_elo_rating)
-	: engine_process(std::make_unique<Engine_process_manager>(engine_executable))
-	, num_best_lines_(num_best_lines)
+std::unique_ptr<Engine_connection> connect_to_engine(const Engine_endpoint& endpoint)
+{
+	if (endpoint.kind == Engine_endpoint::Kind::process)
+		return std::make_unique<Process_connection>(endpoint.location);
+	return std::make_unique<Socket_connection>(endpoint);
+}
+
+} // Anonymous namespace
+
+Engine::Engine(
+	const Engine_endpoint& endpoint,
+	uint8_t num_best_lines,
+	std::optional<uint16_t> max_elo_rating,
+	std::optional<std::chrono::milliseconds> startup_timeout)
+	: Engine(Connect_only(), endpoint, num_best_lines)
+{
+	finish_startup(max_elo_rating, deadline_after(startup_timeout));
+}
+
+Engine::Engine(Connect_only, const Engine_endpoint& endpoint, uint8_t num_best_lines)
+	: num_best_lines_(num_best_lines)
+{
+	// Make sure that the reaper outlives the engine, also when both are static
+	Process_reaper::instance();
+	engine_connection = connect_to_engine(endpoint);
+	// Tell engine to use UCI. If the engine exits right away, that's reported as a missing reply
+	// rather than ending the program.
+	Sigpipe_guard sigpipe_guard;
+	engine_connection->commands() << "uci\n"
+								  << std::flush;
+}
+
+std::vector<std::unique_ptr<Engine>> Engine::start_engines(
+	const Engine_endpoint& endpoint,
+	size_t num_engines,
+	uint8_t num_best_lines,
+	std::optional<uint16_t> max_elo_rating,
+	std::optional<std::chrono::milliseconds> startup_timeout)
+{
+	auto deadline = deadline_after(startup_timeout);
+	// Start all processes first, so that the engines start up in parallel while we wait for each in turn
+	std::vector<std::unique_ptr<Engine>> engines;
+	engines.reserve(num_engines);
+	for (size_t i = 0; i < num_engines; ++i)
+		engines.push_back(std::unique_ptr<Engine>(new Engine(Connect_only(), endpoint, num_best_lines)));
+	for (auto& engine : engines)
+		engine->finish_startup(max_elo_rating, deadline);
+	return engines;
+}
+
+void Engine::finish_startup(std::optional<uint16_t> max_elo_rating, std::chrono::steady_clock::time_point deadline)
 {
-	// Tell engine to use UCI
-	engine_process->host_to_engine_ << "uci\n"
-									<< std::flush;
 	// Wait for uciok reply
-	auto replies = read_uci_replies(engine_process->engine_to_host_);
+	auto uci_replies = read_uci_replies(engine_connection->replies(), deadline);
+	if (!uci_replies.has_value()) {
+		kill_unresponsive();
+		throw std::runtime_error("Engine error: Engine did not send the 'uciok' message in time");
+	}
+	const std::vector<std::string>& replies = *uci_replies;
 	if (replies.empty())
 		throw std::runtime_error("Engine error: Engine did not send the 'uciok' message");
 	if (replies.back() != "uciok")
 		throw std::runtime_error("Engine error: Unexpected engine message. Expected 'uciok', got " + replies.back() + ".");
-	// Set multi pv setting
-	engine_process->host_to_engine_ << "setoption name MultiPV value " << (int)num_best_lines << "\n"
-									<< std::flush;
+	for (const std::string& reply : replies) {
+		metrics_.count_line(reply);
+		try {
+			if (auto option = parse_option(reply))
+				options_.push_back(std::move(*option));
+		} catch (const std::runtime_error&) {
+			// Leave out options we don't understand, rather than refusing to use the engine
+		}
+	}
+	// Set multi pv setting. The options are sent together with the following isready command.
+	engine_connection->commands() << "setoption name MultiPV value " << (int)num_best_lines_ << "\n";
 	// Set max ELO rating
 	if (max_elo_rating.has_value()) {
-		engine_process->host_to_engine_ << "setoption name UCI_LimitStrength value true\n"
-										<< std::flush;
-		engine_process->host_to_engine_ << "setoption name UCI_Elo value " << *max_elo_rating << "\n"
-										<< std::flush;
+		engine_connection->commands() << "setoption name UCI_LimitStrength value true\n";
+		engine_connection->commands() << "setoption name UCI_Elo value " << *max_elo_rating << "\n";
 	}
 
-	// Send isready command and wait for reply
-	engine_process->host_to_engine_ << "isready\n"
-									<< std::flush;
-	replies = read_isready_replies(engine_process->engine_to_host_);
-	if (replies.empty())
-		throw std::runtime_error("Engine error: Engine did not send the 'isready' message");
-	if (replies.back() != "readyok")
-		throw std::runtime_error("Engine error: Unexpected engine message. Expected 'readyok', got " + replies.back() + ".");
+	if (!wait_until_ready(deadline))
+		throw std::runtime_error("Engine error: Engine did not send the 'readyok' message in time");
+	metrics_.startup_time.record(std::chrono::steady_clock::now() - engine_connection->start_time_);
 }
 
 Engine ::~Engine()
-{}
+{
+	// Make sure that the thread reading the engine output has finished
+	try {
+		stop_calculating();
+	} catch (...) {
+		// Nothing sensible to do with engine errors at this point
+	}
+	engine_connection->quit();
+}
 
 void Engine::reset_game()
+{
+	new_game();
+}
+
+void Engine::setup_game_from_fen(const std::string& fen)
+{
+	new_game();
+	set_position_from_fen(fen);
+}
+
+void Engine::setup_game_from_moves(const std::string& lan)
+{
+	new_game();
+	set_position_from_moves(lan);
+}
+
+void Engine::new_game()
 {
 	// Stop any running calculation
 	stop_calculating();
 	// Stored game continuations are no longer valid
 	suggested_lines_.clear();
-	// Reset game state in engine
-	engine_process->host_to_engine_ << "ucinewgame\n"
-									<< std::flush;
-	engine_process->host_to_engine_ << "position startpos\n"
-									<< std::flush;
+	best_move_.reset();
+	// Reset game state in engine. The engine may spend some time clearing its hash tables etc,
+	// so wait until it's ready.
+	engine_connection->commands() << "ucinewgame\n";
+	position_base_ = "startpos";
+	position_moves_.clear();
+	send_position();
+	wait_until_ready();
+}
 
-	// Send isready command and wait for reply
-	engine_process->host_to_engine_ << "isready\n"
-									<< std::flush;
-	auto replies = read_isready_replies(engine_process->engine_to_host_);
-	if (replies.empty())
-		throw std::runtime_error("Engine error: Engine did not send the 'readyok' message");
-	if (replies.back() != "readyok")
-		throw std::runtime_error("Engine error: Unexpected engine message. Expected 'readyok', got " + replies.back() + ".");
+void Engine::set_position_from_fen(const std::string& fen, const std::string& lan)
+{
+	position_base_ = "fen " + fen;
+	position_moves_ = lan;
+	change_position();
 }
 
-void Engine::setup_game_from_fen(const std::string& fen)
+void Engine::set_position_from_moves(const std::string& lan)
+{
+	position_base_ = "startpos";
+	position_moves_ = lan;
+	change_position();
+}
+
+void Engine::play_moves(const std::string& lan)
+{
+	if (lan.empty())
+		return;
+	if (!position_moves_.empty())
+		position_moves_ += ' ';
+	position_moves_ += lan;
+	change_position();
+}
+
+void Engine::change_position()
 {
 	// Stop any running calculation
 	stop_calculating();
 	// Stored game continuations are no longer valid
 	suggested_lines_.clear();
-	// Update game state in engine
-	engine_process->host_to_engine_ << "ucinewgame\n"
-									<< std::flush;
-	engine_process->host_to_engine_ << "position fen " << fen << "\n"
-									<< std::flush;
+	best_move_.reset();
+	stopped_early_ = false;
+	send_position();
+}
 
-	// Send isready command and wait for reply
-	engine_process->host_to_engine_ << "isready\n"
-									<< std::flush;
-	auto replies = read_isready_replies(engine_process->engine_to_host_);
-	if (replies.empty())
-		throw std::runtime_error("Engine error: Engine did not send the 'readyok' message");
-	if (replies.back() != "readyok")
-		throw std::runtime_error("Engine error: Unexpected engine message. Expected 'readyok', got " + replies.back() + ".");
+void Engine::send_position()
+{
+	// The engine doesn't reply to the position command, so it's not flushed. Instead it's sent
+	// together with the next command which needs a reply, typically go.
+	engine_connection->commands() << "position " << position_base_;
+	if (!position_moves_.empty())
+		engine_connection->commands() << " moves " << position_moves_;
+	engine_connection->commands() << "\n";
 }
 
-void Engine::setup_game_from_moves(const std::string& lan)
+const std::vector<Engine_option>& Engine::get_options() const
 {
-	// Stop any running calculation
+	return options_;
+}
+
+const Engine_option* Engine::find_option(std::string_view name) const
+{
+	auto it = std::find_if(options_.begin(), options_.end(), [name](const Engine_option& option) {
+		return equal_ignoring_case(option.name, name);
+	});
+	return it == options_.end() ? nullptr : &*it;
+}
+
+void Engine::set_option(std::string_view name, const std::string& value)
+{
+	const Engine_option* option = find_option(name);
+	if (option == nullptr)
+		throw std::invalid_argument("Engine error: Engine has no option named " + std::string(name));
+	validate_option_value(*option, value);
+
+	// Options can only be changed while the engine isn't calculating
 	stop_calculating();
-	// Stored game continuations are no longer valid
-	suggested_lines_.clear();
-	// Update game state in engine
-	engine_process->host_to_engine_ << "ucinewgame\n"
-									<< std::flush;
-	engine_process->host_to_engine_ << "position startpos moves " << lan << "\n"
-									<< std::flush;
+	engine_connection->commands() << "setoption name " << option->name;
+	if (option->type != Engine_option::Type::button)
+		engine_connection->commands() << " value " << value;
+	engine_connection->commands() << "\n";
+}
+
+void Engine::set_threads(unsigned num_threads)
+{
+	set_option("Threads", std::to_string(num_threads));
+}
+
+void Engine::set_hash_size(unsigned megabytes)
+{
+	set_option("Hash", std::to_string(megabytes));
+}
+
+void Engine::wait_until_ready()
+{
+	wait_until_ready(no_deadline);
+}
 
+bool Engine::wait_until_ready(std::chrono::steady_clock::time_point deadline)
+{
+	check_not_killed();
 	// Send isready command and wait for reply
-	engine_process->host_to_engine_ << "isready\n"
-									<< std::flush;
-	auto replies = read_isready_replies(engine_process->engine_to_host_);
+	auto start = std::chrono::steady_clock::now();
+	send_command("isready");
+	auto isready_replies = read_isready_replies(engine_connection->replies(), deadline);
+	if (!isready_replies.has_value()) {
+		kill_unresponsive();
+		return false;
+	}
+	const std::vector<std::string>& replies = *isready_replies;
+	metrics_.ready_latency.record(std::chrono::steady_clock::now() - start);
+	for (const std::string& reply : replies)
+		metrics_.count_line(reply);
 	if (replies.empty())
 		throw std::runtime_error("Engine error: Engine did not send the 'readyok' message");
 	if (replies.back() != "readyok")
 		throw std::runtime_error("Engine error: Unexpected engine message. Expected 'readyok', got " + replies.back() + ".");
+	return true;
 }
 
 void Engine::start_calculating(
 	std::optional<std::chrono::seconds> max_calculation_time)
 {
+	if (max_calculation_time.has_value())
+		start_calculating(Search_limits::for_move_time(*max_calculation_time));
+	else
+		start_calculating(Search_limits::infinite_search());
+}
+
+void Engine::start_calculating(const Search_limits& limits)
+{
+	start_calculating(limits, nullptr);
+}
+
+void Engine::start_calculating(const Search_limits& limits, Completion_callback on_completion)
+{
+	check_not_killed();
 	// Stop any running calculation
 	stop_calculating();
 
 	// Send go command to engine
-	engine_process->host_to_engine_ << "go ";
-	if (max_calculation_time.has_value()) {
-		engine_process->host_to_engine_ << "movetime " << std::chrono::milliseconds(*max_calculation_time).count() << "\n"
-										<< std::flush;
-	} else {
-		engine_process->host_to_engine_ << "infinite\n"
-										<< std::flush;
-	}
+	search_start_ = std::chrono::steady_clock::now();
+	stop_sent_ = 0;
+	send_command(to_go_command(limits));
 
 	// Keep track of the fact that we have started a calculation (whose output we need to manage before any other calculation can be started)
 	is_calculating_ = true;
+	is_finite_calculation_ = limits.is_finite();
+
+	// Process engine output as it arrives
+	search_lines_.assign(num_best_lines_, Analyzed_line());
+	search_best_move_.reset();
+	search_error_ = nullptr;
+	search_has_info_ = false;
+	search_nodes_ = 0;
+	search_finished_ = false;
+	// Pondering must go on until the opponent has moved, however settled the result is
+	if (convergence_policy_.has_value() && !limits.ponder)
+		search_convergence_.emplace(*convergence_policy_);
+	else
+		search_convergence_.reset();
+	search_stopped_early_ = false;
+	uint64_t calculation = search_snapshot_.calculation + 1;
+	search_snapshot_ = Live_snapshot();
+	search_snapshot_.calculation = calculation;
+	search_snapshot_.is_calculating = true;
+	search_snapshot_.num_lines = static_cast<uint8_t>(std::min<size_t>(num_best_lines_, Live_snapshot::max_lines));
+	live_snapshot_.store(search_snapshot_);
+	completion_callback_ = std::move(on_completion);
+	search_reader_ = std::thread([this]() {
+		read_search_messages();
+	});
 }
 
 void Engine::stop_calculating()
 {
+	ponder_move_.reset();
 	if (!is_calculating_)
 		// No calculation started
 		return;
 
-	// Send stop calculating command to the engine
-	engine_process->host_to_engine_ << "stop\n"
-									<< std::flush;
-	// Read go replies
-	auto messages = read_go_replies(engine_process->engine_to_host_);
-	// Parse engine messages
-	parse_engine_go_messages(messages);
+	// Send stop calculating command to the engine. If the engine has already sent its best move
+	// it ignores the command.
+	stop_sent_ = now_since_epoch();
+	send_command("stop");
+	finish_calculation();
+}
+
+const std::vector<Analyzed_line>& Engine::wait_for_result()
+{
+	if (!is_calculating_)
+		return suggested_lines_;
+	if (!is_finite_calculation_)
+		throw std::logic_error("Engine error: Can't wait for the result of a calculation without limits");
+
+	finish_calculation();
+	return suggested_lines_;
+}
+
+Engine::Wait_status Engine::wait_for_result(std::chrono::steady_clock::time_point deadline, std::chrono::milliseconds stop_margin)
+{
+	if (!is_calculating_)
+		return Wait_status::finished;
+
+	Wait_status status = Wait_status::finished;
+	if (!wait_for_search_reader(deadline - stop_margin)) {
+		// Leave the engine time to send its best move before the deadline
+		ponder_move_.reset();
+		request_stop();
+		status = Wait_status::stopped;
+		if (!wait_for_search_reader(deadline)) {
+			kill_unresponsive();
+			return Wait_status::timed_out;
+		}
+	}
+	finish_calculation();
+	return status;
+}
+
+std::future<std::vector<Analyzed_line>> Engine::analyze(const std::string& fen, const Search_limits& limits)
+{
+	set_position_from_fen(fen);
+	auto promise = std::make_shared<std::promise<std::vector<Analyzed_line>>>();
+	auto future = promise->get_future();
+	start_calculating(limits, [promise](const std::vector<Analyzed_line>& lines, std::exception_ptr error) {
+		if (error)
+			promise->set_exception(error);
+		else
+			promise->set_value(lines);
+	});
+	return future;
+}
+
+void Engine::request_stop()
+{
+	// Engines ignore stop when they aren't calculating, so there's no need to check. A killed
+	// engine can't take any commands, though.
+	if (was_killed_)
+		return;
+	int64_t not_sent = 0;
+	stop_sent_.compare_exchange_strong(not_sent, now_since_epoch());
+	send_command("stop");
+}
+
+void Engine::finish_calculation()
+{
+	// Wait for the remaining go replies to be processed. The reader finishes when the engine sends its best move.
+	join_search_reader();
 	// Set is calculating flag
 	is_calculating_ = false;
+	if (search_error_)
+		std::rethrow_exception(search_error_);
+
+	suggested_lines_ = std::move(search_lines_);
+	best_move_ = std::move(search_best_move_);
+	stopped_early_ = search_stopped_early_;
+}
+
+void Engine::send_command(std::string_view command)
+{
+	std::lock_guard<std::mutex> lock(write_mutex_);
+	// An engine which has exited shows up as missing replies, rather than ending the program
+	Sigpipe_guard sigpipe_guard;
+	engine_connection->commands() << command << "\n"
+								  << std::flush;
+}
+
+void Engine::join_search_reader()
+{
+	if (search_reader_.get_id() == std::this_thread::get_id())
+		// Called from the completion callback, which is the last thing the reader does, so it
+		// finishes as soon as the callback returns
+		search_reader_.detach();
+	else
+		search_reader_.join();
+}
+
+bool Engine::wait_for_search_reader(std::chrono::steady_clock::time_point deadline)
+{
+	std::unique_lock<std::mutex> lock(search_mutex_);
+	return search_finished_changed_.wait_until(lock, deadline, [this]() {
+		return search_finished_;
+	});
+}
+
+void Engine::kill_unresponsive()
+{
+	count_timeout();
+	was_killed_ = true;
+	engine_connection->kill();
+	if (is_calculating_) {
+		// The engine output has ended, so the reader finishes right away. Its results (or the
+		// error from the output ending) are of no use.
+		join_search_reader();
+		is_calculating_ = false;
+		search_error_ = nullptr;
+	}
+	ponder_move_.reset();
+	suggested_lines_.clear();
+	best_move_.reset();
+}
+
+void Engine::check_not_killed() const
+{
+	if (was_killed_)
+		throw std::runtime_error("Engine error: The engine was killed after not replying in time");
+}
+
+void Engine::start_pondering(const std::string& expected_move, const Search_limits& limits)
+{
+	if (!ponder_option_sent_) {
+		// Sent before the position, while the engine isn't calculating
+		stop_calculating();
+		engine_connection->commands() << "setoption name Ponder value true\n";
+		ponder_option_sent_ = true;
+	}
+
+	size_t position_moves_before_ponder = position_moves_.size();
+	play_moves(expected_move);
+	Search_limits ponder_limits = limits;
+	ponder_limits.ponder = true;
+	start_calculating(ponder_limits);
+
+	ponder_move_ = expected_move;
+	ponder_limits_ = limits;
+	ponder_limits_.ponder = false;
+	position_moves_before_ponder_ = position_moves_before_ponder;
+	ponder_start_ = std::chrono::steady_clock::now();
+}
+
+void Engine::start_pondering(const Search_limits& limits)
+{
+	if (!best_move_.has_value() || !best_move_->ponder.has_value())
+		throw std::logic_error("Engine error: The last calculation didn't give a move to ponder on");
+
+	Best_move best_move = *best_move_;
+	play_moves(best_move.move);
+	start_pondering(*best_move.ponder, limits);
+}
+
+void Engine::opponent_moved(const std::string& move)
+{
+	if (!ponder_move_.has_value())
+		throw std::logic_error("Engine error: Opponent moved while not pondering");
+
+	if (move == *ponder_move_) {
+		// The engine has been calculating on the right position all along, so let it carry on
+		send_command("ponderhit");
+		ponder_move_.reset();
+		is_finite_calculation_ = ponder_limits_.is_finite();
+		ponder_statistics_.hits += 1;
+		ponder_statistics_.time_saved += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ponder_start_);
+		return;
+	}
+
+	// Throw away the calculation on the expected position, and start over on the actual one
+	ponder_statistics_.misses += 1;
+	stop_calculating();
+	position_moves_.resize(position_moves_before_ponder_);
+	play_moves(move);
+	start_calculating(ponder_limits_);
+}
+
+bool Engine::is_pondering() const
+{
+	return ponder_move_.has_value();
+}
+
+const Engine::Ponder_statistics& Engine::get_ponder_statistics() const
+{
+	return ponder_statistics_;
+}
+
+Metrics_snapshot Engine::get_metrics() const
+{
+	return metrics_.snapshot();
+}
+
+void Engine::count_timeout()
+{
+	metrics_.timeouts.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool Engine::was_killed() const
+{
+	return was_killed_;
+}
+
+void Engine::set_convergence_policy(std::optional<Convergence_policy> policy)
+{
+	convergence_policy_ = std::move(policy);
+}
+
+bool Engine::stopped_early() const
+{
+	return stopped_early_;
+}
+
+double Engine::Ponder_statistics::hit_rate() const
+{
+	uint64_t total = hits + misses;
+	return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
 }
 
 Evaluation Engine::get_evaluation() const
@@ -178,29 +754,123 @@ const std::vector<Analyzed_line>& Engine::get_top_suggested_move_sequences() con
 	return suggested_lines_;
 }
 
-void Engine::parse_engine_go_messages(const std::vector<std::string>& messages)
+const std::optional<Best_move>& Engine::get_best_move() const
+{
+	return best_move_;
+}
+
+void Engine::set_info_callback(Info_callback callback)
+{
+	info_callback_ = std::move(callback);
+}
+
+void Engine::read_search_messages()
 {
-	suggested_lines_.resize(num_best_lines_);
+	try {
+		std::string best_move = read_go_replies(engine_connection->replies(), [this](std::string_view message) {
+			process_go_message(message);
+		});
+		auto end = std::chrono::steady_clock::now();
+		metrics_.count_line(best_move);
+		metrics_.search_time.record(end - search_start_);
+		if (int64_t stop_sent = stop_sent_.load(); stop_sent != 0)
+			metrics_.stop_latency.record(std::chrono::nanoseconds(now_since_epoch() - stop_sent));
+		metrics_.searches_completed.fetch_add(1, std::memory_order_relaxed);
+		if (search_stopped_early_)
+			metrics_.searches_stopped_early.fetch_add(1, std::memory_order_relaxed);
+		metrics_.nodes_searched.fetch_add(search_nodes_, std::memory_order_relaxed);
+		search_best_move_ = parse_bestmove(best_move);
+		// Drop trailing lines that the engine never reported, e.g. when there are fewer legal moves than requested lines
+		while (!search_lines_.empty() && search_lines_.back().moves.empty())
+			search_lines_.pop_back();
+	} catch (...) {
+		search_error_ = std::current_exception();
+	}
+	search_snapshot_.is_calculating = false;
+	search_snapshot_.stopped_early = search_stopped_early_;
+	live_snapshot_.store(search_snapshot_);
 
-	assert(messages.size() >= num_best_lines_ + 1);
+	{
+		std::lock_guard<std::mutex> lock(search_mutex_);
+		search_finished_ = true;
+	}
+	search_finished_changed_.notify_all();
 
-	// Only read the last num_best_lines_ info messages
-	size_t idx = messages.size() - 1;
-	size_t info_messages_read = 0;
-	while (info_messages_read < num_best_lines_) {
-		if (messages[idx].substr(0, 4) == "info") {
-			Info info = parse_info(messages[idx]);
+	// Report the result last, since the callback may go on to use (or even destroy) the engine
+	if (completion_callback_) {
+		Completion_callback callback = std::move(completion_callback_);
+		completion_callback_ = nullptr;
+		callback(search_lines_, search_error_);
+	}
+}
 
-			assert(info.evaluation.has_value());
-			assert(info.line_index.has_value());
-			assert(info.sequence_of_moves.has_value());
+void Engine::process_go_message(std::string_view message)
+{
+	metrics_.count_line(message);
+	if (!is_search_info_message(message))
+		return;
 
-			suggested_lines_[*info.line_index].evaluation = *info.evaluation;
-			suggested_lines_[*info.line_index].moves = std::move(*info.sequence_of_moves);
-			info_messages_read += 1;
+	auto parse_start = std::chrono::steady_clock::now();
+	Info info = parse_info(message);
+	auto parse_end = std::chrono::steady_clock::now();
+	metrics_.parse_time.record(parse_end - parse_start);
+	if (!search_has_info_) {
+		metrics_.first_info_latency.record(parse_start - search_start_);
+		search_has_info_ = true;
+	}
+	if (info.nodes.has_value())
+		search_nodes_ = *info.nodes;
+	if (info.nodes_per_second.has_value())
+		metrics_.nodes_per_second.store(*info.nodes_per_second, std::memory_order_relaxed);
+	if (info_callback_)
+		info_callback_(info);
+	if (search_convergence_.has_value() && search_convergence_->update(info) && !search_stopped_early_) {
+		// Stop, unless someone else already has, so that the engine doesn't spend the rest of its
+		// time confirming what it already knows
+		int64_t not_sent = 0;
+		if (stop_sent_.compare_exchange_strong(not_sent, now_since_epoch())) {
+			search_stopped_early_ = true;
+			send_command("stop");
 		}
-		idx -= 1;
 	}
+	update_live_snapshot(info);
+	update_lines(search_lines_, info);
+}
+
+void Engine::update_live_snapshot(const Info& info)
+{
+	Live_snapshot& snapshot = search_snapshot_;
+	if (info.depth.has_value())
+		snapshot.depth = static_cast<uint16_t>(*info.depth);
+	if (info.selective_depth.has_value())
+		snapshot.selective_depth = static_cast<uint16_t>(*info.selective_depth);
+	if (info.hash_full.has_value())
+		snapshot.hash_full = static_cast<uint16_t>(*info.hash_full);
+	if (info.nodes.has_value())
+		snapshot.nodes = *info.nodes;
+	if (info.nodes_per_second.has_value())
+		snapshot.nodes_per_second = *info.nodes_per_second;
+	if (info.time.has_value())
+		snapshot.time = std::chrono::milliseconds(*info.time);
+	size_t line_index = info.line_index.value_or(0);
+	if (info.evaluation.has_value() && info.sequence_of_moves.has_value() && line_index < snapshot.num_lines) {
+		Live_line& line = snapshot.lines[line_index];
+		try {
+			line.moves = Move_sequence::from_strings(*info.sequence_of_moves);
+		} catch (const std::runtime_error&) {
+			// The snapshot is only for showing progress, so a line we can't pack isn't worth failing for
+			line.moves.clear();
+		}
+		line.evaluation = Packed_evaluation(*info.evaluation);
+		line.depth = snapshot.depth;
+	}
+	snapshot.num_updates += 1;
+	live_snapshot_.store(snapshot);
+}
+
+Live_snapshot Engine::get_live_snapshot() const
+{
+	return live_snapshot_.load();
 }
 
 } // namespace uci
@@ -5,20 +5,36 @@
 
 #pragma once
 
+#include "Convergence.h"
+#include "Engine_endpoint.h"
+#include "Engine_metrics.h"
 #include "Evaluation.h"
 #include "Line.h"
+#include "Live_snapshot.h"
+#include "Parse_messages.h"
+#include "Search_limits.h"
+#include "Seqlock.h"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 namespace chess {
 namespace uci {
 
 // Forward declaration
-struct Engine_process_manager;
+struct Engine_connection;
 
 /**
  * \class Engine
@@ -27,31 +43,115 @@ struct Engine_process_manager;
  *
  * Usage:
  * 1. Create Engine object with path to the chess engine to run. This will start the engine in a child process.
+ *    To use an engine served on a Unix domain socket or TCP port instead (see Engine_server), give
+ *    an Engine_endpoint for the socket.
  * 2. Setup game using reset_game() (to start from the beginning) or setup_game() (to start from a specific position).
+ *    To analyze several positions from the same game, change the position using set_position_from_fen(),
+ *    set_position_from_moves() or play_moves() instead. These don't tell the engine that a new game has
+ *    started, so the engine can reuse what it learned from the previous positions (e.g. its hash table).
  * 3. Call start_calculating() to tell the engine to start calculating, and then (at some later time) call
- *    stop_calculating() to stop the engine calculation and process the engine output.
+ *    stop_calculating() to stop the engine calculation and process the engine output. If the calculation
+ *    has a limit (see Search_limits), call wait_for_result() instead to wait until the engine has finished.
+ *    To not block the calling thread, use analyze() to get a future, or co_analyze() (see Engine_coroutines.h)
+ *    from a C++20 coroutine.
+ *    While the engine is calculating its output is processed as it arrives, and info messages are
+ *    passed to the callback given to set_info_callback(), if any. The latest lines can also be
+ *    polled from any thread with get_live_snapshot().
  * 4. Call evaluation() or get_top_suggested_move_sequences() to get output from the engine calculation.
+ *    To calculate on the opponent's time, call start_pondering() after playing a move, and then
+ *    opponent_moved() when the opponent has replied.
  * 5. Repeat 2-4 at will.
- * 6. Destroy the Engine object. This will stop the engine child process.
+ * 6. Destroy the Engine object. This tells the engine to quit, and lets the child process exit in the
+ *    background (see Process_reaper).
+ *
+ * To start many engines at once, use start_engines(), which lets the engines start up in parallel.
+ *
+ * To not wait forever for an engine which has hung, use the variants of wait_until_ready() and
+ * wait_for_result() which take a deadline. An engine which doesn't reply in time is killed, after
+ * which it can't be used any more (see was_killed()) and should be replaced. For an engine served on a
+ * socket, killing it only cuts the connection, and the server stops the engine.
  */
 class Engine
 {
 public:
+	/// Function called with each info message the engine sends while calculating.
+	using Info_callback = std::function<void(const Info&)>;
+	/**
+	 * Function called when a calculation has finished, with the top suggested lines (only valid
+	 * during the call) or the error that occurred while reading the engine output.
+	 */
+	using Completion_callback = std::function<void(const std::vector<Analyzed_line>& lines, std::exception_ptr error)>;
+
+	/// Counters for how often pondering has paid off.
+	struct Ponder_statistics
+	{
+		/// Number of times the opponent played the move the engine pondered on.
+		uint64_t hits{0};
+		/// Number of times the opponent played another move, and the engine had to start over.
+		uint64_t misses{0};
+		/// Total time the engine had been pondering when the opponent played the expected move,
+		/// i.e. the calculation time gained by pondering.
+		std::chrono::microseconds time_saved{0};
+
+		/// Fraction of the pondered moves which were hits, or 0 if there have been none.
+		double hit_rate() const;
+	};
+
+	/// Outcome of waiting for a calculation with a deadline.
+	enum class Wait_status
+	{
+		/// The engine finished calculating by itself.
+		finished,
+		/// The engine was told to stop before the deadline, and sent the best move it had found.
+		stopped,
+		/// The engine didn't send its best move even after it was told to stop, and has been killed.
+		timed_out
+	};
+
 	/**
-	 * \param engine_executable Path to the engine executable.
-	 * Executable will be started in a subprocess and shut down
-	 * when the Engine object is destroyed.
+	 * \param endpoint Engine to use. An engine executable (or a path to one, which converts to an
+	 * endpoint) will be started in a subprocess and shut down when the Engine object is destroyed.
+	 * An engine served on a socket (e.g. by the engine_host tool) is connected to, and the
+	 * connection is closed when the Engine object is destroyed.
 	 * \param num_best_lines Number of best lines to suggest.
 	 * \param max_elo_rating Max ELO rating the engine is allowed to play at.
 	 * If not specified there is no such limit.
+	 * \param startup_timeout Maximum time the engine may take to start up and get ready. If not
+	 * specified there is no such limit.
+	 * \throw std::runtime_error if the engine fails to start, or (after killing it) if it doesn't get
+	 * ready in time.
 	 */
 	Engine(
-		const std::filesystem::path& engine_executable,
+		const Engine_endpoint& endpoint,
 		uint8_t num_best_lines = 1,
-		std::optional<uint16_t> max_elo_rating = std::nullopt);
+		std::optional<uint16_t> max_elo_rating = std::nullopt,
+		std::optional<std::chrono::milliseconds> startup_timeout = std::nullopt);
 	~Engine();
 
+	/**
+	 * Start a number of engines at the same time.
+	 *
+	 * All engine processes are started before waiting for any of them, so the engines start up in
+	 * parallel and the total time is about that of the slowest engine, rather than the sum.
+	 *
+	 * \param endpoint Engine to use (see Engine()).
+	 * \param num_engines Number of engines to start.
+	 * \param num_best_lines Number of best lines each engine should suggest.
+	 * \param max_elo_rating Max ELO rating the engines are allowed to play at, if any.
+	 * \param startup_timeout Maximum time all engines together may take to start up and get ready, if any.
+	 * \return The started engines, ready for use.
+	 * \throw std::runtime_error if any engine fails to start or doesn't get ready in time. The other
+	 * engines are then stopped.
+	 */
+	static std::vector<std::unique_ptr<Engine>> start_engines(
+		const Engine_endpoint& endpoint,
+		size_t num_engines,
+		uint8_t num_best_lines = 1,
+		std::optional<uint16_t> max_elo_rating = std::nullopt,
+		std::optional<std::chrono::milliseconds> startup_timeout = std::nullopt);
+
 	/// Reset the chess game to the starting position.
+	/// Same as new_game().
 	void reset_game();
 	/**
 	 * Set game to the given state.
@@ -67,6 +167,93 @@ public:
 	 */
 	void setup_game_from_moves(const std::string& lan);
 
+	/**
+	 * Tell the engine that a new game starts, and set the game to the starting position.
+	 *
+	 * Engines typically clear their hash tables when a new game starts, so this should only be
+	 * called when the following positions are unrelated to the previous ones.
+	 */
+	void new_game();
+	/**
+	 * Set game to the given state, within the current game.
+	 *
+	 * Unlike setup_game_from_fen() this doesn't start a new game, so the engine keeps its hash table.
+	 *
+	 * \param fen Chess game state specified as a Forsyth-Edwards Notation (FEN) string.
+	 * \param lan String of moves in long algebraic notation to play from the given state.
+	 */
+	void set_position_from_fen(const std::string& fen, const std::string& lan = "");
+	/**
+	 * Set game to the state after playing the given moves from the starting position, within the current game.
+	 *
+	 * Unlike setup_game_from_moves() this doesn't start a new game, so the engine keeps its hash table.
+	 *
+	 * \param lan String of moves in long algebraic notation.
+	 */
+	void set_position_from_moves(const std::string& lan);
+	/**
+	 * Play the given moves from the current game state.
+	 *
+	 * \param lan String of moves in long algebraic notation.
+	 */
+	void play_moves(const std::string& lan);
+
+	/// Get the options the engine supports, in the order the engine listed them.
+	const std::vector<Engine_option>& get_options() const;
+	/**
+	 * Find an option the engine supports.
+	 *
+	 * \param name Name of the option. Option names aren't case sensitive.
+	 * \return The option, or nullptr if the engine doesn't support it.
+	 */
+	const Engine_option* find_option(std::string_view name) const;
+	/**
+	 * Set an engine option.
+	 *
+	 * Stops any running calculation. Like position changes, the option is sent together with the
+	 * next command that starts a calculation or needs a reply.
+	 *
+	 * \param name Name of the option (see get_options()).
+	 * \param value New value of the option. Should be empty for button options, which just trigger an
+	 * action in the engine.
+	 * \throw std::invalid_argument if the engine doesn't support the option, or if the value isn't
+	 * valid for the option (e.g. out of range).
+	 */
+	void set_option(std::string_view name, const std::string& value = "");
+	/**
+	 * Set the number of search threads the engine uses (the 'Threads' option).
+	 *
+	 * \throw std::invalid_argument if the engine doesn't support the number of threads.
+	 */
+	void set_threads(unsigned num_threads);
+	/**
+	 * Set the size of the engine hash table in megabytes (the 'Hash' option).
+	 *
+	 * \throw std::invalid_argument if the engine doesn't support the hash size.
+	 */
+	void set_hash_size(unsigned megabytes);
+
+	/**
+	 * Wait until the engine has processed all commands sent to it so far.
+	 *
+	 * Commands which the engine doesn't reply to (e.g. position changes) are buffered and sent
+	 * together with the next command that starts a calculation or needs a reply, and the engine
+	 * is only asked whether it's ready when a new game starts. This sends the isready command
+	 * and waits for the reply, for when an explicit synchronization point is needed.
+	 */
+	void wait_until_ready();
+	/**
+	 * Wait until the engine has processed all commands sent to it so far, or until the deadline has passed.
+	 *
+	 * Same as wait_until_ready(), but an engine which doesn't reply in time is considered hung and is
+	 * killed (see was_killed()).
+	 *
+	 * \param deadline When to give up waiting for the engine.
+	 * \return Whether or not the engine replied in time.
+	 * \throw std::runtime_error if the engine has already been killed.
+	 */
+	bool wait_until_ready(std::chrono::steady_clock::time_point deadline);
+
 	/**
 	 * Start calculating from the current position.
 	 *
@@ -80,8 +267,160 @@ public:
 	 * will calculate until stop_calculating is called.
 	 */
 	void start_calculating(std::optional<std::chrono::seconds> max_calculation_time = std::nullopt);
+	/**
+	 * Start calculating from the current position, with the given limits.
+	 *
+	 * Note: Should not be called while the engine is already calculating, see start_calculating() above.
+	 *
+	 * \param limits Limits for the calculation. The engine stops calculating by itself when any of
+	 * the limits is reached.
+	 */
+	void start_calculating(const Search_limits& limits);
+	/**
+	 * Start calculating from the current position, with the given limits, and call the given
+	 * function when the calculation has finished.
+	 *
+	 * The callback is called from the background thread reading the engine output, as soon as the
+	 * engine has sent its best move, so the calling thread is free to do other things meanwhile.
+	 * The results are also available from get_top_suggested_move_sequences() after a following call
+	 * to wait_for_result() or stop_calculating().
+	 *
+	 * The callback may use the engine (e.g. to start another calculation, or by resuming a
+	 * coroutine which does) if it's not called before this function has returned.
+	 *
+	 * \param limits Limits for the calculation.
+	 * \param on_completion Function to call when the calculation has finished.
+	 */
+	void start_calculating(const Search_limits& limits, Completion_callback on_completion);
+	/**
+	 * Analyze a position asynchronously.
+	 *
+	 * Sets the position within the current game (see set_position_from_fen()) and starts
+	 * calculating, without waiting for the engine to finish.
+	 *
+	 * \param fen Position to analyze, specified as a Forsyth-Edwards Notation (FEN) string.
+	 * \param limits Limits for the calculation. If the calculation has no limit it runs until
+	 * stopped by request_stop() or stop_calculating().
+	 * \return Future holding the top suggested lines, or the error that occurred while reading the
+	 * engine output.
+	 */
+	std::future<std::vector<Analyzed_line>> analyze(const std::string& fen, const Search_limits& limits);
 	/// Tell the engine to stop calculating.
 	void stop_calculating();
+	/**
+	 * Wait until the engine has finished calculating by itself, and process the engine output.
+	 *
+	 * Returns as soon as the engine sends its best move, so no time is lost waiting for a fixed
+	 * time. Does nothing if no calculation has been started.
+	 *
+	 * \return Top suggested lines, see get_top_suggested_move_sequences().
+	 * \throw std::logic_error if the calculation has no limit (see Search_limits::is_finite()), since
+	 * the engine would then never finish.
+	 */
+	const std::vector<Analyzed_line>& wait_for_result();
+	/**
+	 * Wait until the engine has finished calculating, or until the deadline has passed, and process
+	 * the engine output.
+	 *
+	 * Doesn't block past the deadline. If the engine hasn't finished by itself shortly before the
+	 * deadline it's told to stop, so that its best move so far is available in time. If it doesn't
+	 * send its best move by the deadline even then, it's considered hung and is killed (see
+	 * was_killed()). Unlike wait_for_result() this can also be used for calculations without limits.
+	 *
+	 * \param deadline When the result is needed.
+	 * \param stop_margin Time before the deadline at which the engine is told to stop. Should cover
+	 * the time the engine needs to send its best move after being told to stop.
+	 * \return Whether the engine finished by itself, was stopped or was killed. The top suggested
+	 * lines (see get_top_suggested_move_sequences()) are only available if it wasn't killed.
+	 */
+	Wait_status wait_for_result(
+		std::chrono::steady_clock::time_point deadline,
+		std::chrono::milliseconds stop_margin = std::chrono::milliseconds(50));
+	/**
+	 * Tell the engine to stop calculating, without waiting for it to finish.
+	 *
+	 * The engine then sends its best move, which completes the running calculation. Unlike the
+	 * other member functions this may be called from any thread, e.g. to cancel an analysis, as
+	 * long as the thread owning the engine is only waiting for the calculation to finish.
+	 */
+	void request_stop();
+
+	/**
+	 * Stop calculations early once their result has converged.
+	 *
+	 * The info messages of each calculation are followed by a Convergence_tracker, and the engine is
+	 * told to stop as soon as the best move and its score have been stable for long enough, rather
+	 * than using all of its time (or calculating until told to stop). Whether a calculation was
+	 * stopped early is reported by stopped_early(). Pondering is never stopped early.
+	 * Should not be called while the engine is calculating.
+	 *
+	 * \param policy Thresholds for when the result is stable, or nullopt to let calculations run
+	 * until their limits as usual.
+	 */
+	void set_convergence_policy(std::optional<Convergence_policy> policy);
+	/**
+	 * Whether or not the last finished calculation was stopped early since its result had converged
+	 * (see set_convergence_policy()).
+	 */
+	bool stopped_early() const;
+
+	/**
+	 * Ponder on the expected reply from the opponent, i.e. calculate on the opponent's time.
+	 *
+	 * Plays the given move and calculates on the resulting position. Call opponent_moved() when the
+	 * opponent has replied, which either lets the engine carry on (if the opponent played the
+	 * expected move) or restarts the calculation on the actual position.
+	 *
+	 * \param expected_move Move the opponent is expected to play, in long algebraic notation.
+	 * Should be played from the current position, which should have the opponent to move.
+	 * \param limits Limits for the calculation once the opponent has moved. Time limits only
+	 * start to count then.
+	 */
+	void start_pondering(const std::string& expected_move, const Search_limits& limits);
+	/**
+	 * Play the best move from the last calculation, and ponder on the reply the engine expects.
+	 *
+	 * \param limits Limits for the calculation once the opponent has moved.
+	 * \throw std::logic_error if the last calculation didn't give both a best move and a ponder
+	 * move (see get_best_move()).
+	 */
+	void start_pondering(const Search_limits& limits);
+	/**
+	 * Tell the pondering engine which move the opponent played.
+	 *
+	 * If it's the move the engine has been pondering on the engine carries on calculating (with
+	 * the limits given to start_pondering()). Otherwise the engine is stopped, the move is played
+	 * instead of the expected one, and a new calculation is started. In both cases the result is
+	 * then collected as usual, e.g. with wait_for_result().
+	 *
+	 * \param move Move the opponent played, in long algebraic notation.
+	 * \throw std::logic_error if the engine isn't pondering.
+	 */
+	void opponent_moved(const std::string& move);
+	/// Whether or not the engine is pondering, waiting for opponent_moved().
+	bool is_pondering() const;
+	/// Get counters for how often pondering has paid off.
+	const Ponder_statistics& get_ponder_statistics() const;
+
+	/**
+	 * Get the latency and throughput metrics of the communication with the engine.
+	 *
+	 * Can be called from any thread, also while the engine is calculating.
+	 */
+	Metrics_snapshot get_metrics() const;
+	/**
+	 * Count a reply from the engine which didn't arrive in time.
+	 *
+	 * Used by code which waits for the engine with a deadline, so that timeouts are counted
+	 * together with the other metrics of the engine.
+	 */
+	void count_timeout();
+	/**
+	 * Whether or not the engine has been killed after not replying in time.
+	 *
+	 * A killed engine can't calculate any more, so it should be replaced by a new Engine.
+	 */
+	bool was_killed() const;
 
 	/**
 	 * Get evaluation of the current game position.
@@ -103,19 +442,159 @@ public:
 	 */
 	const std::vector<Analyzed_line>& get_top_suggested_move_sequences() const;
 
+	/**
+	 * Get the best move from the last finished calculation, together with the reply the engine
+	 * expects from the opponent if any.
+	 *
+	 * \return The best move, or nullopt if no calculation has finished since the position was changed.
+	 */
+	const std::optional<Best_move>& get_best_move() const;
+
+	/**
+	 * Get the progress of the running calculation, or the result of the last one.
+	 *
+	 * The snapshot is updated by the thread reading the engine output as each info message arrives.
+	 * Unlike the other member functions this can be called from any thread at any time, e.g. by a
+	 * user interface polling for the current best lines. It never waits for the engine, nor takes any
+	 * lock, so frequent polling doesn't slow down the processing of the engine output.
+	 */
+	Live_snapshot get_live_snapshot() const;
+
+	/**
+	 * Set a function to be called with each info message the engine sends while calculating.
+	 *
+	 * The callback is called from a background thread reading the engine output, as soon as each
+	 * message has been received, so it can be used to show the progress of a long calculation.
+	 * It should return quickly, since the engine output isn't read while it runs.
+	 * Should not be called while the engine is calculating.
+	 *
+	 * \param callback Function to call for each info message, or an empty function to stop
+	 * receiving info messages.
+	 */
+	void set_info_callback(Info_callback callback);
+
 private:
-	/// Parse engine messages received after the previous go command.
-	void parse_engine_go_messages(const std::vector<std::string>& messages);
+	/// Used to select the constructor which only starts (or connects to) the engine.
+	struct Connect_only
+	{};
+
+	/// Start (or connect to) the engine and send the uci command, without waiting for the reply.
+	Engine(Connect_only, const Engine_endpoint& endpoint, uint8_t num_best_lines);
+	/// Wait for the reply to the uci command, and set up the engine. An engine which isn't ready by
+	/// the deadline is killed.
+	void finish_startup(std::optional<uint16_t> max_elo_rating, std::chrono::steady_clock::time_point deadline);
+	/// Kill an engine which didn't reply in time, and abandon any running calculation.
+	void kill_unresponsive();
+	/// Throw std::runtime_error if the engine has been killed.
+	void check_not_killed() const;
 
-	/// Struct managing the engine process and inter process communication (pimpl).
-	std::unique_ptr<Engine_process_manager> engine_process;
+	/// Stop any calculation and send the current position to the engine.
+	void change_position();
+	/// Send the current position to the engine.
+	void send_position();
+
+	/// Wait for the thread reading the engine output to finish, and store the results.
+	void finish_calculation();
+	/// Send a command, together with any buffered commands, to the engine. Can be called from any thread.
+	void send_command(std::string_view command);
+	/// Wait for (or let go of) the thread reading the engine output.
+	void join_search_reader();
+	/// Wait until the thread reading the engine output has read the best move (or failed), or until
+	/// the deadline has passed. Returns whether or not it has finished.
+	bool wait_for_search_reader(std::chrono::steady_clock::time_point deadline);
+
+	/// Read and process engine messages after a go command, until the engine sends its best move.
+	/// Runs in search_reader_.
+	void read_search_messages();
+	/// Process a single engine message received after a go command.
+	void process_go_message(std::string_view message);
+	/// Update the live snapshot of the running calculation with an info message.
+	void update_live_snapshot(const Info& info);
+
+	/// Connection to the engine process, or to the socket it's served on (pimpl).
+	std::unique_ptr<Engine_connection> engine_connection;
 
 	/// Number of best lines the engine should calculate.
 	uint8_t num_best_lines_{1};
+	/// Options the engine supports.
+	std::vector<Engine_option> options_;
 	/// Whether or not we have a started engine calculation, whose output has not yet been processed.
 	bool is_calculating_{false};
+	/// Whether or not the started calculation ends by itself.
+	bool is_finite_calculation_{false};
+	/// Whether or not the engine has been killed after not replying in time. Read by request_stop()
+	/// from any thread.
+	std::atomic<bool> was_killed_{false};
 	/// Top suggested lines from the last engine calculation.
 	std::vector<Analyzed_line> suggested_lines_;
+	/// Best move from the last engine calculation.
+	std::optional<Best_move> best_move_;
+	/// Whether or not the last engine calculation was stopped early since its result had converged.
+	bool stopped_early_{false};
+	/// Policy for stopping calculations early, if any.
+	std::optional<Convergence_policy> convergence_policy_;
+	/// Serializes commands sent from the thread owning the engine, search_reader_ and request_stop().
+	std::mutex write_mutex_;
+
+	/// Game state the moves in position_moves_ are played from, as given to the position command
+	/// ('startpos' or 'fen <fen>').
+	std::string position_base_{"startpos"};
+	/// Moves played from position_base_ in long algebraic notation, separated by spaces.
+	std::string position_moves_;
+
+	/// Thread reading the engine output while the engine is calculating.
+	std::thread search_reader_;
+	/// Latest line for each multipv slot in the running calculation. Only accessed by search_reader_
+	/// until it has been joined.
+	std::vector<Analyzed_line> search_lines_;
+	/// Best move of the running calculation, once the engine has sent it.
+	std::optional<Best_move> search_best_move_;
+	/// Error that occurred while reading the output of the running calculation, if any.
+	std::exception_ptr search_error_;
+	/// Protects search_finished_.
+	std::mutex search_mutex_;
+	/// Notified when search_reader_ has finished reading the output of the running calculation.
+	std::condition_variable search_finished_changed_;
+	/// Whether or not search_reader_ has finished reading the output of the running calculation.
+	bool search_finished_{false};
+	/// When the running calculation was started.
+	std::chrono::steady_clock::time_point search_start_;
+	/// When stop was sent for the running calculation, in nanoseconds since the steady clock
+	/// epoch, or 0 if it hasn't been sent. Set from any thread and read by search_reader_.
+	std::atomic<int64_t> stop_sent_{0};
+	/// Whether or not search_reader_ has seen an info message with search results.
+	bool search_has_info_{false};
+	/// Latest number of nodes reported in the running calculation. Only accessed by search_reader_.
+	uint64_t search_nodes_{0};
+	/// Follows whether the result of the running calculation has converged, if it may be stopped
+	/// early. Only accessed by search_reader_.
+	std::optional<Convergence_tracker> search_convergence_;
+	/// Whether or not the running calculation has been stopped early. Only accessed by
+	/// search_reader_ until it has been joined.
+	bool search_stopped_early_{false};
+	/// Progress of the running calculation, as last published to live_snapshot_. Only accessed by
+	/// the thread driving the calculation, i.e. search_reader_ while it runs.
+	Live_snapshot search_snapshot_;
+	/// Progress of the running calculation, readable from any thread.
+	Seqlock<Live_snapshot> live_snapshot_;
+	/// Function called with each info message from the engine.
+	Info_callback info_callback_;
+	/// Function called when the running calculation has finished, if any.
+	Completion_callback completion_callback_;
+
+	/// Move the engine is pondering on, while pondering.
+	std::optional<std::string> ponder_move_;
+	/// Limits for the calculation once the opponent has moved.
+	Search_limits ponder_limits_;
+	/// Length of position_moves_ before the pondered move was played.
+	size_t position_moves_before_ponder_{0};
+	/// When pondering started.
+	std::chrono::steady_clock::time_point ponder_start_;
+	/// Whether or not the engine has been told to take pondering into account in its time management.
+	bool ponder_option_sent_{false};
+	Ponder_statistics ponder_statistics_;
+
+	Engine_metrics metrics_;
 };
 
 } // namespace uci
@@ -0,0 +1,127 @@
+/**
+ * \file Engine_coroutines.h
+ * \brief Contains a C++20 awaitable for analyzing positions with an engine from a coroutine.
+ *
+ * Unlike the rest of the library this header needs C++20, so that it can be used from C++20 code
+ * while the library itself is built as C++17.
+ */
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>) || !__has_include(<stop_token>)
+#error "Engine_coroutines.h requires C++20 coroutines"
+#endif
+
+#include "Engine.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Analysis_awaiter
+ * \brief Awaitable analysis of a position, see co_analyze().
+ */
+class Analysis_awaiter
+{
+public:
+	Analysis_awaiter(Engine& engine, std::string fen, Search_limits limits, std::stop_token stop_token)
+		: engine_(engine)
+		, fen_(std::move(fen))
+		, limits_(std::move(limits))
+		, stop_token_(std::move(stop_token))
+	{}
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	bool await_suspend(std::coroutine_handle<> handle)
+	{
+		if (stop_token_.stop_requested())
+			// Cancelled before the analysis was started
+			return false;
+
+		engine_.set_position_from_fen(fen_);
+		engine_.start_calculating(limits_, [this, handle](const std::vector<Analyzed_line>& lines, std::exception_ptr error) {
+			lines_ = lines;
+			error_ = error;
+			// Only resume the coroutine if await_suspend() has already returned, otherwise it's
+			// resumed by await_suspend() returning false
+			if (finished_or_suspended_.exchange(true))
+				handle.resume();
+		});
+		stop_callback_.emplace(stop_token_, Stop_request{engine_});
+		return !finished_or_suspended_.exchange(true);
+	}
+
+	std::vector<Analyzed_line> await_resume()
+	{
+		// Waits for the stop request to finish if it's running, so that it's not sent after
+		// the coroutine has gone on to use the engine
+		stop_callback_.reset();
+		if (error_)
+			std::rethrow_exception(error_);
+		return std::move(lines_);
+	}
+
+private:
+	/// Cancels the analysis.
+	struct Stop_request
+	{
+		Engine& engine;
+
+		void operator()() const
+		{
+			engine.request_stop();
+		}
+	};
+
+	Engine& engine_;
+	std::string fen_;
+	Search_limits limits_;
+	std::stop_token stop_token_;
+	std::optional<std::stop_callback<Stop_request>> stop_callback_;
+
+	/// Set by whichever of the completion callback and await_suspend() comes last.
+	std::atomic<bool> finished_or_suspended_{false};
+	std::vector<Analyzed_line> lines_;
+	std::exception_ptr error_;
+};
+
+/**
+ * Analyze a position from a coroutine, without blocking the thread running the coroutine.
+ *
+ * Usage:
+ *     std::vector<Analyzed_line> lines = co_await co_analyze(engine, fen, Search_limits::for_depth(20));
+ *
+ * The position is set within the current game (see Engine::set_position_from_fen()). If the engine
+ * finishes right away the coroutine simply continues, otherwise it's resumed on the thread reading
+ * the engine output as soon as the engine has sent its best move.
+ *
+ * Requesting a stop through the stop token tells the engine to stop calculating, after which the
+ * coroutine is resumed with the lines calculated so far. If the stop is requested before the
+ * analysis has started, no analysis is started and the result is empty.
+ *
+ * \param engine Engine to use. Must not be used by anything else until the coroutine is resumed.
+ * \param fen Position to analyze, specified as a Forsyth-Edwards Notation (FEN) string.
+ * \param limits Limits for the calculation. Without a limit the analysis runs until stopped.
+ * \param stop_token Token used to cancel the analysis.
+ * \return Awaitable whose result is the top suggested lines for the position.
+ */
+inline Analysis_awaiter co_analyze(Engine& engine, std::string fen, Search_limits limits, std::stop_token stop_token = {})
+{
+	return Analysis_awaiter(engine, std::move(fen), std::move(limits), std::move(stop_token));
+}
+
+} // namespace uci
+} // namespace chess
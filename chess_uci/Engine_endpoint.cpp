@@ -0,0 +1,272 @@
+#include "Engine_endpoint.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+auto as_tuple(const Engine_endpoint& endpoint)
+{
+	return std::tie(endpoint.kind, endpoint.location, endpoint.port);
+}
+
+std::runtime_error socket_error(const std::string& what, const Engine_endpoint& endpoint, int error)
+{
+	return std::runtime_error("Engine error: " + what + " " + to_string(endpoint) + ": " + std::strerror(error));
+}
+
+/// Closes a socket unless released.
+class Socket_guard
+{
+public:
+	explicit Socket_guard(int fd)
+		: fd_(fd)
+	{}
+	~Socket_guard()
+	{
+		if (fd_ >= 0)
+			::close(fd_);
+	}
+	Socket_guard(const Socket_guard&) = delete;
+	Socket_guard& operator=(const Socket_guard&) = delete;
+
+	int get() const
+	{
+		return fd_;
+	}
+
+	int release()
+	{
+		int fd = fd_;
+		fd_ = -1;
+		return fd;
+	}
+
+private:
+	int fd_;
+};
+
+sockaddr_un unix_address(const Engine_endpoint& endpoint)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (endpoint.location.size() >= sizeof(address.sun_path))
+		throw std::invalid_argument("Engine error: Socket path too long: " + endpoint.location);
+	std::memcpy(address.sun_path, endpoint.location.c_str(), endpoint.location.size() + 1);
+	return address;
+}
+
+/// Look up the addresses of a TCP endpoint. The result should be freed with freeaddrinfo().
+addrinfo* tcp_addresses(const Engine_endpoint& endpoint, bool passive)
+{
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (passive)
+		hints.ai_flags = AI_PASSIVE;
+	addrinfo* addresses = nullptr;
+	std::string port = std::to_string(endpoint.port);
+	const char* host = endpoint.location.empty() ? nullptr : endpoint.location.c_str();
+	int result = ::getaddrinfo(host, port.c_str(), &hints, &addresses);
+	if (result != 0)
+		throw std::runtime_error("Engine error: Can't look up " + to_string(endpoint) + ": " + ::gai_strerror(result));
+	return addresses;
+}
+
+void check_socket_endpoint(const Engine_endpoint& endpoint)
+{
+	if (endpoint.kind == Engine_endpoint::Kind::process)
+		throw std::invalid_argument("Engine error: Not a socket endpoint: " + to_string(endpoint));
+}
+
+} // Anonymous namespace
+
+Engine_endpoint::Engine_endpoint(const std::filesystem::path& engine_executable)
+	: location(engine_executable.string())
+{}
+
+Engine_endpoint::Engine_endpoint(const std::string& engine_executable)
+	: location(engine_executable)
+{}
+
+Engine_endpoint::Engine_endpoint(const char* engine_executable)
+	: location(engine_executable)
+{}
+
+Engine_endpoint Engine_endpoint::unix_socket(const std::filesystem::path& socket_path)
+{
+	Engine_endpoint endpoint;
+	endpoint.kind = Kind::unix_socket;
+	endpoint.location = socket_path.string();
+	return endpoint;
+}
+
+Engine_endpoint Engine_endpoint::tcp(const std::string& host, uint16_t port)
+{
+	Engine_endpoint endpoint;
+	endpoint.kind = Kind::tcp;
+	endpoint.location = host;
+	endpoint.port = port;
+	return endpoint;
+}
+
+Engine_endpoint Engine_endpoint::parse(std::string_view text)
+{
+	if (text.substr(0, 5) == "unix:") {
+		if (text.size() == 5)
+			throw std::invalid_argument("Engine error: Missing socket path in " + std::string(text));
+		return unix_socket(std::string(text.substr(5)));
+	}
+	if (text.substr(0, 4) != "tcp:")
+		return Engine_endpoint(std::string(text));
+
+	std::string_view address = text.substr(4);
+	size_t colon = address.rfind(':');
+	if (colon == std::string_view::npos)
+		throw std::invalid_argument("Engine error: Missing port in " + std::string(text));
+	std::string_view host = address.substr(0, colon);
+	if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+		host = host.substr(1, host.size() - 2);
+	std::string_view port_text = address.substr(colon + 1);
+	uint16_t port = 0;
+	auto result = std::from_chars(port_text.data(), port_text.data() + port_text.size(), port);
+	if (port_text.empty() || result.ec != std::errc() || result.ptr != port_text.data() + port_text.size())
+		throw std::invalid_argument("Engine error: Invalid port in " + std::string(text));
+	return tcp(std::string(host), port);
+}
+
+bool operator==(const Engine_endpoint& lhs, const Engine_endpoint& rhs)
+{
+	return as_tuple(lhs) == as_tuple(rhs);
+}
+
+bool operator!=(const Engine_endpoint& lhs, const Engine_endpoint& rhs)
+{
+	return !(lhs == rhs);
+}
+
+std::string to_string(const Engine_endpoint& endpoint)
+{
+	switch (endpoint.kind) {
+	case Engine_endpoint::Kind::unix_socket:
+		return "unix:" + endpoint.location;
+	case Engine_endpoint::Kind::tcp:
+		if (endpoint.location.find(':') != std::string::npos)
+			return "tcp:[" + endpoint.location + "]:" + std::to_string(endpoint.port);
+		return "tcp:" + endpoint.location + ":" + std::to_string(endpoint.port);
+	case Engine_endpoint::Kind::process:
+		break;
+	}
+	return endpoint.location;
+}
+
+int connect_to(const Engine_endpoint& endpoint)
+{
+	check_socket_endpoint(endpoint);
+	if (endpoint.kind == Engine_endpoint::Kind::unix_socket) {
+		sockaddr_un address = unix_address(endpoint);
+		Socket_guard socket(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+		if (socket.get() < 0 || ::connect(socket.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+			throw socket_error("Can't connect to", endpoint, errno);
+		return socket.release();
+	}
+
+	addrinfo* addresses = tcp_addresses(endpoint, false);
+	int error = 0;
+	int connected = -1;
+	for (addrinfo* address = addresses; address != nullptr && connected < 0; address = address->ai_next) {
+		Socket_guard socket(::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol));
+		if (socket.get() < 0 || ::connect(socket.get(), address->ai_addr, address->ai_addrlen) < 0) {
+			error = errno;
+			continue;
+		}
+		int no_delay = 1;
+		::setsockopt(socket.get(), IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+		connected = socket.release();
+	}
+	::freeaddrinfo(addresses);
+	if (connected < 0)
+		throw socket_error("Can't connect to", endpoint, error);
+	return connected;
+}
+
+int listen_on(const Engine_endpoint& endpoint)
+{
+	check_socket_endpoint(endpoint);
+	constexpr int backlog = 64;
+	if (endpoint.kind == Engine_endpoint::Kind::unix_socket) {
+		sockaddr_un address = unix_address(endpoint);
+		// A socket file left behind by an earlier server would make bind fail
+		::unlink(endpoint.location.c_str());
+		Socket_guard socket(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+		int fd = socket.get();
+		if (fd < 0 || ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd, backlog) < 0)
+			throw socket_error("Can't listen on", endpoint, errno);
+		return socket.release();
+	}
+
+	addrinfo* addresses = tcp_addresses(endpoint, true);
+	int error = 0;
+	int listening = -1;
+	for (addrinfo* address = addresses; address != nullptr && listening < 0; address = address->ai_next) {
+		Socket_guard socket(::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol));
+		int fd = socket.get();
+		if (fd < 0) {
+			error = errno;
+			continue;
+		}
+		int reuse = 1;
+		::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		if (::bind(fd, address->ai_addr, address->ai_addrlen) < 0 || ::listen(fd, backlog) < 0) {
+			error = errno;
+			continue;
+		}
+		listening = socket.release();
+	}
+	::freeaddrinfo(addresses);
+	if (listening < 0)
+		throw socket_error("Can't listen on", endpoint, error);
+	return listening;
+}
+
+Engine_endpoint local_endpoint(int socket)
+{
+	sockaddr_storage address{};
+	socklen_t length = sizeof(address);
+	if (::getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) < 0)
+		throw std::runtime_error(std::string("Engine error: Can't get socket address: ") + std::strerror(errno));
+
+	char host[INET6_ADDRSTRLEN] = {};
+	switch (address.ss_family) {
+	case AF_UNIX:
+		return Engine_endpoint::unix_socket(reinterpret_cast<const sockaddr_un&>(address).sun_path);
+	case AF_INET: {
+		const auto& ipv4 = reinterpret_cast<const sockaddr_in&>(address);
+		::inet_ntop(AF_INET, &ipv4.sin_addr, host, sizeof(host));
+		return Engine_endpoint::tcp(host, ntohs(ipv4.sin_port));
+	}
+	case AF_INET6: {
+		const auto& ipv6 = reinterpret_cast<const sockaddr_in6&>(address);
+		::inet_ntop(AF_INET6, &ipv6.sin6_addr, host, sizeof(host));
+		return Engine_endpoint::tcp(host, ntohs(ipv6.sin6_port));
+	}
+	}
+	throw std::runtime_error("Engine error: Unknown socket address family");
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,109 @@
+/**
+ * \file Engine_endpoint.h
+ * \brief Contains where to find a UCI chess engine: an executable to run, or a socket where an
+ * engine is served (e.g. by the engine_host tool).
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \struct Engine_endpoint
+ * \brief Where to find an engine.
+ *
+ * An engine is either run as a child process of this program, communicating through its standard
+ * input and output, or served on a Unix domain socket or TCP port, e.g. by Engine_server on
+ * another machine. The UCI communication is the same in all cases.
+ *
+ * Converts implicitly from an executable path, so that functions taking an endpoint can be given
+ * the path of an engine to run, as before.
+ */
+struct Engine_endpoint
+{
+	/// How to reach the engine.
+	enum class Kind
+	{
+		/// Run the engine as a child process.
+		process,
+		/// Connect to an engine served on a Unix domain socket.
+		unix_socket,
+		/// Connect to an engine served on a TCP port.
+		tcp
+	};
+
+	Engine_endpoint() = default;
+	/// Endpoint running the given engine executable.
+	Engine_endpoint(const std::filesystem::path& engine_executable);
+	/// Endpoint running the given engine executable.
+	Engine_endpoint(const std::string& engine_executable);
+	/// Endpoint running the given engine executable.
+	Engine_endpoint(const char* engine_executable);
+
+	/// Endpoint connecting to the Unix domain socket at the given path.
+	static Engine_endpoint unix_socket(const std::filesystem::path& socket_path);
+	/// Endpoint connecting to the given TCP host and port.
+	static Engine_endpoint tcp(const std::string& host, uint16_t port);
+	/**
+	 * Parse an endpoint, as given e.g. on the command line.
+	 *
+	 * \param text 'unix:PATH' for a Unix domain socket, 'tcp:HOST:PORT' for TCP (with the host in
+	 * brackets if it's an IPv6 address, e.g. 'tcp:[::1]:4000'), or otherwise the path of an engine executable.
+	 * \return Parsed endpoint.
+	 * \throw std::invalid_argument if the text starts with 'unix:' or 'tcp:' but isn't a valid endpoint.
+	 */
+	static Engine_endpoint parse(std::string_view text);
+
+	Kind kind{Kind::process};
+	/// Engine executable (process), socket path (unix_socket) or host name or address (tcp).
+	std::string location;
+	/// TCP port. Only used for tcp.
+	uint16_t port{0};
+};
+
+bool operator==(const Engine_endpoint& lhs, const Engine_endpoint& rhs);
+bool operator!=(const Engine_endpoint& lhs, const Engine_endpoint& rhs);
+
+/// Convert an endpoint to the form read by Engine_endpoint::parse().
+std::string to_string(const Engine_endpoint& endpoint);
+
+/**
+ * Connect to an engine served on a socket.
+ *
+ * TCP connections have Nagle's algorithm turned off, since UCI commands and replies are short
+ * messages which should be sent right away.
+ *
+ * \param endpoint Socket endpoint (unix_socket or tcp).
+ * \return Connected socket. The caller owns it.
+ * \throw std::invalid_argument if the endpoint isn't a socket.
+ * \throw std::runtime_error if connecting fails.
+ */
+int connect_to(const Engine_endpoint& endpoint);
+
+/**
+ * Listen for connections on a socket.
+ *
+ * An existing Unix domain socket file at the path is replaced.
+ *
+ * \param endpoint Socket endpoint (unix_socket or tcp). A TCP port of 0 picks a free port.
+ * \return Listening socket. The caller owns it.
+ * \throw std::invalid_argument if the endpoint isn't a socket.
+ * \throw std::runtime_error if listening fails.
+ */
+int listen_on(const Engine_endpoint& endpoint);
+
+/**
+ * Get the endpoint a listening socket has been bound to, e.g. to find the port picked for port 0.
+ *
+ * \throw std::runtime_error if the address can't be found.
+ */
+Engine_endpoint local_endpoint(int socket);
+
+} // namespace uci
+} // namespace chess
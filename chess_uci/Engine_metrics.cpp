@@ -0,0 +1,224 @@
+#include "Engine_metrics.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+size_t bucket_index(std::chrono::nanoseconds duration)
+{
+	if (duration.count() <= 0)
+		return 0;
+	// Number of significant bits in the duration
+	auto nanoseconds = static_cast<uint64_t>(duration.count());
+	size_t bit_width = 64 - static_cast<size_t>(__builtin_clzll(nanoseconds));
+	return bit_width < Histogram_snapshot::num_buckets ? bit_width : Histogram_snapshot::num_buckets - 1;
+}
+
+void add(std::atomic<uint64_t>& counter, uint64_t value)
+{
+	counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t load(const std::atomic<uint64_t>& counter)
+{
+	return counter.load(std::memory_order_relaxed);
+}
+
+class Prometheus_writer
+{
+public:
+	Prometheus_writer(std::string_view prefix, std::string_view labels)
+		: prefix_(prefix)
+		, labels_(labels)
+	{
+		stream_ << std::setprecision(10);
+	}
+
+	void counter(const char* name, const char* help, uint64_t value)
+	{
+		header(name, "_total", help, "counter");
+		sample(name, "_total", "", value);
+	}
+
+	void gauge(const char* name, const char* help, uint64_t value)
+	{
+		header(name, "", help, "gauge");
+		sample(name, "", "", value);
+	}
+
+	void histogram(const char* name, const char* help, const Histogram_snapshot& histogram)
+	{
+		header(name, "_seconds", help, "histogram");
+		uint64_t cumulative = 0;
+		for (size_t i = 0; i + 1 < Histogram_snapshot::num_buckets; ++i) {
+			cumulative += histogram.buckets[i];
+			std::ostringstream bound;
+			bound << std::setprecision(10) << std::chrono::duration<double>(Histogram_snapshot::bucket_upper_bound(i)).count();
+			sample(name, "_seconds_bucket", "le=\"" + bound.str() + "\"", cumulative);
+		}
+		sample(name, "_seconds_bucket", "le=\"+Inf\"", histogram.count());
+		header_name(name, "_seconds_sum");
+		stream_ << std::chrono::duration<double>(histogram.sum).count() << '\n';
+		sample(name, "_seconds_count", "", histogram.count());
+	}
+
+	std::string str() const
+	{
+		return stream_.str();
+	}
+
+private:
+	void header(const char* name, const char* suffix, const char* help, const char* type)
+	{
+		stream_ << "# HELP " << prefix_ << '_' << name << suffix << ' ' << help << '\n';
+		stream_ << "# TYPE " << prefix_ << '_' << name << suffix << ' ' << type << '\n';
+	}
+
+	/// Write the name of a sample, including the labels, followed by a space.
+	void header_name(const char* name, const char* suffix, const std::string& label = "")
+	{
+		stream_ << prefix_ << '_' << name << suffix;
+		if (!labels_.empty() || !label.empty()) {
+			stream_ << '{' << labels_;
+			if (!labels_.empty() && !label.empty())
+				stream_ << ',';
+			stream_ << label << '}';
+		}
+		stream_ << ' ';
+	}
+
+	void sample(const char* name, const char* suffix, const std::string& label, uint64_t value)
+	{
+		header_name(name, suffix, label);
+		stream_ << value << '\n';
+	}
+
+	std::string_view prefix_;
+	std::string_view labels_;
+	std::ostringstream stream_;
+};
+
+} // Anonymous namespace
+
+std::chrono::nanoseconds Histogram_snapshot::bucket_upper_bound(size_t bucket)
+{
+	return std::chrono::nanoseconds(int64_t(1) << bucket);
+}
+
+uint64_t Histogram_snapshot::count() const
+{
+	uint64_t total = 0;
+	for (uint64_t bucket_count : buckets)
+		total += bucket_count;
+	return total;
+}
+
+std::chrono::nanoseconds Histogram_snapshot::mean() const
+{
+	uint64_t total = count();
+	return total == 0 ? std::chrono::nanoseconds(0) : sum / static_cast<int64_t>(total);
+}
+
+std::chrono::nanoseconds Histogram_snapshot::quantile(double q) const
+{
+	uint64_t total = count();
+	if (total == 0)
+		return std::chrono::nanoseconds(0);
+	// Number of durations at or below the quantile
+	auto rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+	if (rank < 1)
+		rank = 1;
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i < num_buckets; ++i) {
+		cumulative += buckets[i];
+		if (cumulative >= rank)
+			return bucket_upper_bound(i);
+	}
+	return bucket_upper_bound(num_buckets - 1);
+}
+
+Histogram_snapshot& Histogram_snapshot::operator+=(const Histogram_snapshot& other)
+{
+	for (size_t i = 0; i < num_buckets; ++i)
+		buckets[i] += other.buckets[i];
+	sum += other.sum;
+	return *this;
+}
+
+void Latency_histogram::record(std::chrono::nanoseconds duration)
+{
+	buckets_[bucket_index(duration)].fetch_add(1, std::memory_order_relaxed);
+	sum_.fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+Histogram_snapshot Latency_histogram::snapshot() const
+{
+	Histogram_snapshot snapshot;
+	for (size_t i = 0; i < Histogram_snapshot::num_buckets; ++i)
+		snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+	snapshot.sum = std::chrono::nanoseconds(sum_.load(std::memory_order_relaxed));
+	return snapshot;
+}
+
+Metrics_snapshot& Metrics_snapshot::operator+=(const Metrics_snapshot& other)
+{
+	lines_read += other.lines_read;
+	bytes_read += other.bytes_read;
+	searches_completed += other.searches_completed;
+	nodes_searched += other.nodes_searched;
+	nodes_per_second += other.nodes_per_second;
+	timeouts += other.timeouts;
+	searches_stopped_early += other.searches_stopped_early;
+	startup_time += other.startup_time;
+	ready_latency += other.ready_latency;
+	first_info_latency += other.first_info_latency;
+	search_time += other.search_time;
+	stop_latency += other.stop_latency;
+	parse_time += other.parse_time;
+	return *this;
+}
+
+Metrics_snapshot Engine_metrics::snapshot() const
+{
+	Metrics_snapshot snapshot;
+	snapshot.lines_read = load(lines_read);
+	snapshot.bytes_read = load(bytes_read);
+	snapshot.searches_completed = load(searches_completed);
+	snapshot.nodes_searched = load(nodes_searched);
+	snapshot.nodes_per_second = load(nodes_per_second);
+	snapshot.timeouts = load(timeouts);
+	snapshot.searches_stopped_early = load(searches_stopped_early);
+	snapshot.startup_time = startup_time.snapshot();
+	snapshot.ready_latency = ready_latency.snapshot();
+	snapshot.first_info_latency = first_info_latency.snapshot();
+	snapshot.search_time = search_time.snapshot();
+	snapshot.stop_latency = stop_latency.snapshot();
+	snapshot.parse_time = parse_time.snapshot();
+	return snapshot;
+}
+
+std::string to_prometheus(const Metrics_snapshot& metrics, std::string_view prefix, std::string_view labels)
+{
+	Prometheus_writer writer(prefix, labels);
+	writer.counter("lines_read", "Number of messages read from the engines.", metrics.lines_read);
+	writer.counter("bytes_read", "Number of bytes read from the engines.", metrics.bytes_read);
+	writer.counter("searches_completed", "Number of calculations which finished with a best move.", metrics.searches_completed);
+	writer.counter("nodes_searched", "Number of nodes searched by the engines.", metrics.nodes_searched);
+	writer.counter("timeouts", "Number of times an engine didn't reply in time.", metrics.timeouts);
+	writer.counter("searches_stopped_early", "Number of calculations stopped once their result had converged.", metrics.searches_stopped_early);
+	writer.gauge("nodes_per_second", "Latest search speed reported by the engines.", metrics.nodes_per_second);
+	writer.histogram("startup_time", "Time from starting an engine until it's ready.", metrics.startup_time);
+	writer.histogram("ready_latency", "Round trip time of isready.", metrics.ready_latency);
+	writer.histogram("first_info_latency", "Time from go until the first search info.", metrics.first_info_latency);
+	writer.histogram("search_time", "Time from go until bestmove.", metrics.search_time);
+	writer.histogram("stop_latency", "Time from stop until bestmove.", metrics.stop_latency);
+	writer.histogram("parse_time", "Time to parse an info message.", metrics.parse_time);
+	return writer.str();
+}
+
+} // namespace uci
+} // namespace chess
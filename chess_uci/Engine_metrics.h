@@ -0,0 +1,165 @@
+/**
+ * \file Engine_metrics.h
+ * \brief Contains counters and latency histograms describing the communication with an engine.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \struct Histogram_snapshot
+ * \brief Copy of the contents of a Latency_histogram at some point in time.
+ *
+ * Durations are counted in buckets whose upper bounds are powers of two nanoseconds, i.e. bucket
+ * i holds durations d with 2^(i-1) <= d < 2^i ns, and bucket 0 holds durations of 0 ns. The last
+ * bucket also holds all longer durations.
+ */
+struct Histogram_snapshot
+{
+	/// Number of buckets. The last regular bucket ends at 2^46 ns, which is about 20 hours.
+	static constexpr size_t num_buckets = 48;
+
+	/// Number of durations in each bucket.
+	std::array<uint64_t, num_buckets> buckets{};
+	/// Sum of all durations.
+	std::chrono::nanoseconds sum{0};
+
+	/// Upper bound (exclusive) of the bucket with the given index.
+	static std::chrono::nanoseconds bucket_upper_bound(size_t bucket);
+
+	/// Total number of durations.
+	uint64_t count() const;
+	/// Average duration, or 0 if there are no durations.
+	std::chrono::nanoseconds mean() const;
+	/**
+	 * Estimate a quantile of the durations.
+	 *
+	 * \param q Quantile to estimate, between 0 and 1 (e.g. 0.99 for the 99th percentile).
+	 * \return Upper bound of the bucket holding the quantile, so the estimate is at most twice the
+	 * actual value. 0 if there are no durations.
+	 */
+	std::chrono::nanoseconds quantile(double q) const;
+
+	/// Add the durations of another histogram to this one.
+	Histogram_snapshot& operator+=(const Histogram_snapshot& other);
+};
+
+/**
+ * \class Latency_histogram
+ * \brief Histogram of durations, which can be updated and read from any thread without locking.
+ *
+ * Recording a duration is a few relaxed atomic additions, so it's cheap enough to leave on.
+ */
+class Latency_histogram
+{
+public:
+	/// Add a duration to the histogram.
+	void record(std::chrono::nanoseconds duration);
+	/// Get the current contents of the histogram.
+	Histogram_snapshot snapshot() const;
+
+private:
+	std::array<std::atomic<uint64_t>, Histogram_snapshot::num_buckets> buckets_{};
+	std::atomic<int64_t> sum_{0};
+};
+
+/**
+ * \struct Metrics_snapshot
+ * \brief Copy of the metrics of one or more engines at some point in time.
+ *
+ * Snapshots of several engines (e.g. all engines in an Engine_pool) are aggregated with +=.
+ */
+struct Metrics_snapshot
+{
+	/// Number of messages read from the engine.
+	uint64_t lines_read{0};
+	/// Number of bytes read from the engine, including line breaks.
+	uint64_t bytes_read{0};
+	/// Number of calculations which have finished with a best move.
+	uint64_t searches_completed{0};
+	/// Sum of the number of nodes the engine reported at the end of each calculation.
+	uint64_t nodes_searched{0};
+	/// Latest number of nodes per second the engine reported (summed over aggregated engines).
+	uint64_t nodes_per_second{0};
+	/// Number of times the engine didn't reply in time.
+	uint64_t timeouts{0};
+	/// Number of calculations which were stopped early since their result had converged.
+	uint64_t searches_stopped_early{0};
+
+	/// Time from starting the engine process until it's ready for the first command.
+	Histogram_snapshot startup_time;
+	/// Time from sending isready until the engine replies readyok.
+	Histogram_snapshot ready_latency;
+	/// Time from sending go until the first info message with search results.
+	Histogram_snapshot first_info_latency;
+	/// Time from sending go until the engine sends its best move.
+	Histogram_snapshot search_time;
+	/// Time from sending stop until the engine sends its best move.
+	Histogram_snapshot stop_latency;
+	/// Time spent parsing each info message.
+	Histogram_snapshot parse_time;
+
+	/// Add the metrics of another snapshot to this one.
+	Metrics_snapshot& operator+=(const Metrics_snapshot& other);
+};
+
+/**
+ * \struct Engine_metrics
+ * \brief Live metrics of an engine, see Metrics_snapshot for the meaning of each metric.
+ *
+ * All members can be updated and read from any thread. Counters use relaxed atomics, so a
+ * snapshot taken while the engine is running may be slightly inconsistent between metrics.
+ */
+struct Engine_metrics
+{
+	std::atomic<uint64_t> lines_read{0};
+	std::atomic<uint64_t> bytes_read{0};
+	std::atomic<uint64_t> searches_completed{0};
+	std::atomic<uint64_t> nodes_searched{0};
+	std::atomic<uint64_t> nodes_per_second{0};
+	std::atomic<uint64_t> timeouts{0};
+	std::atomic<uint64_t> searches_stopped_early{0};
+
+	Latency_histogram startup_time;
+	Latency_histogram ready_latency;
+	Latency_histogram first_info_latency;
+	Latency_histogram search_time;
+	Latency_histogram stop_latency;
+	Latency_histogram parse_time;
+
+	/// Count a message read from the engine, not including its line break.
+	void count_line(std::string_view line)
+	{
+		lines_read.fetch_add(1, std::memory_order_relaxed);
+		bytes_read.fetch_add(line.size() + 1, std::memory_order_relaxed);
+	}
+
+	/// Get the current value of all metrics.
+	Metrics_snapshot snapshot() const;
+};
+
+/**
+ * Format metrics in the Prometheus text exposition format.
+ *
+ * Counters are named <prefix>_<metric>_total and histograms <prefix>_<metric>_seconds, e.g.
+ * 'chess_uci_lines_read_total' and 'chess_uci_search_time_seconds_bucket{le="0.001048576"}'.
+ *
+ * \param metrics Metrics to format.
+ * \param prefix Prefix of all metric names.
+ * \param labels Labels to add to all metrics, without braces (e.g. 'pool="analysis"'), if any.
+ * \return Metrics, one sample per line.
+ */
+std::string to_prometheus(const Metrics_snapshot& metrics, std::string_view prefix = "chess_uci", std::string_view labels = "");
+
+} // namespace uci
+} // namespace chess
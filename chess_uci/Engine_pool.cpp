@@ -0,0 +1,184 @@
+#include "Engine_pool.h"
+
+#include <stdexcept>
+#include <thread>
+
+namespace chess {
+namespace uci {
+
+std::vector<Analyzed_line> run_analysis_job(Engine& engine, const Analysis_job& job)
+{
+	if (job.new_game)
+		engine.setup_game_from_fen(job.fen);
+	else
+		engine.set_position_from_fen(job.fen);
+	engine.set_convergence_policy(job.convergence);
+	engine.start_calculating(job.limits.value_or(Search_limits::for_move_time(job.calculation_time)));
+	if (!job.timeout.has_value())
+		return engine.wait_for_result();
+	if (engine.wait_for_result(std::chrono::steady_clock::now() + *job.timeout) == Engine::Wait_status::timed_out)
+		throw std::runtime_error("Engine error: The engine didn't finish the analysis in time");
+	return engine.get_top_suggested_move_sequences();
+}
+
+Engine_pool::Engine_pool(const Engine_endpoint& endpoint, size_t num_engines, uint8_t num_best_lines, const Task& setup)
+	: endpoint_(endpoint)
+	, num_best_lines_(num_best_lines)
+	, setup_(setup)
+{
+	if (num_engines == 0)
+		throw std::invalid_argument("Engine pool error: Need at least one engine");
+
+	// Start all engines, in parallel, before any worker starts taking tasks
+	auto engines = Engine::start_engines(endpoint, num_engines, num_best_lines);
+	workers_.reserve(num_engines);
+	for (auto& engine : engines) {
+		workers_.push_back(std::make_unique<Worker>());
+		workers_.back()->engine = std::move(engine);
+		if (setup)
+			setup(*workers_.back()->engine);
+	}
+	for (size_t i = 0; i < num_engines; ++i)
+		workers_[i]->thread = std::thread([this, i]() {
+			run_worker(i);
+		});
+}
+
+Engine_pool::~Engine_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		stopping_ = true;
+	}
+	task_available_.notify_all();
+	for (auto& worker : workers_)
+		worker->thread.join();
+}
+
+std::future<std::vector<Analyzed_line>> Engine_pool::submit(Analysis_job job)
+{
+	auto promise = std::make_shared<std::promise<std::vector<Analyzed_line>>>();
+	auto future = promise->get_future();
+	execute([job = std::move(job), promise](Engine& engine) {
+		try {
+			promise->set_value(run_analysis_job(engine, job));
+		} catch (...) {
+			promise->set_exception(std::current_exception());
+		}
+	});
+	return future;
+}
+
+void Engine_pool::execute(Task task)
+{
+	Worker& worker = *workers_[next_worker_++ % workers_.size()];
+	{
+		// Queue the task and count it in one step, so that a worker can never take the task before it's counted
+		std::lock_guard<std::mutex> state_lock(state_mutex_);
+		std::lock_guard<std::mutex> queue_lock(worker.queue_mutex);
+		worker.queue.push_back(std::move(task));
+		pending_tasks_ += 1;
+	}
+	task_available_.notify_one();
+}
+
+size_t Engine_pool::size() const
+{
+	return workers_.size();
+}
+
+Metrics_snapshot Engine_pool::get_metrics() const
+{
+	Metrics_snapshot metrics;
+	{
+		std::lock_guard<std::mutex> lock(retired_mutex_);
+		metrics = retired_metrics_;
+	}
+	for (const auto& worker : workers_) {
+		std::lock_guard<std::mutex> lock(worker->engine_mutex);
+		metrics += worker->engine->get_metrics();
+	}
+	return metrics;
+}
+
+uint64_t Engine_pool::num_replaced_engines() const
+{
+	std::lock_guard<std::mutex> lock(retired_mutex_);
+	return num_replaced_engines_;
+}
+
+void Engine_pool::run_worker(size_t worker_index)
+{
+	Worker& worker = *workers_[worker_index];
+	Task task;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(state_mutex_);
+			task_available_.wait(lock, [this]() {
+				return stopping_ || pending_tasks_ > 0;
+			});
+			if (stopping_)
+				return;
+		}
+		// Another worker may have taken the task we were woken up for, in which case we go back to sleep
+		if (!take_task(worker_index, task))
+			continue;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex_);
+			pending_tasks_ -= 1;
+		}
+		task(*worker.engine);
+		task = nullptr;
+		// An engine which didn't reply in time has been killed, so it can't take any more tasks
+		if (worker.engine->was_killed())
+			replace_engine(worker);
+	}
+}
+
+void Engine_pool::replace_engine(Worker& worker)
+{
+	std::unique_ptr<Engine> engine;
+	try {
+		engine = std::make_unique<Engine>(endpoint_, num_best_lines_);
+		if (setup_)
+			setup_(*engine);
+	} catch (const std::exception&) {
+		// Keep the killed engine, which fails the tasks given to it, and try again after the next task
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(worker.engine_mutex);
+		std::swap(worker.engine, engine);
+	}
+	std::lock_guard<std::mutex> lock(retired_mutex_);
+	retired_metrics_ += engine->get_metrics();
+	num_replaced_engines_ += 1;
+}
+
+bool Engine_pool::take_task(size_t worker_index, Task& task)
+{
+	// First look in our own queue
+	{
+		Worker& worker = *workers_[worker_index];
+		std::lock_guard<std::mutex> lock(worker.queue_mutex);
+		if (!worker.queue.empty()) {
+			task = std::move(worker.queue.front());
+			worker.queue.pop_front();
+			return true;
+		}
+	}
+	// Then steal from the other workers, starting with our neighbour so that thieves spread out
+	for (size_t offset = 1; offset < workers_.size(); ++offset) {
+		Worker& victim = *workers_[(worker_index + offset) % workers_.size()];
+		std::lock_guard<std::mutex> lock(victim.queue_mutex);
+		if (!victim.queue.empty()) {
+			task = std::move(victim.queue.back());
+			victim.queue.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,177 @@
+/**
+ * \file Engine_pool.h
+ * \brief Contains a pool of UCI chess engines used to analyze many positions in parallel.
+ */
+
+#pragma once
+
+#include "Engine.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/// A position to analyze, together with how long the engine should analyze it.
+struct Analysis_job
+{
+	/// Position to analyze, specified as a Forsyth-Edwards Notation (FEN) string.
+	std::string fen;
+	/// Time the engine is allowed to calculate on the position. Ignored if limits is given.
+	std::chrono::milliseconds calculation_time{1000};
+	/// Whether or not to tell the engine that a new game starts before analyzing the position.
+	/// Engines clear their hash table for a new game, which can take longer than a short
+	/// calculation, and isn't needed for correct results.
+	bool new_game{true};
+	/// Limits for the calculation, if other than calculation_time. Must be finite (see
+	/// Search_limits::is_finite()).
+	std::optional<Search_limits> limits;
+	/// Maximum time to wait for the result once the engine has started calculating, if any. The
+	/// engine is told to stop shortly before the time is up, and is killed if it still hasn't
+	/// finished then (see Engine::wait_for_result(std::chrono::steady_clock::time_point, std::chrono::milliseconds)).
+	std::optional<std::chrono::milliseconds> timeout;
+	/// Policy for stopping the analysis early once its result has converged, if any (see
+	/// Engine::set_convergence_policy()).
+	std::optional<Convergence_policy> convergence;
+};
+
+/**
+ * Analyze a position on the given engine.
+ *
+ * \param engine Engine to use.
+ * The engine is given the limits of the job, and the result is returned as soon as the engine
+ * has finished.
+ *
+ * \param job Position to analyze and how long to analyze it.
+ * \return The top suggested lines for the position, see Engine::get_top_suggested_move_sequences().
+ * \throw std::runtime_error if the engine fails, or if it had to be killed since it didn't finish
+ * within the timeout of the job.
+ */
+std::vector<Analyzed_line> run_analysis_job(Engine& engine, const Analysis_job& job);
+
+/**
+ * \class Engine_pool
+ * \brief Runs a number of engine child processes, each driven by its own worker thread, and
+ * distributes submitted analysis jobs over them.
+ *
+ * Each worker has its own job queue. Submitted jobs are distributed over the queues in a round
+ * robin fashion, and a worker whose own queue is empty steals jobs from the back of the other
+ * workers' queues. This way a single slow job only delays the jobs queued behind it until some
+ * other worker becomes idle.
+ *
+ * An engine which has been killed since it didn't finish a job within the timeout of the job (see
+ * Analysis_job::timeout) is replaced by a newly started engine, so a hung engine only fails that job.
+ *
+ * Usage:
+ * 1. Create Engine_pool object with path to the chess engine to run and the number of engines.
+ * 2. Call submit() for each position to analyze, and collect the results from the returned futures.
+ * 3. Destroy the Engine_pool object. This will stop all engine child processes. Jobs which have not
+ *    yet been started are abandoned, and their futures will report a broken promise.
+ */
+class Engine_pool
+{
+public:
+	/// A task to run on one of the engines in the pool.
+	using Task = std::function<void(Engine&)>;
+
+	/**
+	 * \param endpoint Engine to use (see Engine::Engine()).
+	 * \param num_engines Number of engines (and worker threads) to run.
+	 * \param num_best_lines Number of best lines each engine should suggest.
+	 * \param setup Function called for each engine when it has been started, e.g. to set engine
+	 * options such as the number of threads (see Engine::set_option()).
+	 */
+	Engine_pool(
+		const Engine_endpoint& endpoint,
+		size_t num_engines,
+		uint8_t num_best_lines = 1,
+		const Task& setup = nullptr);
+	~Engine_pool();
+
+	Engine_pool(const Engine_pool&) = delete;
+	Engine_pool& operator=(const Engine_pool&) = delete;
+
+	/**
+	 * Queue a position for analysis.
+	 *
+	 * \param job Position to analyze and how long to analyze it.
+	 * \return Future holding the top suggested lines for the position, see
+	 * Engine::get_top_suggested_move_sequences(). If the analysis fails the future holds the
+	 * exception thrown by the engine.
+	 */
+	std::future<std::vector<Analyzed_line>> submit(Analysis_job job);
+
+	/**
+	 * Queue an arbitrary task to run on the next available engine.
+	 *
+	 * The task has exclusive access to the engine while it's running. Exceptions thrown by the
+	 * task are not caught by the pool, so the task should handle its own errors.
+	 *
+	 * \param task Task to run.
+	 */
+	void execute(Task task);
+
+	/// Number of engines in the pool.
+	size_t size() const;
+	/// Number of engines which have been replaced since they were killed after not replying in time.
+	uint64_t num_replaced_engines() const;
+
+	/// Get the metrics of all engines in the pool added together (see Engine::get_metrics()).
+	Metrics_snapshot get_metrics() const;
+
+private:
+	/// An engine together with the thread driving it and its queue of pending tasks.
+	struct Worker
+	{
+		std::unique_ptr<Engine> engine;
+		/// Guards replacing engine, which may happen while get_metrics() is called.
+		mutable std::mutex engine_mutex;
+		std::deque<Task> queue;
+		std::mutex queue_mutex;
+		std::thread thread;
+	};
+
+	/// Main loop of the worker thread with the given index.
+	void run_worker(size_t worker_index);
+	/// Pop a task from the front of the given worker's own queue, or steal one from the back of another worker's queue.
+	bool take_task(size_t worker_index, Task& task);
+	/// Replace the engine of the given worker, which has been killed, by a newly started engine.
+	void replace_engine(Worker& worker);
+
+	Engine_endpoint endpoint_;
+	uint8_t num_best_lines_{1};
+	/// Function called for each started engine, if any.
+	Task setup_;
+	std::vector<std::unique_ptr<Worker>> workers_;
+	/// Guards retired_metrics_ and num_replaced_engines_.
+	mutable std::mutex retired_mutex_;
+	/// Metrics of the engines which have been replaced, so that they're still counted.
+	Metrics_snapshot retired_metrics_;
+	uint64_t num_replaced_engines_{0};
+
+	/// Index of the worker whose queue the next submitted task is put in.
+	std::atomic<size_t> next_worker_{0};
+
+	/// Guards pending_tasks_ and stopping_, used together with task_available_ to put idle workers to sleep.
+	std::mutex state_mutex_;
+	std::condition_variable task_available_;
+	/// Number of tasks queued but not yet taken by any worker.
+	size_t pending_tasks_{0};
+	/// Whether or not the pool is shutting down.
+	bool stopping_{false};
+};
+
+} // namespace uci
+} // namespace chess
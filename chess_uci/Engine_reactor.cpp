@@ -0,0 +1,410 @@
+#include "Engine_reactor.h"
+
+#include "Convergence.h"
+#include "Line_reader.h"
+#include "Parse_messages.h"
+#include "Process_reaper.h"
+#include "Sigpipe_guard.h"
+
+#include <boost/process.hpp>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace chess {
+namespace uci {
+
+struct Engine_reactor::Connection
+{
+	enum class State
+	{
+		waiting_for_uciok,
+		waiting_for_readyok,
+		idle,
+		analyzing,
+		failed
+	};
+
+	Connection(const std::filesystem::path& engine_executable, size_t index)
+		: process(engine_executable.string(), boost::process::std_out > engine_to_host_pipe, boost::process::std_in < host_to_engine_pipe)
+		, read_fd(engine_to_host_pipe.native_source())
+		, write_fd(host_to_engine_pipe.native_sink())
+		, index(index)
+	{
+		// Boost closes our copies of the engine's ends of the pipes when the process has been
+		// started, so make sure that the pipes don't close them again
+		engine_to_host_pipe.assign_sink(-1);
+		host_to_engine_pipe.assign_source(-1);
+	}
+
+	/// Pipe which the engine writes it's messages to.
+	boost::process::pipe engine_to_host_pipe;
+	/// Pipe which the engine reads commands from.
+	boost::process::pipe host_to_engine_pipe;
+	/// Child process running the engine.
+	boost::process::child process;
+	int read_fd;
+	int write_fd;
+	/// Index of the connection in Engine_reactor::connections_.
+	size_t index;
+
+	State state{State::waiting_for_uciok};
+	/// Engine output which hasn't been handled yet. Starts small, since there may be many engines.
+	Line_buffer input{4 * 1024};
+	/// Commands which haven't been written to the engine yet, starting at output_written.
+	std::string output;
+	size_t output_written{0};
+	/// Whether or not epoll waits for the engine to accept more commands.
+	bool waiting_for_writable{false};
+
+	/// Position being analyzed.
+	Request request;
+	/// Latest line for each multipv slot in the running analysis.
+	std::vector<Analyzed_line> lines;
+	/// Follows whether the result of the running analysis has converged, if it may be stopped early.
+	std::optional<Convergence_tracker> convergence;
+};
+
+namespace {
+
+/// Maximum number of reads from one engine per event, so that a very talkative engine can't hold up the others.
+constexpr int max_reads_per_event = 16;
+
+[[noreturn]] void throw_system_error(const std::string& what)
+{
+	throw std::system_error(errno, std::generic_category(), "Engine reactor error: " + what);
+}
+
+void make_non_blocking(int fd)
+{
+	int flags = ::fcntl(fd, F_GETFL);
+	if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)
+		throw_system_error("Failed to make engine pipe non-blocking");
+	// Engines started later shouldn't inherit the pipes of this engine
+	if (::fcntl(fd, F_SETFD, FD_CLOEXEC) != 0)
+		throw_system_error("Failed to set close on exec for engine pipe");
+}
+
+bool is_bestmove_message(std::string_view message)
+{
+	return message.substr(0, 8) == "bestmove";
+}
+
+/// epoll data identifying the read or write end of the given connection.
+uint64_t event_data(size_t connection_index, bool write)
+{
+	return 2 * static_cast<uint64_t>(connection_index) + (write ? 1 : 0);
+}
+
+} // Anonymous namespace
+
+Engine_reactor::Engine_reactor(const std::filesystem::path& engine_executable, size_t num_engines, uint8_t num_best_lines)
+	: num_best_lines_(num_best_lines)
+{
+	if (num_engines == 0)
+		throw std::invalid_argument("Engine reactor error: Need at least one engine");
+	// Make sure that the reaper outlives the reactor, also when both are static
+	Process_reaper::instance();
+
+	epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd_ < 0)
+		throw_system_error("Failed to create epoll instance");
+	try {
+		// Start all engines right away. Their handshakes then run in parallel in the event loop.
+		connections_.reserve(num_engines);
+		for (size_t i = 0; i < num_engines; ++i) {
+			connections_.push_back(std::make_unique<Connection>(engine_executable, i));
+			Connection& connection = *connections_.back();
+			make_non_blocking(connection.read_fd);
+			make_non_blocking(connection.write_fd);
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.u64 = event_data(i, false);
+			if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, connection.read_fd, &event) != 0)
+				throw_system_error("Failed to watch engine output");
+			num_alive_ += 1;
+			send(connection, "uci\n");
+		}
+	} catch (...) {
+		::close(epoll_fd_);
+		throw;
+	}
+}
+
+Engine_reactor::~Engine_reactor()
+{
+	// Ask the engines to quit, and let them exit in the background. The commands are written right
+	// away if the engine accepts them, and the engine sees the end of its input when its connection
+	// is destroyed, so it quits either way.
+	for (auto& connection : connections_) {
+		if (connection->state != Connection::State::failed)
+			send(*connection, "quit\n");
+		Process_reaper::instance().reap(std::move(connection->process), Process_reaper::default_timeout);
+	}
+	::close(epoll_fd_);
+}
+
+void Engine_reactor::analyze(const Analysis_job& job, Engine::Completion_callback on_completion)
+{
+	if (job.limits.has_value() && !job.limits->is_finite())
+		throw std::invalid_argument("Engine reactor error: Can't analyze a position without limits");
+
+	requests_.push_back({job, std::move(on_completion)});
+	dispatch();
+	fail_requests_without_engines();
+}
+
+void Engine_reactor::run()
+{
+	while (true) {
+		fail_requests_without_engines();
+		if (requests_.empty() && num_running_ == 0)
+			return;
+		run_once(std::chrono::milliseconds(-1));
+	}
+}
+
+size_t Engine_reactor::run_once(std::chrono::milliseconds timeout)
+{
+	constexpr int max_events = 64;
+	epoll_event events[max_events];
+	int timeout_ms = timeout.count() < 0 ? -1 : static_cast<int>(timeout.count());
+	int num_events = ::epoll_wait(epoll_fd_, events, max_events, timeout_ms);
+	if (num_events < 0) {
+		if (errno == EINTR)
+			return 0;
+		throw_system_error("Failed to wait for engine output");
+	}
+
+	for (int i = 0; i < num_events; ++i) {
+		Connection& connection = *connections_[events[i].data.u64 / 2];
+		if (connection.state == Connection::State::failed)
+			// Failed by an earlier event in this batch
+			continue;
+		if (events[i].data.u64 % 2 == 1)
+			flush(connection);
+		else
+			on_readable(connection);
+	}
+	return static_cast<size_t>(num_events);
+}
+
+size_t Engine_reactor::num_engines() const
+{
+	return num_alive_;
+}
+
+size_t Engine_reactor::num_pending() const
+{
+	return requests_.size() + num_running_;
+}
+
+void Engine_reactor::on_readable(Connection& connection)
+{
+	for (int i = 0; i < max_reads_per_event && connection.state != Connection::State::failed; ++i) {
+		char* destination = connection.input.prepare();
+		ssize_t num_read = ::read(connection.read_fd, destination, connection.input.writable_size());
+		if (num_read < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				fail(connection, std::make_exception_ptr(std::system_error(errno, std::generic_category(), "Error reading engine output")));
+			return;
+		}
+
+		connection.input.commit(static_cast<size_t>(num_read));
+		try {
+			while (connection.state != Connection::State::failed) {
+				std::optional<std::string_view> line = connection.input.next_line();
+				if (!line.has_value())
+					break;
+				on_line(connection, *line);
+			}
+			if (num_read == 0 && connection.state != Connection::State::failed) {
+				// Handle a final line which isn't terminated by a newline
+				std::string_view remaining = connection.input.take_remaining();
+				if (!remaining.empty())
+					on_line(connection, remaining);
+			}
+		} catch (...) {
+			fail(connection, std::current_exception());
+			return;
+		}
+		if (num_read == 0) {
+			fail(connection, std::make_exception_ptr(std::runtime_error("Engine error: Engine output ended while waiting for a reply")));
+			return;
+		}
+	}
+}
+
+void Engine_reactor::on_line(Connection& connection, std::string_view line)
+{
+	switch (connection.state) {
+	case Connection::State::waiting_for_uciok:
+		if (line == "uciok") {
+			connection.state = Connection::State::waiting_for_readyok;
+			send(connection, "setoption name MultiPV value " + std::to_string(num_best_lines_) + "\nisready\n");
+		}
+		break;
+	case Connection::State::waiting_for_readyok:
+		if (line == "readyok") {
+			connection.state = Connection::State::idle;
+			idle_connections_.push_back(&connection);
+			dispatch();
+		}
+		break;
+	case Connection::State::analyzing:
+		if (is_search_info_message(line)) {
+			Info info = parse_info(line);
+			if (connection.convergence.has_value() && !connection.convergence->has_converged() && connection.convergence->update(info))
+				send(connection, "stop\n");
+			update_lines(connection.lines, info);
+		} else if (is_bestmove_message(line)) {
+			complete(connection);
+		}
+		break;
+	case Connection::State::idle:
+	case Connection::State::failed:
+		break;
+	}
+}
+
+void Engine_reactor::complete(Connection& connection)
+{
+	// Drop trailing lines that the engine never reported, e.g. when there are fewer legal moves than requested lines
+	std::vector<Analyzed_line> lines = std::move(connection.lines);
+	while (!lines.empty() && lines.back().moves.empty())
+		lines.pop_back();
+	Request request = std::move(connection.request);
+
+	connection.state = Connection::State::idle;
+	idle_connections_.push_back(&connection);
+	num_running_ -= 1;
+	// Keep the engine busy before calling the callback, which may take a while
+	dispatch();
+
+	if (request.on_completion)
+		request.on_completion(lines, nullptr);
+}
+
+void Engine_reactor::flush(Connection& connection)
+{
+	Sigpipe_guard sigpipe_guard;
+	while (connection.output_written < connection.output.size()) {
+		ssize_t num_written = ::write(
+			connection.write_fd,
+			connection.output.data() + connection.output_written,
+			connection.output.size() - connection.output_written);
+		if (num_written < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			fail(connection, std::make_exception_ptr(std::system_error(errno, std::generic_category(), "Error writing engine commands")));
+			return;
+		}
+		connection.output_written += static_cast<size_t>(num_written);
+	}
+	if (connection.output_written == connection.output.size()) {
+		connection.output.clear();
+		connection.output_written = 0;
+	}
+	update_events(connection);
+}
+
+void Engine_reactor::send(Connection& connection, std::string_view command)
+{
+	if (connection.state == Connection::State::failed)
+		return;
+	connection.output.append(command);
+	flush(connection);
+}
+
+void Engine_reactor::fail(Connection& connection, std::exception_ptr error)
+{
+	if (connection.state == Connection::State::failed)
+		return;
+
+	Connection::State state = connection.state;
+	connection.state = Connection::State::failed;
+	num_alive_ -= 1;
+	::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.read_fd, nullptr);
+	if (connection.waiting_for_writable)
+		::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.write_fd, nullptr);
+	connection.waiting_for_writable = false;
+	connection.output.clear();
+	connection.output_written = 0;
+
+	if (state == Connection::State::idle)
+		idle_connections_.erase(std::find(idle_connections_.begin(), idle_connections_.end(), &connection));
+	if (state == Connection::State::analyzing) {
+		num_running_ -= 1;
+		Request request = std::move(connection.request);
+		if (request.on_completion)
+			request.on_completion({}, error);
+	}
+	fail_requests_without_engines();
+}
+
+void Engine_reactor::dispatch()
+{
+	while (!requests_.empty() && !idle_connections_.empty()) {
+		Connection& connection = *idle_connections_.back();
+		idle_connections_.pop_back();
+		connection.request = std::move(requests_.front());
+		requests_.pop_front();
+		connection.lines.assign(num_best_lines_, Analyzed_line());
+		if (connection.request.job.convergence.has_value())
+			connection.convergence.emplace(*connection.request.job.convergence);
+		else
+			connection.convergence.reset();
+		connection.state = Connection::State::analyzing;
+		num_running_ += 1;
+
+		// All commands for the position are written at once. The engine handles them in order, so
+		// there's no need to wait for it to be ready after a new game.
+		const Analysis_job& job = connection.request.job;
+		std::string commands;
+		if (job.new_game)
+			commands += "ucinewgame\n";
+		commands += "position fen " + job.fen + "\n";
+		commands += to_go_command(job.limits.value_or(Search_limits::for_move_time(job.calculation_time)));
+		commands += "\n";
+		send(connection, commands);
+	}
+}
+
+void Engine_reactor::fail_requests_without_engines()
+{
+	while (num_alive_ == 0 && !requests_.empty()) {
+		Request request = std::move(requests_.front());
+		requests_.pop_front();
+		if (request.on_completion)
+			request.on_completion({}, std::make_exception_ptr(std::runtime_error("Engine reactor error: All engines have failed")));
+	}
+}
+
+void Engine_reactor::update_events(Connection& connection)
+{
+	bool wait_for_writable = !connection.output.empty();
+	if (wait_for_writable == connection.waiting_for_writable)
+		return;
+
+	epoll_event event{};
+	event.events = EPOLLOUT;
+	event.data.u64 = event_data(connection.index, true);
+	if (::epoll_ctl(epoll_fd_, wait_for_writable ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, connection.write_fd, &event) != 0)
+		throw_system_error("Failed to watch engine input");
+	connection.waiting_for_writable = wait_for_writable;
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,138 @@
+/**
+ * \file Engine_reactor.h
+ * \brief Contains an event loop driving many UCI chess engines from a single thread.
+ */
+
+#pragma once
+
+#include "Engine.h"
+#include "Engine_pool.h"
+#include "Line.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Engine_reactor
+ * \brief Runs a number of engine child processes and analyzes positions on them, handling the
+ * communication with all engines from a single thread.
+ *
+ * Where Engine_pool uses a worker thread per engine, which spends most of its time blocked
+ * waiting for its engine, the reactor waits for output from all engines at once with epoll. The
+ * output of each engine is split into lines and parsed as it arrives, and each engine goes through
+ * the UCI handshake and the analysis of its positions as a state machine driven by that output.
+ * This way a single thread can drive hundreds of engines.
+ *
+ * Usage:
+ * 1. Create Engine_reactor object with path to the chess engine to run and the number of engines.
+ * 2. Call analyze() for each position to analyze. Positions are analyzed in the order given, as
+ *    engines become available.
+ * 3. Call run() to run the event loop until all positions have been analyzed, or call run_once()
+ *    repeatedly to interleave the loop with other work. Results are passed to the given callbacks
+ *    from within these calls, and the callbacks may call analyze() to queue more positions.
+ * 4. Destroy the Engine_reactor object. This will stop all engine child processes.
+ *
+ * The reactor isn't thread safe. All member functions should be called from the thread running the loop.
+ * An engine which exits or crashes only fails the position it was analyzing, and the reactor carries
+ * on with the remaining engines.
+ */
+class Engine_reactor
+{
+public:
+	/**
+	 * \param engine_executable Path to the engine executable.
+	 * \param num_engines Number of engine child processes to run.
+	 * \param num_best_lines Number of best lines each engine should suggest.
+	 * \throw std::system_error if the event loop can't be set up.
+	 */
+	Engine_reactor(
+		const std::filesystem::path& engine_executable,
+		size_t num_engines,
+		uint8_t num_best_lines = 1);
+	~Engine_reactor();
+
+	Engine_reactor(const Engine_reactor&) = delete;
+	Engine_reactor& operator=(const Engine_reactor&) = delete;
+
+	/**
+	 * Queue a position for analysis.
+	 *
+	 * \param job Position to analyze and how long to analyze it. The limits must be finite (see
+	 * Search_limits::is_finite()), since the engine must finish by itself.
+	 * \param on_completion Function to call with the top suggested lines for the position, or the
+	 * error if the engine analyzing the position fails. Called from run() or run_once().
+	 * \throw std::invalid_argument if the limits of the job aren't finite.
+	 */
+	void analyze(const Analysis_job& job, Engine::Completion_callback on_completion);
+
+	/**
+	 * Run the event loop until all queued positions have been analyzed.
+	 *
+	 * If all engines have failed, the remaining positions are completed with an error.
+	 */
+	void run();
+	/**
+	 * Wait for engine output (or for engines to accept commands) and handle it.
+	 *
+	 * \param timeout Maximum time to wait, or a negative time to wait until something happens.
+	 * \return Number of engine events handled.
+	 */
+	size_t run_once(std::chrono::milliseconds timeout);
+
+	/// Number of engines which haven't failed.
+	size_t num_engines() const;
+	/// Number of positions which are queued or being analyzed.
+	size_t num_pending() const;
+
+private:
+	struct Connection;
+	/// A position to analyze, together with the function to call with the result.
+	struct Request
+	{
+		Analysis_job job;
+		Engine::Completion_callback on_completion;
+	};
+
+	/// Handle readable (or closed) engine output.
+	void on_readable(Connection& connection);
+	/// Handle a single line of engine output.
+	void on_line(Connection& connection, std::string_view line);
+	/// Pass the result of the finished analysis on the connection to its callback.
+	void complete(Connection& connection);
+	/// Write as much of the pending commands to the engine as it accepts without blocking.
+	void flush(Connection& connection);
+	/// Queue a command to the engine, and write it if possible.
+	void send(Connection& connection, std::string_view command);
+	/// Mark the connection as failed, and fail the position being analyzed, if any.
+	void fail(Connection& connection, std::exception_ptr error);
+	/// Start analyzing queued positions on idle engines.
+	void dispatch();
+	/// Complete the queued positions with an error if there are no engines left to analyze them.
+	void fail_requests_without_engines();
+	/// Update which events epoll waits for on the given connection.
+	void update_events(Connection& connection);
+
+	int epoll_fd_{-1};
+	uint8_t num_best_lines_{1};
+	std::vector<std::unique_ptr<Connection>> connections_;
+	/// Connections which are ready to analyze a position.
+	std::vector<Connection*> idle_connections_;
+	/// Positions which haven't yet been given to an engine.
+	std::deque<Request> requests_;
+	/// Number of positions being analyzed.
+	size_t num_running_{0};
+	/// Number of connections which haven't failed.
+	size_t num_alive_{0};
+};
+
+} // namespace uci
+} // namespace chess
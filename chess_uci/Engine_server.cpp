@@ -0,0 +1,137 @@
+#include "Engine_server.h"
+
+#include "Process_reaper.h"
+
+#include <boost/process/extend.hpp>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// How often to check whether engines have exited, while waiting for connections.
+constexpr std::chrono::milliseconds reap_interval{100};
+
+} // Anonymous namespace
+
+Engine_server::Engine_server(const std::filesystem::path& engine_executable, const Engine_endpoint& endpoint, size_t max_engines)
+	: engine_executable_(engine_executable)
+	, max_engines_(max_engines)
+{
+	// Make sure that the reaper outlives the server, also when both are static
+	Process_reaper::instance();
+	if (::pipe2(stop_pipe_, O_CLOEXEC) < 0)
+		throw std::runtime_error(std::string("Engine error: Can't create pipe: ") + std::strerror(errno));
+	try {
+		listener_ = listen_on(endpoint);
+		address_ = local_endpoint(listener_);
+	} catch (...) {
+		if (listener_ >= 0)
+			::close(listener_);
+		::close(stop_pipe_[0]);
+		::close(stop_pipe_[1]);
+		throw;
+	}
+}
+
+Engine_server::~Engine_server()
+{
+	::close(listener_);
+	if (address_.kind == Engine_endpoint::Kind::unix_socket)
+		::unlink(address_.location.c_str());
+	::close(stop_pipe_[0]);
+	::close(stop_pipe_[1]);
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto& engine : engines_)
+		Process_reaper::instance().reap(std::move(engine), Process_reaper::default_timeout);
+}
+
+const Engine_endpoint& Engine_server::address() const
+{
+	return address_;
+}
+
+void Engine_server::run()
+{
+	for (;;) {
+		reap_engines();
+		bool is_full = max_engines_ != 0 && num_engines() >= max_engines_;
+		pollfd fds[2] = {{stop_pipe_[0], POLLIN, 0}, {listener_, static_cast<short>(is_full ? 0 : POLLIN), 0}};
+		int result = ::poll(fds, 2, static_cast<int>(reap_interval.count()));
+		if (result < 0 && errno != EINTR)
+			throw std::runtime_error(std::string("Engine error: Can't wait for connections: ") + std::strerror(errno));
+		// The stop pipe is never read from, so that the server stays stopped
+		if (fds[0].revents != 0)
+			return;
+		if (result <= 0 || (fds[1].revents & POLLIN) == 0)
+			continue;
+
+		int connection = ::accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC);
+		if (connection < 0)
+			// E.g. the client gave up before the connection was accepted
+			continue;
+		if (address_.kind == Engine_endpoint::Kind::tcp) {
+			int no_delay = 1;
+			::setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+		}
+		try {
+			start_engine(connection);
+		} catch (const std::exception&) {
+			// The client sees the connection close without a reply, which Engine reports as an error
+		}
+		// The engine has its own copy of the connection
+		::close(connection);
+	}
+}
+
+void Engine_server::stop()
+{
+	char wake_up = 0;
+	[[maybe_unused]] auto written = ::write(stop_pipe_[1], &wake_up, 1);
+}
+
+size_t Engine_server::num_engines() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return engines_.size();
+}
+
+void Engine_server::start_engine(int connection)
+{
+	boost::process::child engine(
+		engine_executable_.string(),
+		boost::process::extend::on_exec_setup = [connection](auto&) {
+			// Let the engine use the connection as its standard input and output
+			::dup2(connection, STDIN_FILENO);
+			::dup2(connection, STDOUT_FILENO);
+		});
+	std::lock_guard<std::mutex> lock(mutex_);
+	engines_.push_back(std::move(engine));
+}
+
+void Engine_server::reap_engines()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	engines_.remove_if([](boost::process::child& engine) {
+		std::error_code error;
+		// running() also waits for an exited process, so that it doesn't linger as a zombie
+		return !engine.running(error) || error;
+	});
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,85 @@
+/**
+ * \file Engine_server.h
+ * \brief Contains a server making a UCI chess engine available on a Unix domain socket or TCP port.
+ */
+
+#pragma once
+
+#include "Engine_endpoint.h"
+
+#include <boost/process/child.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <mutex>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Engine_server
+ * \brief Serves an engine on a socket, starting a separate engine process for each connection.
+ *
+ * The engine reads its commands from, and writes its messages to, the connection directly, so the
+ * server adds nothing to the UCI communication. Connect to the server by giving its address to
+ * Engine (see Engine_endpoint). When the connection is closed the engine sees the end of its
+ * input and exits.
+ *
+ * This lets the engines run on another machine than the analysis, or in another container, and
+ * lets a crashing or hung engine be contained on the server side.
+ *
+ * run() serves connections until stop() is called. stop() may be called from any thread.
+ */
+class Engine_server
+{
+public:
+	/**
+	 * Start listening for connections.
+	 *
+	 * \param engine_executable Path to the engine executable to start for each connection.
+	 * \param endpoint Socket to listen on (see Engine_endpoint::unix_socket() and Engine_endpoint::tcp()).
+	 * A TCP port of 0 picks a free port, see address().
+	 * \param max_engines Maximum number of engines to run at the same time, or 0 for no limit. Further
+	 * connections wait until an engine has exited.
+	 * \throw std::runtime_error if listening fails.
+	 */
+	Engine_server(const std::filesystem::path& engine_executable, const Engine_endpoint& endpoint, size_t max_engines = 0);
+	/// Stop listening. Engines still serving a connection get Process_reaper::default_timeout to exit.
+	~Engine_server();
+
+	Engine_server(const Engine_server&) = delete;
+	Engine_server& operator=(const Engine_server&) = delete;
+
+	/// Address the server is listening on, to connect to.
+	const Engine_endpoint& address() const;
+
+	/// Serve connections until stop() is called.
+	void run();
+	/// Make run() return. Can be called from any thread, also before run() has been called.
+	void stop();
+
+	/// Number of engines currently running.
+	size_t num_engines() const;
+
+private:
+	/// Start an engine for an accepted connection.
+	void start_engine(int connection);
+	/// Forget the engines which have exited.
+	void reap_engines();
+
+	std::filesystem::path engine_executable_;
+	size_t max_engines_;
+	/// Socket listening for connections.
+	int listener_{-1};
+	/// Pipe written to by stop(), to wake up run().
+	int stop_pipe_[2]{-1, -1};
+	Engine_endpoint address_;
+
+	mutable std::mutex mutex_;
+	/// Processes of the engines serving connections.
+	std::list<boost::process::child> engines_;
+};
+
+} // namespace uci
+} // namespace chess
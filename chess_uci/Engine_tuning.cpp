@@ -0,0 +1,88 @@
+#include "Engine_tuning.h"
+
+#include "Engine.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace chess {
+namespace uci {
+
+std::vector<Thread_split> candidate_splits(unsigned num_cores)
+{
+	std::vector<Thread_split> splits;
+	for (unsigned threads = num_cores; threads >= 1; --threads)
+		if (num_cores % threads == 0)
+			splits.push_back({num_cores / threads, threads});
+	return splits;
+}
+
+double measure_split(
+	const std::filesystem::path& engine_executable,
+	const Thread_split& split,
+	std::chrono::milliseconds measure_time,
+	const std::string& fen)
+{
+	std::vector<std::unique_ptr<Engine>> engines;
+	// Latest number of searched nodes reported by each engine. Only written by the engine's output
+	// reader, and read once the calculation has finished.
+	std::vector<uint64_t> nodes(split.num_engines, 0);
+	for (size_t i = 0; i < split.num_engines; ++i) {
+		engines.push_back(std::make_unique<Engine>(engine_executable));
+		Engine& engine = *engines.back();
+		// Engines which don't support threads only run one
+		if (split.threads_per_engine != 1 || engine.find_option("Threads") != nullptr)
+			engine.set_threads(split.threads_per_engine);
+		engine.set_info_callback([&nodes, i](const Info& info) {
+			if (info.nodes.has_value())
+				nodes[i] = *info.nodes;
+		});
+		engine.set_position_from_fen(fen);
+		// Make sure that the engine has set up its threads before the measurement starts
+		engine.wait_until_ready();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (auto& engine : engines)
+		engine->start_calculating(Search_limits::for_move_time(measure_time));
+	for (auto& engine : engines)
+		engine->wait_for_result();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	uint64_t total_nodes = 0;
+	for (uint64_t engine_nodes : nodes)
+		total_nodes += engine_nodes;
+	return elapsed.count() > 0 ? static_cast<double>(total_nodes) / elapsed.count() : 0.0;
+}
+
+Tuning_result tune_thread_split(
+	const std::filesystem::path& engine_executable,
+	unsigned num_cores,
+	std::chrono::milliseconds measure_time,
+	const std::string& fen)
+{
+	if (num_cores == 0)
+		num_cores = std::max(1u, std::thread::hardware_concurrency());
+
+	Tuning_result result;
+	for (const Thread_split& split : candidate_splits(num_cores)) {
+		try {
+			result.measurements.push_back({split, measure_split(engine_executable, split, measure_time, fen)});
+		} catch (const std::invalid_argument&) {
+			// The engine doesn't support this many threads
+		}
+	}
+	if (result.measurements.empty())
+		throw std::runtime_error("Engine error: No thread split could be measured");
+
+	auto best = std::max_element(result.measurements.begin(), result.measurements.end(), [](const Split_measurement& lhs, const Split_measurement& rhs) {
+		return lhs.nodes_per_second < rhs.nodes_per_second;
+	});
+	result.best = best->split;
+	return result;
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,94 @@
+/**
+ * \file Engine_tuning.h
+ * \brief Contains functions to find how to best split the cores of a machine between engines.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/// Split of the cores of a machine into engine processes, each using a number of search threads.
+struct Thread_split
+{
+	/// Number of engine processes.
+	size_t num_engines{1};
+	/// Number of search threads per engine (the 'Threads' option).
+	unsigned threads_per_engine{1};
+};
+
+/// Measured throughput of a thread split.
+struct Split_measurement
+{
+	Thread_split split;
+	/// Total number of nodes searched per second by all engines together.
+	double nodes_per_second{0};
+};
+
+/// Result of tune_thread_split().
+struct Tuning_result
+{
+	/// Measurements of all splits that were tried, in the order they were tried.
+	std::vector<Split_measurement> measurements;
+	/// Split with the highest total throughput.
+	Thread_split best;
+};
+
+/**
+ * Get the splits of the given number of cores into engines and threads per engine which use all
+ * cores, i.e. where the number of engines times the number of threads is the number of cores.
+ *
+ * \param num_cores Number of cores to use.
+ * \return Splits, ordered from one engine using all cores to one engine per core.
+ */
+std::vector<Thread_split> candidate_splits(unsigned num_cores);
+
+/**
+ * Measure the total throughput of running engines according to the given split.
+ *
+ * All engines search the given position at the same time, for the given time, and the throughput
+ * is the sum of the nodes the engines report to have searched, divided by the time it took.
+ *
+ * \param engine_executable Path to the engine executable.
+ * \param split Number of engines and threads per engine to run.
+ * \param measure_time Time each engine searches.
+ * \param fen Position to search, specified as a Forsyth-Edwards Notation (FEN) string.
+ * \return Total number of nodes searched per second.
+ * \throw std::invalid_argument if the engine doesn't support the number of threads.
+ */
+double measure_split(
+	const std::filesystem::path& engine_executable,
+	const Thread_split& split,
+	std::chrono::milliseconds measure_time,
+	const std::string& fen);
+
+/**
+ * Find the split of the cores of this machine into engine processes and threads per engine which
+ * gives the highest total throughput.
+ *
+ * Engines typically search fewer nodes per thread the more threads they use, but running many
+ * engines uses more memory and may compete for caches, so the best split depends on both the
+ * engine and the machine. Each candidate split (see candidate_splits()) is measured in turn with
+ * measure_split(). Splits with more threads per engine than the engine supports are skipped.
+ *
+ * \param engine_executable Path to the engine executable.
+ * \param num_cores Number of cores to use. If 0, all cores of the machine are used.
+ * \param measure_time Time to search with each split.
+ * \param fen Position to search, specified as a Forsyth-Edwards Notation (FEN) string. Should be
+ * a typical position for the analysis the engines will be used for.
+ * \return All measurements, and the best split.
+ */
+Tuning_result tune_thread_split(
+	const std::filesystem::path& engine_executable,
+	unsigned num_cores = 0,
+	std::chrono::milliseconds measure_time = std::chrono::seconds(2),
+	const std::string& fen = "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+
+} // namespace uci
+} // namespace chess
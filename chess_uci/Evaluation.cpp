@@ -1,5 +1,6 @@
 #include "Evaluation.h"
 
+#include <cstring>
 #include <stdexcept>
 
 namespace chess {
@@ -7,53 +8,145 @@ namespace uci {
 
 namespace {
 
-std::string centi_pawns_to_string(int16_t cp)
+/// Centi pawn evaluations with the same value are ordered upper bound < exact < lower bound.
+enum class Bound : uint32_t
+{
+	upper = 0,
+	exact = 1,
+	lower = 2
+};
+
+constexpr uint32_t pack(Packed_evaluation::Kind kind, uint32_t value)
+{
+	return (static_cast<uint32_t>(kind) << 24) | value;
+}
+
+constexpr uint32_t pack_centi_pawns(int16_t cp, Bound bound)
+{
+	return pack(Packed_evaluation::Kind::centi_pawns, (static_cast<uint32_t>(cp + 32768) << 2) | static_cast<uint32_t>(bound));
+}
+
+/// Append a string literal to the buffer [first, last), or return nullptr if it doesn't fit.
+char* append(char* first, char* last, const char* text)
+{
+	size_t length = std::strlen(text);
+	if (first == nullptr || static_cast<size_t>(last - first) < length)
+		return nullptr;
+	std::memcpy(first, text, length);
+	return first + length;
+}
+
+/// Append an integer to the buffer [first, last), or return nullptr if it doesn't fit.
+char* append(char* first, char* last, int value)
+{
+	if (first == nullptr)
+		return nullptr;
+	auto result = std::to_chars(first, last, value);
+	return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+char* centi_pawns_to_chars(char* first, char* last, int cp)
 {
 	if (cp == 0)
-		return "0.00";
-	std::string str = std::to_string(cp / 100) + ".";
-	int16_t decimals = cp % 100;
-	if (decimals < 0)
-		decimals = -decimals;
-	if (decimals < 10) {
-		if (decimals == 0)
-			str += "00";
-		else
-			str += "0" + std::to_string(decimals);
-	} else {
-		str += std::to_string(decimals);
-	}
-	if (cp > 0)
-		return "+" + str;
-	else
-		return str;
+		return append(first, last, "0.00");
+	first = append(first, last, cp > 0 ? "+" : "-");
+	int magnitude = cp > 0 ? cp : -cp;
+	first = append(first, last, magnitude / 100);
+	first = append(first, last, ".");
+	if (magnitude % 100 < 10)
+		first = append(first, last, "0");
+	return append(first, last, magnitude % 100);
 }
 
 } // Anonymous namespace
 
 std::string to_string(const Evaluation& evaluation)
 {
-	if (evaluation.centi_pawns.has_value()) {
-		return centi_pawns_to_string(*evaluation.centi_pawns);
-	}
+	Packed_evaluation packed(evaluation);
+	if (packed.kind() == Packed_evaluation::Kind::none)
+		throw std::runtime_error("Cannot convert evaluation to string: No evaluation info");
 
-	if (evaluation.centi_pawns_lower_bound.has_value()) {
-		return ">= " + centi_pawns_to_string(*evaluation.centi_pawns_lower_bound);
-	}
+	char buffer[max_evaluation_string_length];
+	auto result = to_chars(buffer, buffer + sizeof(buffer), packed);
+	return std::string(buffer, result.ptr);
+}
 
-	if (evaluation.centi_pawns_upper_bound.has_value()) {
-		return "<= " + centi_pawns_to_string(*evaluation.centi_pawns_upper_bound);
-	}
+Packed_evaluation::Packed_evaluation(const Evaluation& evaluation)
+{
+	if (evaluation.centi_pawns.has_value())
+		bits_ = pack_centi_pawns(*evaluation.centi_pawns, Bound::exact);
+	else if (evaluation.centi_pawns_lower_bound.has_value())
+		bits_ = pack_centi_pawns(*evaluation.centi_pawns_lower_bound, Bound::lower);
+	else if (evaluation.centi_pawns_upper_bound.has_value())
+		bits_ = pack_centi_pawns(*evaluation.centi_pawns_upper_bound, Bound::upper);
+	else if (evaluation.white_can_mate_in.has_value())
+		// Mating in fewer moves is better for white
+		bits_ = pack(Kind::white_can_mate, 255 - *evaluation.white_can_mate_in);
+	else if (evaluation.black_can_mate_in.has_value())
+		// Being mated in more moves is better for white
+		bits_ = pack(Kind::black_can_mate, *evaluation.black_can_mate_in);
+}
 
-	if (evaluation.white_can_mate_in.has_value()) {
-		return "White mate in " + std::to_string(*evaluation.white_can_mate_in);
+Evaluation Packed_evaluation::to_evaluation() const
+{
+	Evaluation evaluation;
+	uint32_t value = bits_ & 0xffffff;
+	switch (kind()) {
+	case Kind::none:
+		break;
+	case Kind::black_can_mate:
+		evaluation.black_can_mate_in = static_cast<uint8_t>(value);
+		break;
+	case Kind::white_can_mate:
+		evaluation.white_can_mate_in = static_cast<uint8_t>(255 - value);
+		break;
+	case Kind::centi_pawns: {
+		int16_t cp = static_cast<int16_t>(static_cast<int32_t>(value >> 2) - 32768);
+		switch (static_cast<Bound>(value & 3)) {
+		case Bound::upper:
+			evaluation.centi_pawns_upper_bound = cp;
+			break;
+		case Bound::lower:
+			evaluation.centi_pawns_lower_bound = cp;
+			break;
+		default:
+			evaluation.centi_pawns = cp;
+			break;
+		}
+		break;
 	}
-
-	if (evaluation.black_can_mate_in.has_value()) {
-		return "Black mate in " + std::to_string(*evaluation.black_can_mate_in);
 	}
+	return evaluation;
+}
 
-	throw std::runtime_error("Cannot convert evaluation to string: No evaluation info");
+std::to_chars_result to_chars(char* first, char* last, Packed_evaluation evaluation)
+{
+	char* end = nullptr;
+	uint32_t value = evaluation.bits() & 0xffffff;
+	switch (evaluation.kind()) {
+	case Packed_evaluation::Kind::none:
+		return {first, std::errc::invalid_argument};
+	case Packed_evaluation::Kind::black_can_mate:
+		end = append(append(first, last, "Black mate in "), last, static_cast<int>(value));
+		break;
+	case Packed_evaluation::Kind::white_can_mate:
+		end = append(append(first, last, "White mate in "), last, static_cast<int>(255 - value));
+		break;
+	case Packed_evaluation::Kind::centi_pawns: {
+		int cp = static_cast<int>(value >> 2) - 32768;
+		Bound bound = static_cast<Bound>(value & 3);
+		end = first;
+		if (bound == Bound::lower)
+			end = append(end, last, ">= ");
+		else if (bound == Bound::upper)
+			end = append(end, last, "<= ");
+		end = centi_pawns_to_chars(end, last, cp);
+		break;
+	}
+	}
+	if (end == nullptr)
+		return {last, std::errc::value_too_large};
+	return {end, std::errc()};
 }
 
 } // namespace uci
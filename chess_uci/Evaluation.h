@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <string>
 
@@ -30,5 +33,105 @@ struct Evaluation
 /// Utility function to convert an engine evaluation to a human readable string.
 std::string to_string(const Evaluation& evaluation);
 
+/**
+ * \class Packed_evaluation
+ * \brief Engine evaluation packed into 32 bits, ordered from worst to best for white.
+ *
+ * The top 8 bits hold the kind of evaluation and the lower 24 bits its value, encoded so that
+ * comparing the packed values orders the evaluations: black mating (in few moves before many
+ * moves) < centi pawn evaluations < white mating (in many moves before few moves). Centi pawn
+ * evaluations with the same value are ordered upper bound < exact < lower bound. An empty
+ * evaluation sorts below all others.
+ */
+class Packed_evaluation
+{
+public:
+	/// Kind of evaluation, stored in the top 8 bits.
+	enum class Kind : uint8_t
+	{
+		none = 0,
+		black_can_mate = 1,
+		centi_pawns = 2,
+		white_can_mate = 3
+	};
+
+	/// Construct an empty evaluation.
+	constexpr Packed_evaluation() = default;
+	/**
+	 * Pack an evaluation.
+	 *
+	 * \param evaluation Evaluation with at most one entry set. If more entries are set, the one
+	 * that to_string() would show is used.
+	 */
+	explicit Packed_evaluation(const Evaluation& evaluation);
+
+	/// Construct an evaluation from its packed representation (see bits()).
+	static constexpr Packed_evaluation from_bits(uint32_t bits)
+	{
+		Packed_evaluation evaluation;
+		evaluation.bits_ = bits;
+		return evaluation;
+	}
+
+	/// Unpack the evaluation.
+	Evaluation to_evaluation() const;
+
+	/// Kind of evaluation.
+	constexpr Kind kind() const
+	{
+		return static_cast<Kind>(bits_ >> 24);
+	}
+	/// Packed representation of the evaluation.
+	constexpr uint32_t bits() const
+	{
+		return bits_;
+	}
+
+	constexpr bool operator==(Packed_evaluation other) const
+	{
+		return bits_ == other.bits_;
+	}
+	constexpr bool operator!=(Packed_evaluation other) const
+	{
+		return bits_ != other.bits_;
+	}
+	constexpr bool operator<(Packed_evaluation other) const
+	{
+		return bits_ < other.bits_;
+	}
+	constexpr bool operator>(Packed_evaluation other) const
+	{
+		return bits_ > other.bits_;
+	}
+	constexpr bool operator<=(Packed_evaluation other) const
+	{
+		return bits_ <= other.bits_;
+	}
+	constexpr bool operator>=(Packed_evaluation other) const
+	{
+		return bits_ >= other.bits_;
+	}
+
+private:
+	uint32_t bits_{0};
+};
+
+static_assert(sizeof(Packed_evaluation) == 4, "Packed_evaluation should be packed into 32 bits");
+
+/// Maximum number of characters written by to_chars(char*, char*, Packed_evaluation).
+constexpr size_t max_evaluation_string_length = 17;
+
+/**
+ * Write an engine evaluation as a human readable string (same format as to_string()) to the given
+ * buffer, without allocating any memory.
+ *
+ * \param first Start of the buffer.
+ * \param last End of the buffer.
+ * \return Pointer one past the last written character. The error code is
+ * std::errc::value_too_large if the buffer is too small, and std::errc::invalid_argument if the
+ * evaluation is empty.
+ */
+std::to_chars_result to_chars(char* first, char* last, Packed_evaluation evaluation);
+
 } // namespace uci
 } // namespace chess
@@ -0,0 +1,28 @@
+#include "Fen.h"
+
+namespace chess {
+namespace uci {
+
+std::string normalize_fen(std::string_view fen)
+{
+	std::string normalized;
+	normalized.reserve(fen.size());
+	size_t num_fields = 0;
+	size_t begin = 0;
+	while (begin < fen.size() && num_fields < 4) {
+		size_t end = fen.find_first_of(" \t", begin);
+		if (end == std::string_view::npos)
+			end = fen.size();
+		if (end > begin) {
+			if (num_fields > 0)
+				normalized += ' ';
+			normalized.append(fen.substr(begin, end - begin));
+			num_fields += 1;
+		}
+		begin = end + 1;
+	}
+	return normalized;
+}
+
+} // namespace uci
+} // namespace chess
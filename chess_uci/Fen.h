@@ -0,0 +1,27 @@
+/**
+ * \file Fen.h
+ * \brief Utilities for working with positions given in Forsyth-Edwards Notation (FEN).
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace chess {
+namespace uci {
+
+/**
+ * Normalize a FEN string, so that equal positions get equal strings.
+ *
+ * Keeps the piece placement, side to move, castling rights and en passant square, separated by
+ * single spaces, and drops the half move clock and full move number since they don't change
+ * which position it is.
+ *
+ * \param fen Position in Forsyth-Edwards Notation.
+ * \return Normalized position.
+ */
+std::string normalize_fen(std::string_view fen);
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,147 @@
+#include "Game_analysis.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// Moves of a game joined into a single string, which the moves up to any ply are a prefix of.
+class Game_moves
+{
+public:
+	explicit Game_moves(const std::vector<std::string>& moves)
+	{
+		prefix_ends_.reserve(moves.size() + 1);
+		prefix_ends_.push_back(0);
+		for (const std::string& move : moves) {
+			if (!lan_.empty())
+				lan_ += ' ';
+			lan_ += move;
+			prefix_ends_.push_back(lan_.size());
+		}
+	}
+
+	/// Number of positions in the game, i.e. one more than the number of moves.
+	size_t num_positions() const
+	{
+		return prefix_ends_.size();
+	}
+
+	/// Moves played to reach the position after the given number of moves, separated by spaces.
+	std::string moves_to(size_t ply) const
+	{
+		return lan_.substr(0, prefix_ends_[ply]);
+	}
+
+private:
+	std::string lan_;
+	/// End of the moves up to each ply in lan_.
+	std::vector<size_t> prefix_ends_;
+};
+
+void check_limits(const Search_limits& limits)
+{
+	if (!limits.is_finite())
+		throw std::invalid_argument("Game analysis error: Can't analyze positions without limits");
+}
+
+/// Analyze the positions in [begin_ply, end_ply) on the engine, from the last towards the first,
+/// storing the results in the corresponding entries of analysis.
+void analyze_plies(
+	Engine& engine,
+	const Game_moves& moves,
+	size_t begin_ply,
+	size_t end_ply,
+	const Search_limits& limits,
+	const std::string& start_fen,
+	Ply_analysis* analysis)
+{
+	// The only reset, so that the engine keeps what it learns from one position to the next
+	engine.new_game();
+	for (size_t ply = end_ply; ply-- > begin_ply;) {
+		if (start_fen.empty())
+			engine.set_position_from_moves(moves.moves_to(ply));
+		else
+			engine.set_position_from_fen(start_fen, moves.moves_to(ply));
+		engine.start_calculating(limits);
+		engine.wait_for_result();
+
+		Ply_analysis& ply_analysis = analysis[ply - begin_ply];
+		ply_analysis.ply = ply;
+		ply_analysis.lines = engine.get_top_suggested_move_sequences();
+		if (!ply_analysis.lines.empty())
+			ply_analysis.evaluation = ply_analysis.lines.front().evaluation;
+		ply_analysis.best_move = engine.get_best_move();
+	}
+}
+
+} // Anonymous namespace
+
+std::vector<Ply_analysis> analyze_game(
+	Engine& engine,
+	const std::vector<std::string>& moves,
+	const Search_limits& per_ply_limits,
+	const std::string& start_fen)
+{
+	check_limits(per_ply_limits);
+	Game_moves game_moves(moves);
+	std::vector<Ply_analysis> analysis(game_moves.num_positions());
+	analyze_plies(engine, game_moves, 0, analysis.size(), per_ply_limits, start_fen, analysis.data());
+	return analysis;
+}
+
+std::vector<Ply_analysis> analyze_game(
+	Engine_pool& pool,
+	const std::vector<std::string>& moves,
+	const Search_limits& per_ply_limits,
+	const std::string& start_fen)
+{
+	check_limits(per_ply_limits);
+	// Shared with the tasks, which only touch their own stretch of the analysis
+	auto game_moves = std::make_shared<Game_moves>(moves);
+	size_t num_positions = game_moves->num_positions();
+	std::vector<Ply_analysis> analysis(num_positions);
+
+	// Split the game into stretches of about equal length, one per engine
+	size_t num_stretches = std::min(pool.size(), num_positions);
+	std::vector<std::future<void>> stretches_done;
+	stretches_done.reserve(num_stretches);
+	for (size_t i = 0; i < num_stretches; ++i) {
+		size_t begin_ply = i * num_positions / num_stretches;
+		size_t end_ply = (i + 1) * num_positions / num_stretches;
+		auto done = std::make_shared<std::promise<void>>();
+		stretches_done.push_back(done->get_future());
+		Ply_analysis* stretch_analysis = analysis.data() + begin_ply;
+		pool.execute([=](Engine& engine) {
+			try {
+				analyze_plies(engine, *game_moves, begin_ply, end_ply, per_ply_limits, start_fen, stretch_analysis);
+				done->set_value();
+			} catch (...) {
+				done->set_exception(std::current_exception());
+			}
+		});
+	}
+
+	// Wait for all stretches before reporting any error, since they write to the analysis
+	std::exception_ptr error;
+	for (auto& done : stretches_done) {
+		try {
+			done.get();
+		} catch (...) {
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+	if (error)
+		std::rethrow_exception(error);
+	return analysis;
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,89 @@
+/**
+ * \file Game_analysis.h
+ * \brief Contains functions to analyze every position of a game.
+ */
+
+#pragma once
+
+#include "Engine.h"
+#include "Engine_pool.h"
+#include "Evaluation.h"
+#include "Line.h"
+#include "Parse_messages.h"
+#include "Search_limits.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/// Analysis of a single position of a game.
+struct Ply_analysis
+{
+	/// Number of moves played to reach the position, i.e. 0 for the position the game starts from.
+	size_t ply{0};
+	/// Evaluation of the position, i.e. of the best line. Empty if the position has no legal moves.
+	Evaluation evaluation;
+	/// Top suggested lines from the position, best first.
+	std::vector<Analyzed_line> lines;
+	/// Best move in the position, together with the expected reply if any.
+	std::optional<Best_move> best_move;
+};
+
+/**
+ * Analyze every position of a game on a single engine.
+ *
+ * The positions are analyzed from the end of the game towards the start, within a single game as
+ * far as the engine is concerned. Analyzing a position fills the engine hash table with the
+ * positions that can follow it, so going backwards means that each position is analyzed with the
+ * results of the positions later in the game already at hand, which gives deeper analysis in the
+ * same time. The engine is only told that a new game starts once, before the first position,
+ * rather than being reset for each position.
+ *
+ * \param engine Engine to use. It shouldn't be calculating.
+ * \param moves Moves of the game in long algebraic notation.
+ * \param per_ply_limits Limits for the analysis of each position. Must be finite (see
+ * Search_limits::is_finite()).
+ * \param start_fen Position the game starts from, specified as a Forsyth-Edwards Notation (FEN)
+ * string, or empty for the standard starting position.
+ * \return Analysis of each position, ordered by ply, i.e. one more entry than there are moves.
+ * \throw std::invalid_argument if the limits aren't finite.
+ * \throw std::runtime_error if the engine fails.
+ */
+std::vector<Ply_analysis> analyze_game(
+	Engine& engine,
+	const std::vector<std::string>& moves,
+	const Search_limits& per_ply_limits,
+	const std::string& start_fen = "");
+
+/**
+ * Analyze every position of a game, split across the engines of a pool.
+ *
+ * The game is split into one stretch of consecutive positions per engine, each of which is
+ * analyzed from its end towards its start as by analyze_game(Engine&, const std::vector<std::string>&,
+ * const Search_limits&, const std::string&). Keeping the positions of a stretch together on one
+ * engine keeps most of the benefit of the hash table, while the wall time is divided by the number
+ * of engines.
+ *
+ * Blocks until the whole game has been analyzed. The stretches are queued like any other task of
+ * the pool (see Engine_pool::execute()).
+ *
+ * \param pool Engines to use.
+ * \param moves Moves of the game in long algebraic notation.
+ * \param per_ply_limits Limits for the analysis of each position. Must be finite.
+ * \param start_fen Position the game starts from, or empty for the standard starting position.
+ * \return Analysis of each position, ordered by ply.
+ * \throw std::invalid_argument if the limits aren't finite.
+ * \throw std::runtime_error if any of the engines fails.
+ */
+std::vector<Ply_analysis> analyze_game(
+	Engine_pool& pool,
+	const std::vector<std::string>& moves,
+	const Search_limits& per_ply_limits,
+	const std::string& start_fen = "");
+
+} // namespace uci
+} // namespace chess
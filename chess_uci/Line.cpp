@@ -0,0 +1,17 @@
+#include "Line.h"
+
+namespace chess {
+namespace uci {
+
+Compact_analyzed_line to_compact_line(const Analyzed_line& line)
+{
+	return {Move_sequence::from_strings(line.moves), Packed_evaluation(line.evaluation)};
+}
+
+Analyzed_line to_analyzed_line(const Compact_analyzed_line& line)
+{
+	return {line.moves.to_strings(), line.evaluation.to_evaluation()};
+}
+
+} // namespace uci
+} // namespace chess
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Evaluation.h"
+#include "Move.h"
+
 #include <string>
 #include <vector>
 
@@ -15,5 +18,27 @@ struct Analyzed_line
 	Evaluation evaluation;
 };
 
+/// Analyzed line with the moves and evaluation stored in packed form, for storing large numbers of
+/// lines without any memory allocations per line or move.
+struct Compact_analyzed_line
+{
+	/// Sequence of suggested best moves.
+	Move_sequence moves;
+	/// Evaluation of the suggested game continuation.
+	Packed_evaluation evaluation;
+};
+
+/**
+ * Convert an analyzed line to compact form.
+ *
+ * \param line Analyzed line.
+ * \return Line with packed moves. Moves beyond Move_sequence::capacity are dropped.
+ * \throw std::runtime_error if any of the moves isn't in long algebraic notation.
+ */
+Compact_analyzed_line to_compact_line(const Analyzed_line& line);
+
+/// Convert a compact analyzed line back to an analyzed line with moves in long algebraic notation.
+Analyzed_line to_analyzed_line(const Compact_analyzed_line& line);
+
 } // namespace uci
 } // namespace chess
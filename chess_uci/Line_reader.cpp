@@ -0,0 +1,138 @@
+#include "Line_reader.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <system_error>
+
+namespace chess {
+namespace uci {
+
+Line_buffer::Line_buffer(size_t initial_capacity)
+	: buffer_(initial_capacity > 0 ? initial_capacity : 1)
+{}
+
+std::optional<std::string_view> Line_buffer::next_line()
+{
+	const char* data = buffer_.data();
+	const void* newline = std::memchr(data + scan_, '\n', end_ - scan_);
+	if (newline == nullptr) {
+		// Don't look through the same bytes again when more bytes have been received
+		scan_ = end_;
+		return std::nullopt;
+	}
+	size_t line_end = static_cast<const char*>(newline) - data;
+	std::string_view line(data + begin_, line_end - begin_);
+	begin_ = line_end + 1;
+	scan_ = begin_;
+	return line;
+}
+
+char* Line_buffer::prepare()
+{
+	if (end_ == buffer_.size()) {
+		if (begin_ > 0) {
+			// Reclaim the space used by lines which have already been handed out
+			std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+			scan_ -= begin_;
+			end_ -= begin_;
+			begin_ = 0;
+		} else {
+			// The current line fills the whole buffer
+			buffer_.resize(2 * buffer_.size());
+		}
+	}
+	return buffer_.data() + end_;
+}
+
+size_t Line_buffer::writable_size() const
+{
+	return buffer_.size() - end_;
+}
+
+void Line_buffer::commit(size_t num_bytes)
+{
+	end_ += num_bytes;
+}
+
+std::string_view Line_buffer::take_remaining()
+{
+	std::string_view remaining(buffer_.data() + begin_, end_ - begin_);
+	begin_ = end_;
+	scan_ = end_;
+	return remaining;
+}
+
+Line_reader::Line_reader(int fd, size_t initial_capacity)
+	: fd_(fd)
+	, buffer_(initial_capacity)
+{}
+
+std::optional<std::string_view> Line_reader::read_line()
+{
+	std::string_view line;
+	if (read_line(std::chrono::steady_clock::time_point::max(), line) == Status::end_of_stream)
+		return std::nullopt;
+	return line;
+}
+
+Line_reader::Status Line_reader::read_line(std::chrono::steady_clock::time_point deadline, std::string_view& line)
+{
+	while (true) {
+		if (auto next_line = buffer_.next_line()) {
+			line = *next_line;
+			return Status::line;
+		}
+		if (end_of_stream_) {
+			// Hand out a final line which isn't terminated by a newline
+			std::string_view remaining = buffer_.take_remaining();
+			if (remaining.empty())
+				return Status::end_of_stream;
+			line = remaining;
+			return Status::line;
+		}
+
+		// Wait for more bytes to arrive, at most until the deadline
+		int timeout = -1;
+		if (deadline != std::chrono::steady_clock::time_point::max()) {
+			auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+			timeout = static_cast<int>(std::clamp<int64_t>(remaining.count(), 0, std::numeric_limits<int>::max()));
+		}
+		pollfd poll_fd{fd_, POLLIN, 0};
+		int num_ready = ::poll(&poll_fd, 1, timeout);
+		if (num_ready < 0) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category(), "Error waiting for engine output");
+		}
+		if (num_ready == 0) {
+			if (std::chrono::steady_clock::now() >= deadline)
+				return Status::timeout;
+			continue;
+		}
+
+		char* destination = buffer_.prepare();
+		ssize_t num_read = ::read(fd_, destination, buffer_.writable_size());
+		if (num_read < 0) {
+			if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+				continue;
+			throw std::system_error(errno, std::generic_category(), "Error reading engine output");
+		}
+		if (num_read == 0)
+			end_of_stream_ = true;
+		buffer_.commit(static_cast<size_t>(num_read));
+	}
+}
+
+int Line_reader::fd() const
+{
+	return fd_;
+}
+
+} // namespace uci
+} // namespace chess
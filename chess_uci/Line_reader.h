@@ -0,0 +1,127 @@
+/**
+ * \file Line_reader.h
+ * \brief Read engine messages line by line directly from a file descriptor, without copying them.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Line_buffer
+ * \brief Reusable buffer which splits a stream of received bytes into lines.
+ *
+ * Received bytes are written directly into the buffer (see prepare() and commit()), and complete
+ * lines are then handed out as views into the buffer (see next_line()). Consumed lines are
+ * reclaimed by moving the remaining partial line to the start of the buffer when it runs out of
+ * space, so the buffer only grows if a single line doesn't fit in it.
+ */
+class Line_buffer
+{
+public:
+	/// \param initial_capacity Initial size of the buffer in bytes.
+	explicit Line_buffer(size_t initial_capacity = 64 * 1024);
+
+	/**
+	 * Get the next complete line from the buffer.
+	 *
+	 * \return The next line, without the final newline character, or nullopt if the buffer
+	 * doesn't contain a complete line. The returned view is valid until the next call to prepare().
+	 */
+	std::optional<std::string_view> next_line();
+
+	/**
+	 * Get the part of the buffer which received bytes should be written to.
+	 *
+	 * \return Pointer to the free space at the end of the buffer. The free space is at least
+	 * writable_size() bytes, and always at least one byte.
+	 */
+	char* prepare();
+	/// Size of the free space returned by the last call to prepare().
+	size_t writable_size() const;
+	/// Mark the given number of bytes, written to the space returned by prepare(), as received.
+	void commit(size_t num_bytes);
+
+	/// Get and consume what's left in the buffer when no more bytes will be received.
+	std::string_view take_remaining();
+
+private:
+	std::vector<char> buffer_;
+	/// Start of the received bytes which haven't been handed out yet.
+	size_t begin_{0};
+	/// Position from which to continue looking for the end of the current line.
+	size_t scan_{0};
+	/// End of the received bytes.
+	size_t end_{0};
+};
+
+/**
+ * \class Line_reader
+ * \brief Reads lines from a file descriptor (e.g. the read end of a pipe connected to the
+ * standard output of an engine process).
+ *
+ * Blocks in poll() while waiting for more output, so that waiting for a slow or dead engine
+ * doesn't use any CPU. To not wait forever for an engine which has hung, read with a deadline.
+ * The file descriptor is not owned by the reader.
+ */
+class Line_reader
+{
+public:
+	/// Outcome of reading a line with a deadline.
+	enum class Status
+	{
+		/// A line has been read.
+		line,
+		/// The end of the stream has been reached.
+		end_of_stream,
+		/// The deadline passed before a complete line was available.
+		timeout
+	};
+
+	/**
+	 * \param fd File descriptor to read from.
+	 * \param initial_capacity Initial size of the read buffer in bytes.
+	 */
+	explicit Line_reader(int fd, size_t initial_capacity = 64 * 1024);
+
+	/**
+	 * Read the next line, blocking until a complete line is available.
+	 *
+	 * \return The next line, without the final newline character, or nullopt when the end of the
+	 * stream has been reached. The returned view is valid until the next call to read_line().
+	 * \throw std::system_error if reading fails.
+	 */
+	std::optional<std::string_view> read_line();
+	/**
+	 * Read the next line, blocking until a complete line is available or the deadline has passed.
+	 *
+	 * Lines which have already been received are handed out even if the deadline has passed. After a
+	 * timeout the reader can be used as before, and a partially received line is kept.
+	 *
+	 * \param deadline When to give up waiting.
+	 * \param line Set to the next line, without the final newline character, if one has been read.
+	 * The view is valid until the next call to read_line().
+	 * \return Whether a line has been read, the end of the stream has been reached or the deadline passed.
+	 * \throw std::system_error if reading fails.
+	 */
+	Status read_line(std::chrono::steady_clock::time_point deadline, std::string_view& line);
+
+	/// File descriptor read from.
+	int fd() const;
+
+private:
+	int fd_;
+	Line_buffer buffer_;
+	/// Whether or not the end of the stream has been reached.
+	bool end_of_stream_{false};
+};
+
+} // namespace uci
+} // namespace chess
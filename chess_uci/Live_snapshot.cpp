@@ -0,0 +1,18 @@
+#include "Live_snapshot.h"
+
+namespace chess {
+namespace uci {
+
+std::vector<Analyzed_line> Live_snapshot::to_analyzed_lines() const
+{
+	std::vector<Analyzed_line> analyzed_lines;
+	for (size_t i = 0; i < num_lines && i < max_lines; ++i) {
+		if (lines[i].moves.empty())
+			continue;
+		analyzed_lines.push_back(to_analyzed_line({lines[i].moves, lines[i].evaluation}));
+	}
+	return analyzed_lines;
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,80 @@
+/**
+ * \file Live_snapshot.h
+ * \brief Contains the progress of a running engine calculation, in a form which can be copied
+ * between threads without locking.
+ */
+
+#pragma once
+
+#include "Evaluation.h"
+#include "Line.h"
+#include "Move.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/// Latest line for a multipv slot of a running calculation.
+struct Live_line
+{
+	/// Suggested moves. Moves beyond Move_sequence::capacity are dropped.
+	Move_sequence moves;
+	/// Evaluation of the line.
+	Packed_evaluation evaluation;
+	/// Search depth in plies at which the line was found.
+	uint16_t depth{0};
+};
+
+/**
+ * \struct Live_snapshot
+ * \brief Progress of an engine calculation, as reported by the engine so far.
+ *
+ * Holds no pointers (the lines are stored inline), so it can be shared through a Seqlock and read
+ * from other threads while the engine is calculating (see Engine::get_live_snapshot()).
+ */
+struct Live_snapshot
+{
+	/// Maximum number of lines in a snapshot. Further multipv slots are left out.
+	static constexpr size_t max_lines = 8;
+
+	/// Number of calculations started on the engine, including the one the snapshot belongs to,
+	/// or 0 if no calculation has been started.
+	uint64_t calculation{0};
+	/// Number of times the snapshot has been updated during the calculation.
+	uint64_t num_updates{0};
+	/// Whether or not the engine is still calculating. Otherwise the snapshot holds the final result.
+	bool is_calculating{false};
+	/// Whether or not the calculation was stopped early since its result had converged (see
+	/// Engine::set_convergence_policy()). Only set once the calculation has finished.
+	bool stopped_early{false};
+	/// Latest search depth in plies.
+	uint16_t depth{0};
+	/// Latest selective search depth in plies.
+	uint16_t selective_depth{0};
+	/// How full the engine hash table is, in permill.
+	uint16_t hash_full{0};
+	/// Number of nodes searched.
+	uint64_t nodes{0};
+	/// Number of nodes searched per second.
+	uint64_t nodes_per_second{0};
+	/// Time the engine has been calculating, as reported by the engine.
+	std::chrono::milliseconds time{0};
+	/// Number of multipv slots in lines. Slots the engine hasn't reported yet have no moves.
+	uint8_t num_lines{0};
+	/// Latest line for each multipv slot, best first.
+	std::array<Live_line, max_lines> lines{};
+
+	/// Convert the reported lines to analyzed lines, leaving out slots without moves.
+	std::vector<Analyzed_line> to_analyzed_lines() const;
+};
+
+static_assert(std::is_trivially_copyable_v<Live_snapshot>, "Live snapshots are shared through a Seqlock");
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,171 @@
+#include "Move.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+uint8_t parse_square(char file, char rank, std::string_view lan)
+{
+	if (file < 'a' || file > 'h' || rank < '1' || rank > '8')
+		throw std::runtime_error("Error parsing move: Invalid square in '" + std::string(lan) + "'");
+	return static_cast<uint8_t>((file - 'a') + 8 * (rank - '1'));
+}
+
+Move::Promotion parse_promotion(char piece, std::string_view lan)
+{
+	switch (piece) {
+	case 'n':
+	case 'N':
+		return Move::Promotion::knight;
+	case 'b':
+	case 'B':
+		return Move::Promotion::bishop;
+	case 'r':
+	case 'R':
+		return Move::Promotion::rook;
+	case 'q':
+	case 'Q':
+		return Move::Promotion::queen;
+	default:
+		throw std::runtime_error("Error parsing move: Invalid promotion piece in '" + std::string(lan) + "'");
+	}
+}
+
+} // Anonymous namespace
+
+Move Move::from_lan(std::string_view lan)
+{
+	if (lan == "0000")
+		return Move();
+	if (lan.size() != 4 && lan.size() != 5)
+		throw std::runtime_error("Error parsing move: Expected 4 or 5 characters, got '" + std::string(lan) + "'");
+
+	uint8_t from = parse_square(lan[0], lan[1], lan);
+	uint8_t to = parse_square(lan[2], lan[3], lan);
+	Promotion promotion = lan.size() == 5 ? parse_promotion(lan[4], lan) : Promotion::none;
+	return Move(from, to, promotion);
+}
+
+size_t Move::to_lan(char* buffer) const
+{
+	if (is_null()) {
+		std::fill(buffer, buffer + 4, '0');
+		return 4;
+	}
+	buffer[0] = static_cast<char>('a' + from() % 8);
+	buffer[1] = static_cast<char>('1' + from() / 8);
+	buffer[2] = static_cast<char>('a' + to() % 8);
+	buffer[3] = static_cast<char>('1' + to() / 8);
+	if (promotion() == Promotion::none)
+		return 4;
+	constexpr char promotion_pieces[] = {' ', 'n', 'b', 'r', 'q', ' ', ' ', ' '};
+	buffer[4] = promotion_pieces[static_cast<uint8_t>(promotion())];
+	return 5;
+}
+
+std::string to_string(Move move)
+{
+	char buffer[Move::max_lan_length];
+	return std::string(buffer, move.to_lan(buffer));
+}
+
+Move_sequence Move_sequence::from_lan(std::string_view lan)
+{
+	Move_sequence sequence;
+	size_t begin = 0;
+	while (begin < lan.size()) {
+		size_t end = lan.find(' ', begin);
+		if (end == std::string_view::npos)
+			end = lan.size();
+		if (end > begin)
+			sequence.push_back(Move::from_lan(lan.substr(begin, end - begin)));
+		begin = end + 1;
+	}
+	return sequence;
+}
+
+Move_sequence Move_sequence::from_strings(const std::vector<std::string>& moves)
+{
+	Move_sequence sequence;
+	for (const std::string& move : moves)
+		sequence.push_back(Move::from_lan(move));
+	return sequence;
+}
+
+bool Move_sequence::push_back(Move move)
+{
+	if (size_ == capacity)
+		return false;
+	moves_[size_] = move;
+	size_ += 1;
+	return true;
+}
+
+void Move_sequence::clear()
+{
+	size_ = 0;
+}
+
+size_t Move_sequence::size() const
+{
+	return size_;
+}
+
+bool Move_sequence::empty() const
+{
+	return size_ == 0;
+}
+
+Move Move_sequence::operator[](size_t index) const
+{
+	return moves_[index];
+}
+
+const Move* Move_sequence::begin() const
+{
+	return moves_.data();
+}
+
+const Move* Move_sequence::end() const
+{
+	return moves_.data() + size_;
+}
+
+std::vector<std::string> Move_sequence::to_strings() const
+{
+	std::vector<std::string> strings;
+	strings.reserve(size_);
+	for (Move move : *this)
+		strings.push_back(to_string(move));
+	return strings;
+}
+
+bool Move_sequence::operator==(const Move_sequence& other) const
+{
+	return std::equal(begin(), end(), other.begin(), other.end());
+}
+
+bool Move_sequence::operator!=(const Move_sequence& other) const
+{
+	return !(*this == other);
+}
+
+std::string to_string(const Move_sequence& moves)
+{
+	std::string string;
+	string.reserve(moves.size() * (Move::max_lan_length + 1));
+	char buffer[Move::max_lan_length];
+	for (Move move : moves) {
+		if (!string.empty())
+			string += ' ';
+		string.append(buffer, move.to_lan(buffer));
+	}
+	return string;
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,172 @@
+/**
+ * \file Move.h
+ * \brief Compact representation of chess moves and move sequences.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Move
+ * \brief A chess move packed into 16 bits.
+ *
+ * Bits 0-5 hold the square the piece moves from, bits 6-11 the square it moves to and bits 12-14 the
+ * piece a pawn is promoted to (if any). Squares are numbered from 0 (a1) to 63 (h8), file by file
+ * within each rank. The null move ('0000' in long algebraic notation) has all bits set to zero.
+ */
+class Move
+{
+public:
+	/// Piece a pawn is promoted to.
+	enum class Promotion : uint8_t
+	{
+		none = 0,
+		knight = 1,
+		bishop = 2,
+		rook = 3,
+		queen = 4
+	};
+
+	/// Construct the null move.
+	constexpr Move() = default;
+	/**
+	 * \param from Square the piece moves from (0-63).
+	 * \param to Square the piece moves to (0-63).
+	 * \param promotion Piece a pawn is promoted to.
+	 */
+	constexpr Move(uint8_t from, uint8_t to, Promotion promotion = Promotion::none)
+		: bits_(static_cast<uint16_t>((from & 63) | ((to & 63) << 6) | (static_cast<uint16_t>(promotion) << 12)))
+	{}
+
+	/**
+	 * Parse a move in long algebraic notation, e.g. 'e2e4' or 'e7e8q'.
+	 *
+	 * \param lan Move in long algebraic notation.
+	 * \return Parsed move.
+	 * \throw std::runtime_error if the move is malformed.
+	 */
+	static Move from_lan(std::string_view lan);
+	/// Construct a move from its packed representation (see bits()).
+	static constexpr Move from_bits(uint16_t bits)
+	{
+		Move move;
+		move.bits_ = bits;
+		return move;
+	}
+
+	/// Square the piece moves from (0-63).
+	constexpr uint8_t from() const
+	{
+		return bits_ & 63;
+	}
+	/// Square the piece moves to (0-63).
+	constexpr uint8_t to() const
+	{
+		return (bits_ >> 6) & 63;
+	}
+	/// Piece a pawn is promoted to.
+	constexpr Promotion promotion() const
+	{
+		return static_cast<Promotion>((bits_ >> 12) & 7);
+	}
+	/// Whether or not this is the null move.
+	constexpr bool is_null() const
+	{
+		return bits_ == 0;
+	}
+	/// Packed representation of the move.
+	constexpr uint16_t bits() const
+	{
+		return bits_;
+	}
+
+	/// Maximum number of characters needed to write a move in long algebraic notation.
+	static constexpr size_t max_lan_length = 5;
+	/**
+	 * Write the move in long algebraic notation, without allocating.
+	 *
+	 * \param buffer Buffer with room for at least max_lan_length characters. No terminating null
+	 * character is written.
+	 * \return Number of characters written.
+	 */
+	size_t to_lan(char* buffer) const;
+
+	constexpr bool operator==(Move other) const
+	{
+		return bits_ == other.bits_;
+	}
+	constexpr bool operator!=(Move other) const
+	{
+		return bits_ != other.bits_;
+	}
+
+private:
+	uint16_t bits_{0};
+};
+
+static_assert(sizeof(Move) == 2, "Move should be packed into 16 bits");
+
+/// Convert a move to long algebraic notation.
+std::string to_string(Move move);
+
+/**
+ * \class Move_sequence
+ * \brief Sequence of moves stored in a fixed size buffer inside the object, so that storing a line
+ * of moves doesn't require any memory allocations.
+ *
+ * Moves added beyond the capacity of the buffer are dropped.
+ */
+class Move_sequence
+{
+public:
+	/// Maximum number of moves in a sequence.
+	static constexpr size_t capacity = 63;
+
+	Move_sequence() = default;
+
+	/**
+	 * Parse a sequence of moves in long algebraic notation, separated by spaces.
+	 *
+	 * \param lan Moves in long algebraic notation, e.g. 'e2e4 e7e5 g1f3'.
+	 * \return Parsed moves.
+	 * \throw std::runtime_error if any of the moves is malformed.
+	 */
+	static Move_sequence from_lan(std::string_view lan);
+	/// Convert moves in long algebraic notation to a sequence of moves.
+	static Move_sequence from_strings(const std::vector<std::string>& moves);
+
+	/// Add a move to the end of the sequence. Returns false (and drops the move) if the sequence is full.
+	bool push_back(Move move);
+	void clear();
+
+	size_t size() const;
+	bool empty() const;
+	Move operator[](size_t index) const;
+	const Move* begin() const;
+	const Move* end() const;
+
+	/// Convert the moves to long algebraic notation, one string per move.
+	std::vector<std::string> to_strings() const;
+
+	bool operator==(const Move_sequence& other) const;
+	bool operator!=(const Move_sequence& other) const;
+
+private:
+	std::array<Move, capacity> moves_{};
+	uint8_t size_{0};
+};
+
+/// Convert a sequence of moves to long algebraic notation, with the moves separated by spaces.
+std::string to_string(const Move_sequence& moves);
+
+} // namespace uci
+} // namespace chess
@@ -1,123 +1,348 @@
 #include "Parse_messages.h"
 
-#include <cassert>
-#include <cstring>
+#include <charconv>
 #include <stdexcept>
 #include <string>
 
 namespace chess {
 namespace uci {
 
-Info parse_info(const std::string& info_str)
+namespace {
+
+bool is_separator(char c)
 {
-	Info info;
+	return c == ' ' || c == '\t' || c == '\r';
+}
 
-	// Parse for pv info
-	if (size_t pos = info_str.rfind("pv"); pos != std::string::npos) {
-		info.sequence_of_moves = impl::parse_pv(info_str.substr(pos));
-	}
+/// Splits a message into whitespace separated tokens, from left to right, without copying.
+class Token_cursor
+{
+public:
+	explicit Token_cursor(std::string_view message)
+		: rest_(message)
+	{}
 
-	// Parse line index
-	if (size_t pos = info_str.find("multipv"); pos != std::string::npos) {
-		try {
-			info.line_index = std::stoi(info_str.substr(pos + 8));
-			assert(*info.line_index >= 1);
-			// Convert engine enumeration to zero-based indexing
-			info.line_index = *info.line_index - 1;
-		} catch (std::exception& e) {
-			throw std::runtime_error(std::string("Error parsing multipv: ") + e.what());
-		}
+	/// Get the next token, or an empty view if there are no more tokens.
+	std::string_view next()
+	{
+		size_t begin = 0;
+		while (begin < rest_.size() && is_separator(rest_[begin]))
+			begin += 1;
+		size_t end = begin;
+		while (end < rest_.size() && !is_separator(rest_[end]))
+			end += 1;
+		std::string_view token = rest_.substr(begin, end - begin);
+		rest_.remove_prefix(end);
+		return token;
 	}
 
-	// Parse evaluation
-	if (size_t pos = info_str.find("score"); pos != std::string::npos) {
-		info.evaluation = impl::parse_score(info_str.substr(pos));
+	/// Get the next token without consuming it.
+	std::string_view peek() const
+	{
+		return Token_cursor(rest_).next();
 	}
 
-	// Parse number of nodes searched
-	if (size_t pos = info_str.find("nodes"); pos != std::string::npos) {
-		try {
-			info.nodes = std::stoi(info_str.substr(pos + 6));
-		} catch (std::exception& e) {
-			throw std::runtime_error(std::string("Error parsing nodes: ") + e.what());
+	/// Count the remaining tokens, without consuming them.
+	size_t count_remaining() const
+	{
+		size_t count = 0;
+		bool in_token = false;
+		for (char c : rest_) {
+			bool is_token_char = !is_separator(c);
+			if (is_token_char && !in_token)
+				count += 1;
+			in_token = is_token_char;
 		}
+		return count;
 	}
 
-	// Parse calculation time
-	if (size_t pos = info_str.find("time"); pos != std::string::npos) {
-		try {
-			info.time = std::stoi(info_str.substr(pos + 5));
-		} catch (std::exception& e) {
-			throw std::runtime_error(std::string("Error parsing time: ") + e.what());
-		}
+	/// Skip all remaining tokens.
+	void skip_rest()
+	{
+		rest_ = std::string_view();
 	}
 
-	return info;
-}
+private:
+	std::string_view rest_;
+};
 
-namespace impl {
-
-std::vector<std::string> tokenize(const std::string& string, char delimeter)
+/// Parse a token containing an integer, which must fit in the given integer type.
+template<class Integer>
+Integer parse_integer(std::string_view token, const char* field_name)
 {
-	std::vector<std::string> tokens;
-	// strtok expects non-const data
-	std::string string_copy = string;
-	char* p = std::strtok(string_copy.data(), &delimeter);
-	while (p) {
-		tokens.push_back(p);
-		p = std::strtok(NULL, &delimeter);
-	}
-	return tokens;
+	Integer value{};
+	const char* end = token.data() + token.size();
+	auto result = std::from_chars(token.data(), end, value);
+	if (token.empty() || result.ec != std::errc() || result.ptr != end)
+		throw std::runtime_error(std::string("Error parsing ") + field_name + ": Expected an integer, got '" + std::string(token) + "'");
+	return value;
 }
 
-Evaluation parse_score(const std::string& score)
+/// Parse the score entries following the 'score' keyword.
+Evaluation parse_score_tokens(Token_cursor& tokens)
 {
 	Evaluation evaluation;
-	if (score.substr(0, 6) != "score ")
-		throw std::runtime_error("Error parsing score: Score string is malformed");
+	std::string_view kind = tokens.next();
 
 	// First handle mating scores
-	if (score.substr(6, 4) == "mate") {
-		int mate_in_moves = stoi(score.substr(11));
-		if (mate_in_moves == 0)
+	if (kind == "mate") {
+		int mate_in_moves = parse_integer<int>(tokens.next(), "score mate");
+		if (mate_in_moves == 0 || mate_in_moves > 255 || mate_in_moves < -255)
 			throw std::runtime_error("Error parsing score: Failed to parse number of moves to mate");
-		if (mate_in_moves > 0) {
+		if (mate_in_moves > 0)
 			evaluation.white_can_mate_in = mate_in_moves;
-			return evaluation;
-		} else {
+		else
 			evaluation.black_can_mate_in = -mate_in_moves;
-			return evaluation;
-		}
+		return evaluation;
 	}
 
 	// Parse centi pawns evaluation
-	if (score.substr(6, 2) != "cp")
+	if (kind != "cp")
 		throw std::runtime_error("Error parsing score: Failed to parse centi pawns evaluation");
+	int16_t centi_pawns = parse_integer<int16_t>(tokens.next(), "score cp entry");
 
-	try {
-		size_t pos = 0;
-		int centi_pawns_evaluation = std::stoi(score.substr(9), &pos);
-		if (score.size() > 9 + pos) {
-			// Parse lower/upper bound
-			if (score.substr(9 + pos + 1) == "lowerbound") {
-				evaluation.centi_pawns_lower_bound = centi_pawns_evaluation;
-			} else {
-				if (score.substr(9 + pos + 1) == "upperbound")
-					evaluation.centi_pawns_upper_bound = centi_pawns_evaluation;
-				else
-					evaluation.centi_pawns = centi_pawns_evaluation;
+	// Parse lower/upper bound
+	std::string_view bound = tokens.peek();
+	if (bound == "lowerbound") {
+		evaluation.centi_pawns_lower_bound = centi_pawns;
+		tokens.next();
+	} else if (bound == "upperbound") {
+		evaluation.centi_pawns_upper_bound = centi_pawns;
+		tokens.next();
+	} else {
+		evaluation.centi_pawns = centi_pawns;
+	}
+	return evaluation;
+}
+
+/// Parse all remaining tokens as a sequence of moves.
+std::vector<std::string> parse_moves(Token_cursor& tokens)
+{
+	std::vector<std::string> moves;
+	moves.reserve(tokens.count_remaining());
+	for (std::string_view move = tokens.next(); !move.empty(); move = tokens.next())
+		moves.emplace_back(move);
+	return moves;
+}
+
+/// Function parsing the entries following a keyword in an info message.
+using Field_parser = void (*)(Token_cursor& tokens, Info& info);
+
+struct Info_field
+{
+	std::string_view keyword;
+	Field_parser parse;
+};
+
+/// Parsers for all entries of an info message, ordered roughly by how often the entries are sent.
+const Info_field info_fields[] = {
+	{"depth", [](Token_cursor& tokens, Info& info) {
+		 info.depth = parse_integer<unsigned int>(tokens.next(), "depth");
+	 }},
+	{"seldepth", [](Token_cursor& tokens, Info& info) {
+		 info.selective_depth = parse_integer<unsigned int>(tokens.next(), "seldepth");
+	 }},
+	{"multipv", [](Token_cursor& tokens, Info& info) {
+		 unsigned int multipv = parse_integer<unsigned int>(tokens.next(), "multipv");
+		 if (multipv < 1 || multipv > 256)
+			 throw std::runtime_error("Error parsing multipv: Value out of range");
+		 // Convert engine enumeration to zero-based indexing
+		 info.line_index = static_cast<uint8_t>(multipv - 1);
+	 }},
+	{"score", [](Token_cursor& tokens, Info& info) {
+		 info.evaluation = parse_score_tokens(tokens);
+	 }},
+	{"nodes", [](Token_cursor& tokens, Info& info) {
+		 info.nodes = parse_integer<uint64_t>(tokens.next(), "nodes");
+	 }},
+	{"nps", [](Token_cursor& tokens, Info& info) {
+		 info.nodes_per_second = parse_integer<uint64_t>(tokens.next(), "nps");
+	 }},
+	{"hashfull", [](Token_cursor& tokens, Info& info) {
+		 info.hash_full = parse_integer<unsigned int>(tokens.next(), "hashfull");
+	 }},
+	{"tbhits", [](Token_cursor& tokens, Info& info) {
+		 info.table_base_hits = parse_integer<uint64_t>(tokens.next(), "tbhits");
+	 }},
+	{"time", [](Token_cursor& tokens, Info& info) {
+		 info.time = parse_integer<unsigned int>(tokens.next(), "time");
+	 }},
+	{"pv", [](Token_cursor& tokens, Info& info) {
+		 info.sequence_of_moves = parse_moves(tokens);
+	 }},
+	{"currmove", [](Token_cursor& tokens, Info& info) {
+		 info.current_move = std::string(tokens.next());
+	 }},
+	{"currmovenumber", [](Token_cursor& tokens, Info& info) {
+		 info.current_move_number = parse_integer<unsigned int>(tokens.next(), "currmovenumber");
+	 }},
+	{"sbhits", [](Token_cursor& tokens, Info&) {
+		 tokens.next();
+	 }},
+	{"cpuload", [](Token_cursor& tokens, Info&) {
+		 tokens.next();
+	 }},
+	// The rest of the message is free text or move sequences we don't keep
+	{"string", [](Token_cursor& tokens, Info&) {
+		 tokens.skip_rest();
+	 }},
+	{"refutation", [](Token_cursor& tokens, Info&) {
+		 tokens.skip_rest();
+	 }},
+	{"currline", [](Token_cursor& tokens, Info&) {
+		 tokens.skip_rest();
+	 }},
+};
+
+} // Anonymous namespace
+
+Info parse_info(std::string_view info_str)
+{
+	Info info;
+	Token_cursor tokens(info_str);
+	if (tokens.peek() == "info")
+		tokens.next();
+
+	for (std::string_view keyword = tokens.next(); !keyword.empty(); keyword = tokens.next()) {
+		for (const Info_field& field : info_fields) {
+			if (field.keyword == keyword) {
+				field.parse(tokens, info);
+				break;
 			}
-		} else {
-			evaluation.centi_pawns = centi_pawns_evaluation;
 		}
-	} catch (std::exception& e) {
-		throw std::runtime_error(std::string("Error parsing score cp entry: ") + e.what());
+		// Unknown entries are skipped one token at a time
 	}
 
-	return evaluation;
+	return info;
+}
+
+Best_move parse_bestmove(std::string_view message)
+{
+	Token_cursor tokens(message);
+	if (tokens.next() != "bestmove")
+		throw std::runtime_error("Error parsing bestmove: Expected a bestmove message, got '" + std::string(message) + "'");
+	std::string_view move = tokens.next();
+	if (move.empty())
+		throw std::runtime_error("Error parsing bestmove: No move in bestmove message");
+
+	Best_move best_move;
+	best_move.move = std::string(move);
+	if (tokens.next() == "ponder") {
+		std::string_view ponder = tokens.next();
+		if (!ponder.empty())
+			best_move.ponder = std::string(ponder);
+	}
+	return best_move;
+}
+
+std::optional<Engine_option> parse_option(std::string_view message)
+{
+	Token_cursor tokens(message);
+	if (tokens.next() != "option")
+		return std::nullopt;
+
+	// Names and values may contain spaces, so each entry runs until the next keyword. Only 'type'
+	// ends the name, since names may contain the other keywords.
+	auto ends_entry = [](std::string_view keyword, std::string_view token) {
+		if (keyword == "name")
+			return token == "type";
+		return token == "name" || token == "type" || token == "default" || token == "min" || token == "max" || token == "var";
+	};
+	Engine_option option;
+	bool has_type = false;
+	std::string_view keyword = tokens.next();
+	while (!keyword.empty()) {
+		std::string value;
+		std::string_view token = tokens.next();
+		for (; !token.empty() && !ends_entry(keyword, token); token = tokens.next()) {
+			if (!value.empty())
+				value += ' ';
+			value.append(token);
+		}
+
+		if (keyword == "name") {
+			option.name = std::move(value);
+		} else if (keyword == "type") {
+			has_type = true;
+			if (value == "check")
+				option.type = Engine_option::Type::check;
+			else if (value == "spin")
+				option.type = Engine_option::Type::spin;
+			else if (value == "combo")
+				option.type = Engine_option::Type::combo;
+			else if (value == "button")
+				option.type = Engine_option::Type::button;
+			else if (value == "string")
+				option.type = Engine_option::Type::string;
+			else
+				throw std::runtime_error("Error parsing option: Unknown type '" + value + "'");
+		} else if (keyword == "default") {
+			// Empty strings are sent as '<empty>', since there would otherwise be nothing to parse
+			option.default_value = value == "<empty>" ? std::string() : std::move(value);
+		} else if (keyword == "min") {
+			option.min = parse_integer<int64_t>(value, "option min");
+		} else if (keyword == "max") {
+			option.max = parse_integer<int64_t>(value, "option max");
+		} else if (keyword == "var") {
+			option.values.push_back(std::move(value));
+		}
+		// Unknown entries are skipped
+		keyword = token;
+	}
+
+	if (option.name.empty())
+		throw std::runtime_error("Error parsing option: Option has no name");
+	if (!has_type)
+		throw std::runtime_error("Error parsing option: Option " + option.name + " has no type");
+	if (option.min.has_value() && option.max.has_value() && *option.min > *option.max)
+		throw std::runtime_error("Error parsing option: Option " + option.name + " has an empty range");
+	return option;
+}
+
+bool is_search_info_message(std::string_view message)
+{
+	return message.substr(0, 5) == "info " && message.substr(0, 12) != "info string ";
+}
+
+bool update_lines(std::vector<Analyzed_line>& lines, Info& info)
+{
+	// Only keep the latest line for each multipv slot. Engines which only calculate one line may leave out the multipv entry.
+	if (!info.evaluation.has_value() || !info.sequence_of_moves.has_value())
+		return false;
+	size_t line_index = info.line_index.value_or(0);
+	if (line_index >= lines.size())
+		return false;
+	lines[line_index].evaluation = *info.evaluation;
+	lines[line_index].moves = std::move(*info.sequence_of_moves);
+	return true;
+}
+
+namespace impl {
+
+std::vector<std::string> tokenize(std::string_view string, char delimeter)
+{
+	std::vector<std::string> tokens;
+	size_t begin = 0;
+	while (begin < string.size()) {
+		size_t end = string.find(delimeter, begin);
+		if (end == std::string_view::npos)
+			end = string.size();
+		if (end > begin)
+			tokens.emplace_back(string.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	return tokens;
+}
+
+Evaluation parse_score(std::string_view score)
+{
+	Token_cursor tokens(score);
+	if (tokens.next() != "score")
+		throw std::runtime_error("Error parsing score: Score string is malformed");
+	return parse_score_tokens(tokens);
 }
 
-std::vector<std::string> parse_pv(const std::string& pv)
+std::vector<std::string> parse_pv(std::string_view pv)
 {
 	// Parse pv
 	if (pv.substr(0, 3) != "pv ")
@@ -6,9 +6,12 @@
 #pragma once
 
 #include "Evaluation.h"
+#include "Line.h"
 
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace chess {
@@ -26,20 +29,117 @@ struct Info
 	std::optional<uint8_t> line_index;
 	/// Current evaluation, based on the suggested sequence of future moves.
 	std::optional<Evaluation> evaluation;
+	/// Search depth in plies.
+	std::optional<unsigned int> depth;
+	/// Selective search depth in plies.
+	std::optional<unsigned int> selective_depth;
 	/// Number of nodes (game states) the engine has analyzed.
-	std::optional<unsigned int> nodes;
+	std::optional<uint64_t> nodes;
+	/// Number of nodes the engine analyzes per second.
+	std::optional<uint64_t> nodes_per_second;
+	/// How full the engine hash table is, in permill.
+	std::optional<unsigned int> hash_full;
+	/// Number of positions found in the endgame table bases.
+	std::optional<uint64_t> table_base_hits;
 	/// Time the engine has been calculating in milliseconds.
 	std::optional<unsigned int> time;
+	/// Move the engine is currently searching, in long algebraic notation.
+	std::optional<std::string> current_move;
+	/// Number of the move the engine is currently searching, starting at 1 for the first move.
+	std::optional<unsigned int> current_move_number;
+};
+
+/// Struct containing the parsed final message of an engine calculation.
+struct Best_move
+{
+	/// Best move in long algebraic notation ('(none)' or '0000' if there are no legal moves).
+	std::string move;
+	/// Reply the engine expects from the opponent, if any, in long algebraic notation.
+	std::optional<std::string> ponder;
+};
+
+/// Description of an option the engine supports, as sent by the engine in reply to the 'uci' command.
+struct Engine_option
+{
+	enum class Type
+	{
+		/// Boolean option, with value 'true' or 'false'.
+		check,
+		/// Integer option within a range.
+		spin,
+		/// Option with one of a fixed set of values.
+		combo,
+		/// Action without a value, e.g. 'Clear Hash'.
+		button,
+		/// Free text option, e.g. a path.
+		string
+	};
+
+	/// Name of the option. Option names aren't case sensitive.
+	std::string name;
+	Type type{Type::string};
+	/// Default value, if any.
+	std::optional<std::string> default_value;
+	/// Minimum value of a spin option.
+	std::optional<int64_t> min;
+	/// Maximum value of a spin option.
+	std::optional<int64_t> max;
+	/// Allowed values of a combo option.
+	std::vector<std::string> values;
 };
 
 /**
  * Parse an info message from the engine.
  *
+ * The message is parsed in a single pass from left to right. Apart from the sequence of moves,
+ * parsing doesn't allocate any memory. Unknown entries are skipped, and a 'string' entry ends the
+ * parsing since the rest of the message is free text.
+ *
  * \param info Info message from the engine.
  * \return Parsed info.
  * \throw std::runtime_error if parsing the info string fails unexpectedly.
  */
-Info parse_info(const std::string& info);
+Info parse_info(std::string_view info);
+
+/**
+ * Parse the bestmove message the engine sends when it has finished calculating.
+ *
+ * \param message Message from the engine, e.g. 'bestmove e2e4 ponder e7e5'.
+ * \return Parsed best move.
+ * \throw std::runtime_error if the message isn't a bestmove message.
+ */
+Best_move parse_bestmove(std::string_view message);
+
+/**
+ * Parse an option message the engine sends in reply to the 'uci' command.
+ *
+ * \param message Message from the engine, e.g. 'option name Hash type spin default 16 min 1 max 33554432'.
+ * \return Parsed option, or nullopt if the message isn't an option message.
+ * \throw std::runtime_error if the option has no name, or an unknown type or invalid range.
+ */
+std::optional<Engine_option> parse_option(std::string_view message);
+
+/**
+ * Check if an engine message is an info message with search results, i.e. not a free text
+ * 'info string' message.
+ *
+ * \param message Engine message.
+ * \return true if the message should be parsed with parse_info().
+ */
+bool is_search_info_message(std::string_view message);
+
+/**
+ * Update the lines of a running calculation with a parsed info message.
+ *
+ * Only the latest line for each multipv slot is kept, so the line at Info::line_index (or the
+ * first line if the engine left it out) is replaced.
+ *
+ * \param lines Lines of the calculation, one per multipv slot.
+ * \param info Parsed info message. Its sequence of moves is moved into the updated line.
+ * \return true if a line was updated, false if the message doesn't contain both an evaluation and
+ * a sequence of moves, or is for a slot outside of lines.
+ */
+bool update_lines(std::vector<Analyzed_line>& lines, Info& info);
 
 namespace impl {
 
@@ -55,7 +155,7 @@ namespace impl {
  * \param Array of parts from the original string after the split, with the
  * delimeter character removed.
  */
-std::vector<std::string> tokenize(const std::string& string, char delimeter);
+std::vector<std::string> tokenize(std::string_view string, char delimeter);
 
 /**
  * Parse score part of an engine message.
@@ -64,7 +164,7 @@ std::vector<std::string> tokenize(const std::string& string, char delimeter);
  * \return Parsed evaluation info.
  * \throw std::runtime_error if parsing the score string fails unexpectedly.
  */
-Evaluation parse_score(const std::string& score);
+Evaluation parse_score(std::string_view score);
 
 /**
  * Parse pv part of an engine message.
@@ -72,7 +172,7 @@ Evaluation parse_score(const std::string& score);
  * \param pv Line info from the engine.
  * \return Parsed line info as an sequence of moves in long algebraic notation.
  */
-std::vector<std::string> parse_pv(const std::string& pv);
+std::vector<std::string> parse_pv(std::string_view pv);
 
 } // namespace impl
 
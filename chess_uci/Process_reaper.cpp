@@ -0,0 +1,115 @@
+#include "Process_reaper.h"
+
+#include <sys/wait.h>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// How often to check whether the pending processes have exited.
+constexpr std::chrono::milliseconds poll_interval{5};
+
+} // Anonymous namespace
+
+Process_reaper& Process_reaper::instance()
+{
+	static Process_reaper reaper;
+	return reaper;
+}
+
+void Process_reaper::kill(boost::process::child& process)
+{
+	std::error_code error;
+	if (!process.valid() || !process.running(error) || error)
+		return;
+	// terminate() doesn't wait for the killed process, so do that here. A killed process exits
+	// right away.
+	process.terminate(error);
+	int status = 0;
+	::waitpid(process.id(), &status, 0);
+}
+
+Process_reaper::Process_reaper()
+	: thread_([this]() {
+		run();
+	})
+{}
+
+Process_reaper::~Process_reaper()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	changed_.notify_all();
+	thread_.join();
+}
+
+void Process_reaper::reap(boost::process::child process, std::chrono::milliseconds timeout)
+{
+	std::error_code error;
+	if (!process.valid() || !process.running(error))
+		// Already exited, and now waited for
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_.push_back({std::move(process), std::chrono::steady_clock::now() + timeout});
+	}
+	changed_.notify_all();
+}
+
+void Process_reaper::wait_until_empty()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	changed_.wait(lock, [this]() {
+		return pending_.empty();
+	});
+}
+
+size_t Process_reaper::num_pending() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_.size();
+}
+
+uint64_t Process_reaper::num_killed() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return num_killed_;
+}
+
+void Process_reaper::run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true) {
+		if (pending_.empty()) {
+			if (stopping_)
+				return;
+			changed_.wait(lock);
+			continue;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		for (auto it = pending_.begin(); it != pending_.end();) {
+			// running() waits for the process if it has exited, so it doesn't linger as a zombie
+			std::error_code error;
+			if (!it->process.running(error) || error) {
+				it = pending_.erase(it);
+			} else if (now >= it->deadline) {
+				kill(it->process);
+				num_killed_ += 1;
+				it = pending_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		if (pending_.empty())
+			changed_.notify_all();
+		else
+			changed_.wait_for(lock, poll_interval);
+	}
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,92 @@
+/**
+ * \file Process_reaper.h
+ * \brief Contains a background reaper for engine processes which have been asked to quit.
+ */
+
+#pragma once
+
+#include <boost/process/child.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Process_reaper
+ * \brief Waits in the background for engine processes to exit, and kills the ones which don't
+ * exit in time.
+ *
+ * Engines are asked to quit when they're no longer needed, but may take a while to do so (e.g. to
+ * free a large hash table), and a hung engine may not quit at all. Handing the process to the
+ * reaper lets the owner go on right away, while making sure that the process is eventually waited
+ * for (so that it doesn't linger as a zombie) or killed.
+ *
+ * There is a single reaper per program (see instance()). When the program exits the reaper waits
+ * for the remaining processes, killing them when their time is up.
+ */
+class Process_reaper
+{
+public:
+	/// Time a process normally gets to exit after it has been asked to quit.
+	static constexpr std::chrono::milliseconds default_timeout{1000};
+
+	/// Get the reaper of the program.
+	static Process_reaper& instance();
+
+	/**
+	 * Kill a child process right away, and wait for it so that it doesn't linger as a zombie.
+	 *
+	 * \param process Process to kill. Does nothing if it isn't a running process.
+	 */
+	static void kill(boost::process::child& process);
+
+	~Process_reaper();
+
+	Process_reaper(const Process_reaper&) = delete;
+	Process_reaper& operator=(const Process_reaper&) = delete;
+
+	/**
+	 * Take over a child process which has been asked to exit.
+	 *
+	 * \param process Process to wait for. Does nothing if it isn't a running process.
+	 * \param timeout Time the process gets to exit before it's killed.
+	 */
+	void reap(boost::process::child process, std::chrono::milliseconds timeout);
+
+	/// Wait until all processes handed to the reaper have exited or been killed.
+	void wait_until_empty();
+
+	/// Number of processes which haven't exited yet.
+	size_t num_pending() const;
+	/// Number of processes which had to be killed since the program started.
+	uint64_t num_killed() const;
+
+private:
+	Process_reaper();
+
+	void run();
+
+	struct Pending_process
+	{
+		boost::process::child process;
+		std::chrono::steady_clock::time_point deadline;
+	};
+
+	mutable std::mutex mutex_;
+	/// Notified when processes are added, when all processes have exited, and when stopping.
+	std::condition_variable changed_;
+	std::list<Pending_process> pending_;
+	uint64_t num_killed_{0};
+	bool stopping_{false};
+	std::thread thread_;
+};
+
+} // namespace uci
+} // namespace chess
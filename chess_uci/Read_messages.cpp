@@ -1,6 +1,7 @@
 #include "Read_messages.h"
 
 #include <istream>
+#include <stdexcept>
 
 namespace chess {
 namespace uci {
@@ -8,25 +9,101 @@ namespace uci {
 namespace {
 
 /// Continue to read lines from the given stream until the given
-/// predicate is true for the last read line.
-template<class UnaryPredicate>
-const std::vector<std::string> read_lines_from_stream_until(std::istream& stream, UnaryPredicate p)
+/// predicate is true for the last read line. Every line except the
+/// last one is passed to the given handler, and the last one is returned.
+template<class UnaryPredicate, class LineHandler>
+std::string handle_lines_from_stream_until(std::istream& stream, UnaryPredicate p, LineHandler handler)
 {
-	std::vector<std::string> messages;
 	std::string message;
-	bool read_finished = false;
-	while (!read_finished) {
+	while (true) {
 		std::getline(stream, message);
 		while (stream.eof()) {
 			// Continue reading until we have read a full message
 			std::getline(stream, message);
 		}
+		if (p(message))
+			return message;
+		handler(message);
+	}
+}
+
+/// Continue to read lines from the given stream until the given
+/// predicate is true for the last read line.
+template<class UnaryPredicate>
+const std::vector<std::string> read_lines_from_stream_until(std::istream& stream, UnaryPredicate p)
+{
+	std::vector<std::string> messages;
+	std::string last_message = handle_lines_from_stream_until(stream, p, [&messages](std::string& message) {
 		messages.emplace_back(std::move(message));
-		read_finished = p(messages.back());
+	});
+	messages.emplace_back(std::move(last_message));
+	return messages;
+}
+
+bool is_bestmove_message(std::string_view message)
+{
+	return message.substr(0, 8) == "bestmove";
+}
+
+/// No deadline, i.e. wait for as long as it takes.
+constexpr std::chrono::steady_clock::time_point no_deadline = std::chrono::steady_clock::time_point::max();
+
+/// Continue to read lines from the given reader until the given
+/// predicate is true for the last read line, or until the deadline
+/// has passed. Every line except the last one is passed to the given
+/// handler, and the last one is returned (nullopt on timeout).
+template<class UnaryPredicate, class LineHandler>
+std::optional<std::string> handle_lines_from_reader_until(
+	Line_reader& reader,
+	UnaryPredicate p,
+	LineHandler handler,
+	std::chrono::steady_clock::time_point deadline)
+{
+	std::string_view message;
+	while (true) {
+		switch (reader.read_line(deadline, message)) {
+		case Line_reader::Status::line:
+			break;
+		case Line_reader::Status::end_of_stream:
+			throw std::runtime_error("Engine error: Engine output ended while waiting for a reply");
+		case Line_reader::Status::timeout:
+			return std::nullopt;
+		}
+		if (p(message))
+			return std::string(message);
+		handler(message);
 	}
+}
+
+/// Continue to read lines from the given reader until the given
+/// predicate is true for the last read line, or until the deadline
+/// has passed (nullopt).
+template<class UnaryPredicate>
+std::optional<std::vector<std::string>> read_lines_from_reader_until(
+	Line_reader& reader,
+	UnaryPredicate p,
+	std::chrono::steady_clock::time_point deadline)
+{
+	std::vector<std::string> messages;
+	std::optional<std::string> last_message = handle_lines_from_reader_until(reader, p, [&messages](std::string_view message) {
+		messages.emplace_back(message);
+	}, deadline);
+	if (!last_message.has_value())
+		return std::nullopt;
+	messages.emplace_back(std::move(*last_message));
 	return messages;
 }
 
+bool is_uciok_message(std::string_view message)
+{
+	return message == "uciok";
+}
+
+bool is_readyok_message(std::string_view message)
+{
+	return message == "readyok";
+}
+
 } // Anonymous namespace
 
 std::vector<std::string> read_uci_replies(std::istream& stream)
@@ -45,10 +122,48 @@ std::vector<std::string> read_isready_replies(std::istream& stream)
 
 std::vector<std::string> read_go_replies(std::istream& stream)
 {
-	return read_lines_from_stream_until(stream, [](const std::string& message) {
-		return message.substr(0, 8) == "bestmove";
+	return read_lines_from_stream_until(stream, is_bestmove_message);
+}
+
+std::string read_go_replies(std::istream& stream, const std::function<void(const std::string&)>& on_message)
+{
+	return handle_lines_from_stream_until(stream, is_bestmove_message, [&on_message](const std::string& message) {
+		on_message(message);
 	});
 }
 
+std::vector<std::string> read_uci_replies(Line_reader& reader)
+{
+	return *read_lines_from_reader_until(reader, is_uciok_message, no_deadline);
+}
+
+std::vector<std::string> read_isready_replies(Line_reader& reader)
+{
+	return *read_lines_from_reader_until(reader, is_readyok_message, no_deadline);
+}
+
+std::string read_go_replies(Line_reader& reader, const std::function<void(std::string_view)>& on_message)
+{
+	return *handle_lines_from_reader_until(reader, is_bestmove_message, on_message, no_deadline);
+}
+
+std::optional<std::vector<std::string>> read_uci_replies(Line_reader& reader, std::chrono::steady_clock::time_point deadline)
+{
+	return read_lines_from_reader_until(reader, is_uciok_message, deadline);
+}
+
+std::optional<std::vector<std::string>> read_isready_replies(Line_reader& reader, std::chrono::steady_clock::time_point deadline)
+{
+	return read_lines_from_reader_until(reader, is_readyok_message, deadline);
+}
+
+std::optional<std::string> read_go_replies(
+	Line_reader& reader,
+	const std::function<void(std::string_view)>& on_message,
+	std::chrono::steady_clock::time_point deadline)
+{
+	return handle_lines_from_reader_until(reader, is_bestmove_message, on_message, deadline);
+}
+
 } // namespace uci
 } // namespace chess
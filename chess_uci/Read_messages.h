@@ -5,8 +5,14 @@
 
 #pragma once
 
+#include "Line_reader.h"
+
+#include <chrono>
+#include <functional>
 #include <istream>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace chess {
@@ -60,5 +66,105 @@ std::vector<std::string> read_isready_replies(std::istream& stream);
  */
 std::vector<std::string> read_go_replies(std::istream& stream);
 
+/**
+ * Read messages received from the engine after the 'go' command has been sent to the engine, handing
+ * each message to the given handler as soon as it has been read instead of collecting them.
+ *
+ * This reads the same messages as read_go_replies(std::istream&), but only keeps the current message
+ * in memory, so that memory use stays constant no matter how long the engine calculates.
+ *
+ * \param stream Stream to which the engine writes its messages.
+ * \param on_message Function called with each message from the engine except the final 'bestmove'
+ * message, without a final newline character.
+ * \return The final message from the engine, which always starts with 'bestmove'.
+ */
+std::string read_go_replies(std::istream& stream, const std::function<void(const std::string&)>& on_message);
+
+/**
+ * Read messages received from the engine after the 'uci' command has been sent to the engine.
+ *
+ * Same as read_uci_replies(std::istream&), but reads directly from the engine output file descriptor.
+ *
+ * \param reader Reader for the engine output.
+ * \return List of messages from the engine. The last of these messages is always 'uciok'.
+ * \throw std::runtime_error if the engine output ends before the 'uciok' message.
+ */
+std::vector<std::string> read_uci_replies(Line_reader& reader);
+
+/**
+ * Read messages received from the engine after the 'isready' command has been sent to the engine.
+ *
+ * Same as read_isready_replies(std::istream&), but reads directly from the engine output file descriptor.
+ *
+ * \param reader Reader for the engine output.
+ * \return List of messages from the engine. The last of these messages is always 'readyok'.
+ * \throw std::runtime_error if the engine output ends before the 'readyok' message.
+ */
+std::vector<std::string> read_isready_replies(Line_reader& reader);
+
+/**
+ * Read messages received from the engine after the 'go' command has been sent to the engine, handing
+ * each message to the given handler as soon as it has been read.
+ *
+ * Same as read_go_replies(std::istream&, const std::function<void(const std::string&)>&), but reads
+ * directly from the engine output file descriptor, and doesn't copy the messages.
+ *
+ * \param reader Reader for the engine output.
+ * \param on_message Function called with each message from the engine except the final 'bestmove'
+ * message. The message is only valid during the call.
+ * \return The final message from the engine, which always starts with 'bestmove'.
+ * \throw std::runtime_error if the engine output ends before the 'bestmove' message.
+ */
+std::string read_go_replies(Line_reader& reader, const std::function<void(std::string_view)>& on_message);
+
+/**
+ * Read messages received from the engine after the 'uci' command has been sent to the engine, giving
+ * up when the deadline has passed.
+ *
+ * Same as read_uci_replies(Line_reader&), but doesn't wait forever for an engine which has hung.
+ *
+ * \param reader Reader for the engine output.
+ * \param deadline When to give up waiting for the 'uciok' message.
+ * \return List of messages from the engine, the last of which is always 'uciok', or nullopt if the
+ * deadline passed first. The messages read before the deadline are then lost.
+ * \throw std::runtime_error if the engine output ends before the 'uciok' message.
+ */
+std::optional<std::vector<std::string>> read_uci_replies(Line_reader& reader, std::chrono::steady_clock::time_point deadline);
+
+/**
+ * Read messages received from the engine after the 'isready' command has been sent to the engine,
+ * giving up when the deadline has passed.
+ *
+ * Same as read_isready_replies(Line_reader&), but doesn't wait forever for an engine which has hung.
+ *
+ * \param reader Reader for the engine output.
+ * \param deadline When to give up waiting for the 'readyok' message.
+ * \return List of messages from the engine, the last of which is always 'readyok', or nullopt if
+ * the deadline passed first.
+ * \throw std::runtime_error if the engine output ends before the 'readyok' message.
+ */
+std::optional<std::vector<std::string>> read_isready_replies(Line_reader& reader, std::chrono::steady_clock::time_point deadline);
+
+/**
+ * Read messages received from the engine after the 'go' command has been sent to the engine, handing
+ * each message to the given handler as soon as it has been read, and giving up when the deadline has passed.
+ *
+ * Same as read_go_replies(Line_reader&, const std::function<void(std::string_view)>&), but doesn't
+ * wait forever for an engine which has hung. The engine is still calculating after a timeout, so
+ * the caller typically sends 'stop' and then reads the remaining messages with a new deadline.
+ *
+ * \param reader Reader for the engine output.
+ * \param on_message Function called with each message from the engine except the final 'bestmove'
+ * message. The message is only valid during the call.
+ * \param deadline When to give up waiting for the 'bestmove' message.
+ * \return The final message from the engine, which always starts with 'bestmove', or nullopt if the
+ * deadline passed first.
+ * \throw std::runtime_error if the engine output ends before the 'bestmove' message.
+ */
+std::optional<std::string> read_go_replies(
+	Line_reader& reader,
+	const std::function<void(std::string_view)>& on_message,
+	std::chrono::steady_clock::time_point deadline);
+
 } // namespace uci
 } // namespace chess
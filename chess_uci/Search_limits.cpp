@@ -0,0 +1,127 @@
+#include "Search_limits.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+auto as_tuple(const Search_limits& limits)
+{
+	return std::tie(
+		limits.depth,
+		limits.nodes,
+		limits.mate,
+		limits.move_time,
+		limits.white_time,
+		limits.black_time,
+		limits.white_increment,
+		limits.black_increment,
+		limits.moves_to_go,
+		limits.infinite,
+		limits.ponder);
+}
+
+template<typename T>
+void append_limit(std::string& command, const char* name, const std::optional<T>& value)
+{
+	if (!value.has_value())
+		return;
+	command += ' ';
+	command += name;
+	command += ' ';
+	command += std::to_string(*value);
+}
+
+void append_limit(std::string& command, const char* name, const std::optional<std::chrono::milliseconds>& value)
+{
+	if (value.has_value())
+		append_limit(command, name, std::optional<int64_t>(value->count()));
+}
+
+} // Anonymous namespace
+
+Search_limits Search_limits::infinite_search()
+{
+	Search_limits limits;
+	limits.infinite = true;
+	return limits;
+}
+
+Search_limits Search_limits::for_move_time(std::chrono::microseconds time)
+{
+	Search_limits limits;
+	limits.move_time = time;
+	return limits;
+}
+
+Search_limits Search_limits::for_depth(uint16_t depth)
+{
+	Search_limits limits;
+	limits.depth = depth;
+	return limits;
+}
+
+Search_limits Search_limits::for_nodes(uint64_t nodes)
+{
+	Search_limits limits;
+	limits.nodes = nodes;
+	return limits;
+}
+
+Search_limits Search_limits::for_mate(uint16_t moves)
+{
+	Search_limits limits;
+	limits.mate = moves;
+	return limits;
+}
+
+bool Search_limits::is_finite() const
+{
+	if (infinite || ponder)
+		return false;
+	// The engine manages its own time when given the clock of the side to move. Only count the
+	// clock as a limit when both are given, since we don't know whose turn it is.
+	bool has_clock = white_time.has_value() && black_time.has_value();
+	return depth.has_value() || nodes.has_value() || mate.has_value() || move_time.has_value() || has_clock;
+}
+
+bool operator==(const Search_limits& lhs, const Search_limits& rhs)
+{
+	return as_tuple(lhs) == as_tuple(rhs);
+}
+
+bool operator!=(const Search_limits& lhs, const Search_limits& rhs)
+{
+	return !(lhs == rhs);
+}
+
+std::string to_go_command(const Search_limits& limits)
+{
+	std::string command = "go";
+	if (limits.ponder)
+		command += " ponder";
+	append_limit(command, "depth", limits.depth);
+	append_limit(command, "nodes", limits.nodes);
+	append_limit(command, "mate", limits.mate);
+	if (limits.move_time.has_value()) {
+		// Round up to whole milliseconds. A move time of 0 means no limit to some engines.
+		int64_t milliseconds = (limits.move_time->count() + 999) / 1000;
+		append_limit(command, "movetime", std::optional<int64_t>(std::max<int64_t>(milliseconds, 1)));
+	}
+	append_limit(command, "wtime", limits.white_time);
+	append_limit(command, "btime", limits.black_time);
+	append_limit(command, "winc", limits.white_increment);
+	append_limit(command, "binc", limits.black_increment);
+	append_limit(command, "movestogo", limits.moves_to_go);
+	Search_limits without_ponder = limits;
+	without_ponder.ponder = false;
+	if (!without_ponder.is_finite())
+		command += " infinite";
+	return command;
+}
+
+} // namespace uci
+} // namespace chess
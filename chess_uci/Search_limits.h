@@ -0,0 +1,78 @@
+/**
+ * \file Search_limits.h
+ * \brief Contains the limits of an engine calculation, as given to the UCI go command.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \struct Search_limits
+ * \brief Limits for an engine calculation.
+ *
+ * The engine stops calculating, and sends its best move, as soon as any of the given limits is
+ * reached. If no limit is given, or if infinite is set, the engine calculates until it's told
+ * to stop.
+ */
+struct Search_limits
+{
+	/// Maximum search depth in plies.
+	std::optional<uint16_t> depth;
+	/// Maximum number of nodes to search.
+	std::optional<uint64_t> nodes;
+	/// Search for a mate in at most this number of moves.
+	std::optional<uint16_t> mate;
+	/// Time to calculate. UCI engines take the time in whole milliseconds, so the time is rounded
+	/// up to the nearest millisecond, and to at least 1 ms.
+	std::optional<std::chrono::microseconds> move_time;
+	/// Remaining time on white's clock.
+	std::optional<std::chrono::milliseconds> white_time;
+	/// Remaining time on black's clock.
+	std::optional<std::chrono::milliseconds> black_time;
+	/// White's increment per move.
+	std::optional<std::chrono::milliseconds> white_increment;
+	/// Black's increment per move.
+	std::optional<std::chrono::milliseconds> black_increment;
+	/// Number of moves to the next time control.
+	std::optional<uint16_t> moves_to_go;
+	/// Calculate until told to stop, regardless of the other limits.
+	bool infinite{false};
+	/// Ponder, i.e. calculate on the opponent's time. The engine doesn't finish until it's told
+	/// that the opponent played the expected move (see Engine::start_pondering()).
+	bool ponder{false};
+
+	/// Limits to calculate until told to stop.
+	static Search_limits infinite_search();
+	/// Limits to calculate for the given time.
+	static Search_limits for_move_time(std::chrono::microseconds time);
+	/// Limits to calculate to the given depth.
+	static Search_limits for_depth(uint16_t depth);
+	/// Limits to search the given number of nodes.
+	static Search_limits for_nodes(uint64_t nodes);
+	/// Limits to search for a mate in at most the given number of moves.
+	static Search_limits for_mate(uint16_t moves);
+
+	/// Whether or not the engine stops calculating by itself.
+	bool is_finite() const;
+};
+
+bool operator==(const Search_limits& lhs, const Search_limits& rhs);
+bool operator!=(const Search_limits& lhs, const Search_limits& rhs);
+
+/**
+ * Get the UCI go command for the given limits.
+ *
+ * \param limits Limits for the calculation.
+ * \return go command, without a trailing newline (e.g. "go depth 20 movetime 1500").
+ */
+std::string to_go_command(const Search_limits& limits);
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,101 @@
+/**
+ * \file Seqlock.h
+ * \brief Contains a value which one thread updates and any number of threads read without locking.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Seqlock
+ * \brief Holds a value which is updated by a single writer and read concurrently by any number of
+ * readers, without the readers ever blocking the writer.
+ *
+ * The writer bumps a sequence number before and after each update. A reader copies the value, and
+ * tries again if the sequence number shows that an update started or finished meanwhile. Reads are
+ * therefore cheap as long as the value isn't updated much more often than it's read, which suits
+ * e.g. progress shown while an engine calculates.
+ *
+ * The value is stored as an array of atomic words, so that copying it while it's being updated
+ * isn't a data race.
+ *
+ * \tparam T Type of the value. Must be trivially copyable, and default constructible.
+ */
+template<class T>
+class Seqlock
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Seqlock values are copied byte by byte");
+
+public:
+	/// Hold a default constructed value.
+	Seqlock()
+	{
+		store(T());
+		// The initial value doesn't count as an update (see version())
+		sequence_.store(0, std::memory_order_relaxed);
+	}
+
+	Seqlock(const Seqlock&) = delete;
+	Seqlock& operator=(const Seqlock&) = delete;
+
+	/// Replace the value. Only one thread may store at a time.
+	void store(const T& value)
+	{
+		Words words{};
+		std::memcpy(words.data(), &value, sizeof(T));
+		uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+		// An odd sequence number tells readers that an update is in progress
+		sequence_.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (size_t i = 0; i < num_words; ++i)
+			words_[i].store(words[i], std::memory_order_relaxed);
+		sequence_.store(sequence + 2, std::memory_order_release);
+	}
+
+	/// Get a copy of the value. Can be called from any thread, also while the value is being stored.
+	T load() const
+	{
+		Words words;
+		while (true) {
+			uint64_t before = sequence_.load(std::memory_order_acquire);
+			if (before % 2 != 0) {
+				// The writer is in the middle of an update, which only takes a moment
+				std::this_thread::yield();
+				continue;
+			}
+			for (size_t i = 0; i < num_words; ++i)
+				words[i] = words_[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence_.load(std::memory_order_relaxed) == before)
+				break;
+		}
+		T value;
+		std::memcpy(&value, words.data(), sizeof(T));
+		return value;
+	}
+
+	/// Number of times the value has been stored, e.g. to check whether it has changed since the last read.
+	uint64_t version() const
+	{
+		return sequence_.load(std::memory_order_acquire) / 2;
+	}
+
+private:
+	static constexpr size_t num_words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	using Words = std::array<uint64_t, num_words>;
+
+	std::atomic<uint64_t> sequence_{0};
+	std::array<std::atomic<uint64_t>, num_words> words_;
+};
+
+} // namespace uci
+} // namespace chess
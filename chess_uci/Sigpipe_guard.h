@@ -0,0 +1,57 @@
+/**
+ * \file Sigpipe_guard.h
+ * \brief Contains a guard making writes to engines which have exited fail instead of ending the program.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <ctime>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Sigpipe_guard
+ * \brief Blocks SIGPIPE for the current thread while in scope, and discards any SIGPIPE raised
+ * meanwhile, so that writing to an engine which has exited fails with EPIPE instead of ending the
+ * program.
+ */
+class Sigpipe_guard
+{
+public:
+	Sigpipe_guard()
+	{
+		sigemptyset(&sigpipe_);
+		sigaddset(&sigpipe_, SIGPIPE);
+		pthread_sigmask(SIG_BLOCK, &sigpipe_, &old_mask_);
+		sigset_t pending;
+		sigpending(&pending);
+		was_pending_ = sigismember(&pending, SIGPIPE) == 1;
+	}
+
+	~Sigpipe_guard()
+	{
+		if (!was_pending_) {
+			// Consume the signal raised by our own writes, if any
+			timespec no_wait{0, 0};
+			while (sigtimedwait(&sigpipe_, nullptr, &no_wait) == SIGPIPE)
+				;
+		}
+		pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+	}
+
+	Sigpipe_guard(const Sigpipe_guard&) = delete;
+	Sigpipe_guard& operator=(const Sigpipe_guard&) = delete;
+
+private:
+	sigset_t sigpipe_;
+	sigset_t old_mask_;
+	/// Whether or not a SIGPIPE was already pending, in which case it's not ours to discard.
+	bool was_pending_{false};
+};
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,102 @@
+#include "Spare_engines.h"
+
+#include <utility>
+
+namespace chess {
+namespace uci {
+
+Spare_engines::Spare_engines(const Engine_endpoint& endpoint, size_t num_spares, uint8_t num_best_lines, Setup setup)
+	: endpoint_(endpoint)
+	, num_spares_(num_spares)
+	, num_best_lines_(num_best_lines)
+	, setup_(std::move(setup))
+{
+	refill_thread_ = std::thread([this]() {
+		refill();
+	});
+}
+
+Spare_engines::~Spare_engines()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	changed_.notify_all();
+	refill_thread_.join();
+}
+
+std::unique_ptr<Engine> Spare_engines::take()
+{
+	std::unique_ptr<Engine> engine;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!spares_.empty()) {
+			engine = std::move(spares_.front());
+			spares_.pop_front();
+		}
+		// Try again, in case starting engines failed for a passing reason
+		start_failed_ = false;
+	}
+	changed_.notify_all();
+	if (!engine)
+		engine = start_engine();
+	return engine;
+}
+
+size_t Spare_engines::num_ready() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return spares_.size();
+}
+
+void Spare_engines::wait_until_ready() const
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	changed_.wait(lock, [this]() {
+		return spares_.size() >= num_spares_ || start_failed_ || stopping_;
+	});
+}
+
+void Spare_engines::refill()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true) {
+		changed_.wait(lock, [this]() {
+			return stopping_ || (spares_.size() < num_spares_ && !start_failed_);
+		});
+		if (stopping_)
+			return;
+
+		size_t num_missing = num_spares_ - spares_.size();
+		lock.unlock();
+		std::vector<std::unique_ptr<Engine>> engines;
+		bool failed = false;
+		try {
+			engines = Engine::start_engines(endpoint_, num_missing, num_best_lines_);
+			if (setup_)
+				for (auto& engine : engines)
+					setup_(*engine);
+		} catch (...) {
+			// Reported when a caller has to start an engine itself
+			engines.clear();
+			failed = true;
+		}
+		lock.lock();
+		for (auto& engine : engines)
+			spares_.push_back(std::move(engine));
+		start_failed_ = failed;
+		changed_.notify_all();
+	}
+}
+
+std::unique_ptr<Engine> Spare_engines::start_engine() const
+{
+	auto engine = std::make_unique<Engine>(endpoint_, num_best_lines_);
+	if (setup_)
+		setup_(*engine);
+	return engine;
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,96 @@
+/**
+ * \file Spare_engines.h
+ * \brief Contains a standby pool of started engines, which can be handed out without waiting.
+ */
+
+#pragma once
+
+#include "Engine.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace chess {
+namespace uci {
+
+/**
+ * \class Spare_engines
+ * \brief Keeps a number of engines started and ready for use, and starts replacements in the
+ * background as engines are taken.
+ *
+ * Starting an engine takes from milliseconds up to seconds (e.g. for loading a neural network),
+ * which is too long to wait for when e.g. a new game or a failed engine needs a replacement right
+ * away. Taking a spare engine only waits if all spares have been taken.
+ *
+ * All member functions are thread safe.
+ */
+class Spare_engines
+{
+public:
+	/// Function called with each engine when it has been started, e.g. to set options.
+	using Setup = std::function<void(Engine&)>;
+
+	/**
+	 * Start the spare engines. Returns right away, while the engines start in the background.
+	 *
+	 * \param endpoint Engine to use (see Engine::Engine()).
+	 * \param num_spares Number of engines to keep ready.
+	 * \param num_best_lines Number of best lines each engine should suggest.
+	 * \param setup Function called with each engine when it has been started, if any.
+	 */
+	Spare_engines(
+		const Engine_endpoint& endpoint,
+		size_t num_spares,
+		uint8_t num_best_lines = 1,
+		Setup setup = nullptr);
+	/// Stop the spare engines which haven't been taken. Taken engines are unaffected.
+	~Spare_engines();
+
+	Spare_engines(const Spare_engines&) = delete;
+	Spare_engines& operator=(const Spare_engines&) = delete;
+
+	/**
+	 * Take a ready engine, and start a replacement in the background.
+	 *
+	 * If there is no spare engine ready, an engine is started by the calling thread.
+	 *
+	 * \return Engine, ready for use.
+	 * \throw std::runtime_error if no spare is ready and the engine fails to start.
+	 */
+	std::unique_ptr<Engine> take();
+
+	/// Number of engines ready to be taken.
+	size_t num_ready() const;
+	/// Wait until all spare engines have been started, or starting an engine has failed.
+	void wait_until_ready() const;
+
+private:
+	/// Start engines until there are num_spares_ of them. Runs in refill_thread_.
+	void refill();
+	/// Start an engine and run the setup on it.
+	std::unique_ptr<Engine> start_engine() const;
+
+	Engine_endpoint endpoint_;
+	size_t num_spares_;
+	uint8_t num_best_lines_;
+	Setup setup_;
+
+	mutable std::mutex mutex_;
+	/// Notified when engines are taken or added, and when stopping.
+	mutable std::condition_variable changed_;
+	std::deque<std::unique_ptr<Engine>> spares_;
+	/// Whether or not the last attempt to start engines failed. Cleared when an engine is taken.
+	bool start_failed_{false};
+	bool stopping_{false};
+	std::thread refill_thread_;
+};
+
+} // namespace uci
+} // namespace chess
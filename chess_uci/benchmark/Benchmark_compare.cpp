@@ -0,0 +1,104 @@
+/**
+ * \file Benchmark_compare.cpp
+ * \brief Command line tool comparing benchmark results written by uci_benchmark with a baseline.
+ *
+ * Exits with a non-zero status if any benchmark has become worse than the baseline by more than
+ * the threshold, so that it can be used to catch performance regressions in scripts.
+ */
+
+#include "Benchmark_results.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace chess::uci::benchmark;
+
+const char* usage = R"(Usage: benchmark_compare [options] BASELINE CURRENT
+
+Compare the benchmark results in CURRENT with those in BASELINE, both JSON files
+written by uci_benchmark --json.
+
+Options:
+  --threshold PERCENT Largest change for the worse that isn't reported as a
+                      regression (default: 5).
+)";
+
+std::vector<Benchmark_result> read_results(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("Can't open " + path);
+	return read_json(file);
+}
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	double threshold = 5;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--threshold" && i + 1 < argc)
+			threshold = std::stod(argv[++i]);
+		else if (argument.size() > 1 && argument[0] == '-') {
+			std::cerr << usage;
+			return 2;
+		} else
+			paths.push_back(argument);
+	}
+	if (paths.size() != 2) {
+		std::cerr << usage;
+		return 2;
+	}
+
+	std::vector<Benchmark_result> baseline;
+	std::vector<Benchmark_result> current;
+	try {
+		baseline = read_results(paths[0]);
+		current = read_results(paths[1]);
+	} catch (const std::exception& error) {
+		std::cerr << "Error: " << error.what() << std::endl;
+		return 2;
+	}
+
+	std::map<std::string, const Benchmark_result*> baseline_by_name;
+	for (const Benchmark_result& result : baseline)
+		baseline_by_name[result.name] = &result;
+
+	size_t num_regressions = 0;
+	std::cout << std::left << std::setw(28) << "benchmark" << std::right << std::setw(16) << "baseline"
+			  << std::setw(16) << "current" << std::setw(10) << "change" << std::endl;
+	for (const Benchmark_result& result : current) {
+		auto it = baseline_by_name.find(result.name);
+		std::cout << std::left << std::setw(28) << result.name << std::right << std::fixed << std::setprecision(3);
+		if (it == baseline_by_name.end()) {
+			std::cout << std::setw(16) << "-" << std::setw(16) << result.value << std::setw(10) << "new" << std::endl;
+			continue;
+		}
+		double base = it->second->value;
+		// Relative change, positive when the result has improved
+		double change = base == 0 ? 0 : 100 * (result.value - base) / std::abs(base);
+		if (!result.higher_is_better)
+			change = -change;
+		bool is_regression = change < -threshold;
+		num_regressions += is_regression;
+		std::cout << std::setw(16) << base << std::setw(16) << result.value << std::setw(9) << std::showpos
+				  << std::setprecision(1) << change << std::noshowpos << '%' << (is_regression ? "  REGRESSION" : "") << std::endl;
+	}
+
+	if (num_regressions > 0) {
+		std::cout << num_regressions << " benchmark(s) regressed by more than " << threshold << "%" << std::endl;
+		return 1;
+	}
+	return 0;
+}
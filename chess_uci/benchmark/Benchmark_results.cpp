@@ -0,0 +1,163 @@
+#include "Benchmark_results.h"
+
+#include <cctype>
+#include <iomanip>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+
+namespace chess {
+namespace uci {
+namespace benchmark {
+
+namespace {
+
+/// Minimal reader for the JSON documents written by write_json().
+class Json_reader
+{
+public:
+	explicit Json_reader(std::string text)
+		: text_(std::move(text))
+	{}
+
+	/// Skip whitespace, and check whether the next character is the given one.
+	bool peek(char c)
+	{
+		skip_whitespace();
+		return pos_ < text_.size() && text_[pos_] == c;
+	}
+
+	void expect(char c)
+	{
+		if (!peek(c))
+			fail(std::string("expected '") + c + "'");
+		++pos_;
+	}
+
+	std::string read_string()
+	{
+		expect('"');
+		std::string result;
+		while (pos_ < text_.size() && text_[pos_] != '"') {
+			if (text_[pos_] == '\\' && pos_ + 1 < text_.size())
+				++pos_;
+			result += text_[pos_++];
+		}
+		expect('"');
+		return result;
+	}
+
+	double read_number()
+	{
+		skip_whitespace();
+		size_t length = 0;
+		double value = 0;
+		try {
+			value = std::stod(text_.substr(pos_, 32), &length);
+		} catch (const std::logic_error&) {
+			fail("expected a number");
+		}
+		pos_ += length;
+		return value;
+	}
+
+	bool read_bool()
+	{
+		skip_whitespace();
+		if (text_.compare(pos_, 4, "true") == 0) {
+			pos_ += 4;
+			return true;
+		}
+		if (text_.compare(pos_, 5, "false") == 0) {
+			pos_ += 5;
+			return false;
+		}
+		fail("expected true or false");
+		return false;
+	}
+
+	[[noreturn]] void fail(const std::string& reason) const
+	{
+		throw std::runtime_error("Error reading benchmark results: " + reason + " at offset " + std::to_string(pos_));
+	}
+
+private:
+	void skip_whitespace()
+	{
+		while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+			++pos_;
+	}
+
+	std::string text_;
+	size_t pos_{0};
+};
+
+std::string escape(const std::string& string)
+{
+	std::string escaped;
+	for (char c : string) {
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		escaped += c;
+	}
+	return escaped;
+}
+
+} // Anonymous namespace
+
+void write_json(std::ostream& stream, const std::vector<Benchmark_result>& results)
+{
+	stream << "{\n  \"benchmarks\": [";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Benchmark_result& result = results[i];
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "    {\"name\": \"" << escape(result.name) << "\", \"value\": " << std::setprecision(10) << result.value
+			   << ", \"unit\": \"" << escape(result.unit) << "\", \"higher_is_better\": " << (result.higher_is_better ? "true" : "false") << "}";
+	}
+	stream << "\n  ]\n}\n";
+}
+
+std::vector<Benchmark_result> read_json(std::istream& stream)
+{
+	Json_reader reader{std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>())};
+	std::vector<Benchmark_result> results;
+	reader.expect('{');
+	if (reader.read_string() != "benchmarks")
+		reader.fail("expected \"benchmarks\"");
+	reader.expect(':');
+	reader.expect('[');
+	while (!reader.peek(']')) {
+		if (!results.empty())
+			reader.expect(',');
+		reader.expect('{');
+		Benchmark_result result;
+		bool first = true;
+		while (!reader.peek('}')) {
+			if (!first)
+				reader.expect(',');
+			first = false;
+			std::string key = reader.read_string();
+			reader.expect(':');
+			if (key == "name")
+				result.name = reader.read_string();
+			else if (key == "value")
+				result.value = reader.read_number();
+			else if (key == "unit")
+				result.unit = reader.read_string();
+			else if (key == "higher_is_better")
+				result.higher_is_better = reader.read_bool();
+			else
+				reader.fail("unknown key \"" + key + "\"");
+		}
+		reader.expect('}');
+		results.push_back(std::move(result));
+	}
+	reader.expect(']');
+	reader.expect('}');
+	return results;
+}
+
+} // namespace benchmark
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,46 @@
+/**
+ * \file Benchmark_results.h
+ * \brief Contains the results of the benchmark suite, and reading and writing them as JSON.
+ */
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace chess {
+namespace uci {
+namespace benchmark {
+
+/// Result of a single benchmark.
+struct Benchmark_result
+{
+	/// Name of the benchmark, e.g. 'parse_info'.
+	std::string name;
+	/// Measured value.
+	double value{0};
+	/// Unit of the value, e.g. 'lines/s'.
+	std::string unit;
+	/// Whether larger values are better (rates) or worse (times, allocations).
+	bool higher_is_better{true};
+};
+
+/**
+ * Write benchmark results as a JSON document.
+ *
+ * The document has the form {"benchmarks": [{"name": ..., "value": ..., "unit": ...,
+ * "higher_is_better": ...}, ...]}.
+ */
+void write_json(std::ostream& stream, const std::vector<Benchmark_result>& results);
+
+/**
+ * Read benchmark results written by write_json().
+ *
+ * \throw std::runtime_error if the document isn't in the format written by write_json().
+ */
+std::vector<Benchmark_result> read_json(std::istream& stream);
+
+} // namespace benchmark
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,122 @@
+/**
+ * \file Parse_messages_benchmark.cpp
+ * \brief Measures how many engine info messages per second parse_info() handles, compared with
+ * the previous parser which searched the whole message once per entry.
+ *
+ * Build with optimizations enabled (e.g. -DCMAKE_BUILD_TYPE=Release) for meaningful numbers.
+ */
+
+#include "chess_uci/Parse_messages.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace chess::uci;
+
+/// The parser used before parse_info() was rewritten, kept as a reference point.
+namespace previous {
+
+std::vector<std::string> tokenize(const std::string& string, char delimeter)
+{
+	std::vector<std::string> tokens;
+	std::string string_copy = string;
+	const char delimeters[] = {delimeter, '\0'};
+	char* p = std::strtok(string_copy.data(), delimeters);
+	while (p) {
+		tokens.push_back(p);
+		p = std::strtok(NULL, delimeters);
+	}
+	return tokens;
+}
+
+Evaluation parse_score(const std::string& score)
+{
+	Evaluation evaluation;
+	if (score.substr(6, 4) == "mate") {
+		int mate_in_moves = std::stoi(score.substr(11));
+		if (mate_in_moves > 0)
+			evaluation.white_can_mate_in = mate_in_moves;
+		else
+			evaluation.black_can_mate_in = -mate_in_moves;
+		return evaluation;
+	}
+	size_t pos = 0;
+	int centi_pawns_evaluation = std::stoi(score.substr(9), &pos);
+	if (score.size() > 9 + pos && score.substr(9 + pos + 1) == "lowerbound")
+		evaluation.centi_pawns_lower_bound = centi_pawns_evaluation;
+	else if (score.size() > 9 + pos && score.substr(9 + pos + 1) == "upperbound")
+		evaluation.centi_pawns_upper_bound = centi_pawns_evaluation;
+	else
+		evaluation.centi_pawns = centi_pawns_evaluation;
+	return evaluation;
+}
+
+Info parse_info(const std::string& info_str)
+{
+	Info info;
+	if (size_t pos = info_str.rfind("pv"); pos != std::string::npos)
+		info.sequence_of_moves = tokenize(info_str.substr(pos).substr(3), ' ');
+	if (size_t pos = info_str.find("multipv"); pos != std::string::npos)
+		info.line_index = std::stoi(info_str.substr(pos + 8)) - 1;
+	if (size_t pos = info_str.find("score"); pos != std::string::npos)
+		info.evaluation = parse_score(info_str.substr(pos));
+	if (size_t pos = info_str.find("nodes"); pos != std::string::npos)
+		info.nodes = std::stoi(info_str.substr(pos + 6));
+	if (size_t pos = info_str.find("time"); pos != std::string::npos)
+		info.time = std::stoi(info_str.substr(pos + 5));
+	return info;
+}
+
+} // namespace previous
+
+/// Info messages in the format Stockfish sends them during a MultiPV 3 search.
+const std::vector<std::string> sample_messages = {
+	"info depth 18 seldepth 24 multipv 1 score cp 31 nodes 1842291 nps 1596439 hashfull 712 tbhits 0 time 1154 pv e2e4 e7e5 g1f3 b8c6 f1b5 g8f6 e1g1 f6e4 f1e1 e4d6 f3e5 f8e7 b5f1 c6e5 e1e5 e8g8",
+	"info depth 18 seldepth 22 multipv 2 score cp 24 nodes 1842291 nps 1596439 hashfull 712 tbhits 0 time 1154 pv d2d4 g8f6 c2c4 e7e6 g1f3 d7d5 b1c3 f8e7 c1f4 e8g8 e2e3 c7c5",
+	"info depth 18 seldepth 25 multipv 3 score cp 19 upperbound nodes 1842291 nps 1596439 hashfull 712 tbhits 0 time 1154 pv g1f3 d7d5 d2d4 g8f6 c2c4 e7e6 b1c3",
+	"info depth 19 currmove e2e4 currmovenumber 1",
+	"info depth 19 seldepth 27 multipv 1 score cp 35 lowerbound nodes 2310877 nps 1601440 hashfull 788 tbhits 0 time 1443 pv e2e4",
+	"info depth 23 seldepth 30 multipv 1 score mate 7 nodes 9933021 nps 1650113 hashfull 999 tbhits 12 time 6019 pv g2g7 e5d4 f1f4 d4c3 g7b7 c3d2 b7b2 d2e3 f4f3 e3e4 b2e2",
+};
+
+template<class Parser>
+double measure_lines_per_second(Parser parser, size_t num_rounds)
+{
+	size_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < num_rounds; ++round)
+		for (const std::string& message : sample_messages) {
+			Info info = parser(message);
+			checksum += info.sequence_of_moves.has_value() ? info.sequence_of_moves->size() : 1;
+		}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	if (checksum == 0)
+		throw std::logic_error("No messages parsed");
+	return double(num_rounds * sample_messages.size()) / elapsed.count();
+}
+
+} // Anonymous namespace
+
+int main()
+{
+	const size_t num_rounds = 200000;
+	double previous_rate = measure_lines_per_second([](const std::string& message) {
+		return previous::parse_info(message);
+	},
+		num_rounds);
+	double current_rate = measure_lines_per_second([](const std::string& message) {
+		return parse_info(message);
+	},
+		num_rounds);
+
+	std::cout << "Previous parser: " << previous_rate << " lines/s" << std::endl;
+	std::cout << "Current parser:  " << current_rate << " lines/s" << std::endl;
+	std::cout << "Speedup:         " << current_rate / previous_rate << "x" << std::endl;
+	return 0;
+}
@@ -0,0 +1,360 @@
+/**
+ * \file Uci_benchmark.cpp
+ * \brief Benchmark suite measuring the throughput of parsing and reading recorded engine output,
+ * and of the round trips to an engine process.
+ *
+ * Results are printed as a table, and optionally written as JSON (see Benchmark_results.h), which
+ * can be compared with a stored baseline using benchmark_compare.
+ *
+ * Build with optimizations enabled (e.g. -DCMAKE_BUILD_TYPE=Release) for meaningful numbers.
+ */
+
+#include "Benchmark_results.h"
+
+#include "chess_uci/Engine.h"
+#include "chess_uci/Engine_pool.h"
+#include "chess_uci/Line_reader.h"
+#include "chess_uci/Parse_messages.h"
+#include "chess_uci/Read_messages.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef BENCHMARK_DATA_DIR
+#define BENCHMARK_DATA_DIR "chess_uci/benchmark/data"
+#endif
+
+namespace {
+
+/// Number of heap allocations made by the whole program.
+std::atomic<uint64_t> num_allocations{0};
+
+} // Anonymous namespace
+
+void* operator new(std::size_t size)
+{
+	num_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size > 0 ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace {
+
+using namespace chess::uci;
+using namespace chess::uci::benchmark;
+
+const char* usage = R"(Usage: uci_benchmark [options]
+
+Run the benchmarks and print the results.
+
+Options:
+  --json FILE         Also write the results to FILE as JSON.
+  --engine PATH       Engine used for the engine benchmarks (default: ./dummy_engine).
+  --data DIR          Directory with the recorded engine output.
+  --filter TEXT       Only run benchmarks whose name contains TEXT.
+  --min-time MS       Minimum time to run each benchmark, in milliseconds (default: 500).
+)";
+
+struct Options
+{
+	std::string json;
+	std::string engine{"./dummy_engine"};
+	std::string data{BENCHMARK_DATA_DIR};
+	std::string filter;
+	std::chrono::milliseconds min_time{500};
+};
+
+Options parse_options(int argc, char* argv[])
+{
+	Options options;
+	auto value = [&](int& i) -> std::string {
+		if (i + 1 >= argc)
+			throw std::runtime_error(std::string("Missing value for ") + argv[i]);
+		return argv[++i];
+	};
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--json")
+			options.json = value(i);
+		else if (argument == "--engine")
+			options.engine = value(i);
+		else if (argument == "--data")
+			options.data = value(i);
+		else if (argument == "--filter")
+			options.filter = value(i);
+		else if (argument == "--min-time")
+			options.min_time = std::chrono::milliseconds(std::stoul(value(i)));
+		else if (argument == "--help" || argument == "-h")
+			throw std::runtime_error("");
+		else
+			throw std::runtime_error("Unknown option " + argument);
+	}
+	return options;
+}
+
+std::string read_file(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("Can't open " + path);
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+std::vector<std::string> split_lines(const std::string& text)
+{
+	std::vector<std::string> lines;
+	std::istringstream stream(text);
+	std::string line;
+	while (std::getline(stream, line))
+		lines.push_back(line);
+	return lines;
+}
+
+class Suite
+{
+public:
+	explicit Suite(const Options& options)
+		: options_(options)
+	{}
+
+	/**
+	 * Run a benchmark repeatedly for at least the minimum time, and record the rate.
+	 *
+	 * \param name Name of the benchmark.
+	 * \param unit Unit of the rate, e.g. 'lines/s'.
+	 * \param iteration Function running the benchmark once, returning the number of items handled.
+	 */
+	void rate(const std::string& name, const std::string& unit, const std::function<size_t()>& iteration)
+	{
+		if (!selected(name))
+			return;
+		uint64_t num_items = 0;
+		auto start = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed{0};
+		do {
+			num_items += iteration();
+			elapsed = std::chrono::steady_clock::now() - start;
+		} while (elapsed < options_.min_time);
+		record({name, static_cast<double>(num_items) / elapsed.count(), unit, true});
+	}
+
+	/// Record the average time of a benchmark run repeatedly for at least the minimum time.
+	void time(const std::string& name, const std::function<void()>& iteration)
+	{
+		if (!selected(name))
+			return;
+		uint64_t num_iterations = 0;
+		auto start = std::chrono::steady_clock::now();
+		std::chrono::duration<double, std::milli> elapsed{0};
+		do {
+			iteration();
+			++num_iterations;
+			elapsed = std::chrono::steady_clock::now() - start;
+		} while (elapsed < options_.min_time);
+		record({name, elapsed.count() / static_cast<double>(num_iterations), "ms", false});
+	}
+
+	/// Record the number of heap allocations per item made by a single run of a benchmark.
+	void allocations(const std::string& name, const std::function<size_t()>& iteration)
+	{
+		if (!selected(name))
+			return;
+		// Warm up, so that one-off allocations aren't counted
+		iteration();
+		uint64_t before = num_allocations.load(std::memory_order_relaxed);
+		size_t num_items = iteration();
+		uint64_t after = num_allocations.load(std::memory_order_relaxed);
+		record({name, static_cast<double>(after - before) / static_cast<double>(num_items), "allocations/line", false});
+	}
+
+	const std::vector<Benchmark_result>& results() const
+	{
+		return results_;
+	}
+
+private:
+	bool selected(const std::string& name) const
+	{
+		return name.find(options_.filter) != std::string::npos;
+	}
+
+	void record(const Benchmark_result& result)
+	{
+		std::cout << std::left << std::setw(28) << result.name << std::right << std::setw(16) << std::fixed
+				  << std::setprecision(result.value < 100 ? 3 : 0) << result.value << ' ' << result.unit << std::endl;
+		results_.push_back(result);
+	}
+
+	const Options& options_;
+	std::vector<Benchmark_result> results_;
+};
+
+void run_parsing_benchmarks(Suite& suite, const Options& options)
+{
+	const std::string search_output = read_file(options.data + "/stockfish_go_multipv3.txt");
+	const std::string uci_output = read_file(options.data + "/stockfish_uci.txt");
+	const std::vector<std::string> lines = split_lines(search_output);
+	std::vector<std::string> info_lines;
+	for (const std::string& line : lines)
+		if (is_search_info_message(line))
+			info_lines.push_back(line);
+	const std::vector<std::string> option_lines = split_lines(uci_output);
+
+	size_t checksum = 0;
+	auto parse_all_info = [&]() {
+		for (const std::string& line : info_lines) {
+			Info info = parse_info(line);
+			checksum += info.sequence_of_moves.has_value() ? info.sequence_of_moves->size() : 1;
+		}
+		return info_lines.size();
+	};
+	suite.rate("parse_info", "lines/s", parse_all_info);
+	suite.allocations("parse_info_allocations", parse_all_info);
+
+	suite.rate("tokenize", "lines/s", [&]() {
+		for (const std::string& line : lines)
+			checksum += impl::tokenize(line, ' ').size();
+		return lines.size();
+	});
+
+	suite.rate("parse_option", "lines/s", [&]() {
+		for (const std::string& line : option_lines)
+			checksum += parse_option(line).has_value();
+		return option_lines.size();
+	});
+
+	suite.rate("read_go_replies_stream", "lines/s", [&]() {
+		std::istringstream stream(search_output);
+		checksum += read_go_replies(stream).size();
+		return lines.size();
+	});
+
+	suite.rate("read_go_replies_pipe", "lines/s", [&]() {
+		// Write many copies of the output through a pipe, as an engine process would
+		const size_t num_copies = 64;
+		int fds[2];
+		if (::pipe(fds) != 0)
+			throw std::runtime_error("Can't create pipe");
+		std::thread writer([&search_output, fd = fds[1]]() {
+			for (size_t i = 0; i < num_copies; ++i) {
+				const char* data = search_output.data();
+				size_t remaining = search_output.size();
+				while (remaining > 0) {
+					ssize_t written = ::write(fd, data, remaining);
+					if (written <= 0)
+						break;
+					data += written;
+					remaining -= static_cast<size_t>(written);
+				}
+			}
+			::close(fd);
+		});
+		Line_reader reader(fds[0]);
+		for (size_t i = 0; i < num_copies; ++i)
+			checksum += read_go_replies(reader, [&checksum](std::string_view message) {
+				checksum += message.size();
+			}).size();
+		writer.join();
+		::close(fds[0]);
+		return num_copies * lines.size();
+	});
+
+	if (checksum == 0)
+		throw std::logic_error("Nothing parsed");
+}
+
+void run_engine_benchmarks(Suite& suite, const Options& options)
+{
+	const std::string fen = "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4";
+
+	suite.time("engine_handshake", [&]() {
+		Engine engine(options.engine);
+	});
+
+	{
+		Engine engine(options.engine);
+		suite.rate("engine_round_trip", "positions/s", [&]() {
+			engine.set_position_from_fen(fen);
+			engine.start_calculating(Search_limits::for_depth(1));
+			engine.wait_for_result();
+			return size_t(1);
+		});
+	}
+
+	{
+		Engine_pool pool(options.engine, std::max(1u, std::thread::hardware_concurrency()));
+		Analysis_job job;
+		job.fen = fen;
+		job.new_game = false;
+		job.limits = Search_limits::for_depth(1);
+		suite.rate("pool_positions", "positions/s", [&]() {
+			const size_t num_positions = 64;
+			std::vector<std::future<std::vector<Analyzed_line>>> results;
+			for (size_t i = 0; i < num_positions; ++i)
+				results.push_back(pool.submit(job));
+			for (auto& result : results)
+				result.get();
+			return num_positions;
+		});
+	}
+}
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	try {
+		options = parse_options(argc, argv);
+	} catch (const std::exception& error) {
+		if (error.what()[0] != '\0')
+			std::cerr << "Error: " << error.what() << "\n\n";
+		std::cerr << usage;
+		return EXIT_FAILURE;
+	}
+
+	try {
+		Suite suite(options);
+		run_parsing_benchmarks(suite, options);
+		run_engine_benchmarks(suite, options);
+
+		if (!options.json.empty()) {
+			std::ofstream file(options.json);
+			write_json(file, suite.results());
+			if (!file)
+				throw std::runtime_error("Can't write " + options.json);
+		}
+	} catch (const std::exception& error) {
+		std::cerr << "Error: " << error.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
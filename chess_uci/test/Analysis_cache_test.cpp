@@ -0,0 +1,95 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Analysis_cache.h"
+#include "chess_uci/Fen.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <future>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+const std::string start_position = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+const std::string other_position = "8/8/8/4k3/8/8/6Q1/5R1K w - - 0 20";
+
+} // Anonymous namespace
+
+TEST_CASE("chess::uci::Analysis_cache.Normalize FEN", "[cache], [chess], [uci]")
+{
+	CHECK(normalize_fen(start_position) == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -");
+	CHECK(normalize_fen("  8/8/8/4k3/8/8/6Q1/5R1K  w -  - 3 57") == "8/8/8/4k3/8/8/6Q1/5R1K w - -");
+}
+
+TEST_CASE("chess::uci::Analysis_cache.Reuse results", "[cache], [chess], [uci]")
+{
+	Engine_pool pool("./dummy_engine", 1);
+	Analysis_cache cache(pool, 1024 * 1024);
+
+	// First request is analyzed, second is answered from the cache even though the move counters differ
+	auto lines = cache.analyze({start_position, std::chrono::seconds(0)}).get();
+	REQUIRE((lines.size() == 1));
+	CHECK((lines.front().moves.front() == "e2e4"));
+	lines = cache.analyze({"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 5 9", std::chrono::seconds(0)}).get();
+	REQUIRE((lines.size() == 1));
+	Analysis_cache::Statistics statistics = cache.statistics();
+	CHECK(statistics.misses == 1);
+	CHECK(statistics.hits == 1);
+
+	// Longer calculations aren't answered by shorter ones, but shorter ones are answered by longer ones
+	cache.analyze({other_position, std::chrono::seconds(0)}).get();
+	cache.analyze({other_position, std::chrono::seconds(1)}).get();
+	cache.analyze({other_position, std::chrono::seconds(0)}).get();
+	statistics = cache.statistics();
+	CHECK(statistics.misses == 3);
+	CHECK(statistics.hits == 2);
+	CHECK(cache.size() == 2);
+	CHECK(cache.memory_usage() > 0);
+}
+
+TEST_CASE("chess::uci::Analysis_cache.Share running analyses", "[cache], [chess], [uci]")
+{
+	Engine_pool pool("./dummy_engine", 1);
+	Analysis_cache cache(pool, 1024 * 1024);
+
+	// Keep the only engine busy, so that the analysis can't finish before the second request
+	std::promise<void> release_engine;
+	std::shared_future<void> engine_released = release_engine.get_future().share();
+	pool.execute([engine_released](Engine&) {
+		engine_released.wait();
+	});
+
+	auto first = cache.analyze({start_position, std::chrono::seconds(0)});
+	auto second = cache.analyze({start_position, std::chrono::seconds(0)});
+	Analysis_cache::Statistics statistics = cache.statistics();
+	CHECK(statistics.misses == 1);
+	CHECK(statistics.coalesced == 1);
+
+	release_engine.set_value();
+	CHECK((first.get().size() == 1));
+	CHECK((second.get().size() == 1));
+}
+
+TEST_CASE("chess::uci::Analysis_cache.Evict least recently used results", "[cache], [chess], [uci]")
+{
+	Engine_pool pool("./dummy_engine", 1);
+	// Only room for a single result
+	Analysis_cache cache(pool, 600);
+
+	cache.analyze({start_position, std::chrono::seconds(0)}).get();
+	REQUIRE(cache.size() == 1);
+	REQUIRE(cache.memory_usage() <= 600);
+	cache.analyze({other_position, std::chrono::seconds(0)}).get();
+	CHECK(cache.size() == 1);
+	CHECK(cache.statistics().evictions == 1);
+
+	// The most recent result is kept
+	cache.analyze({other_position, std::chrono::seconds(0)}).get();
+	CHECK(cache.statistics().hits == 1);
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,103 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Analysis_store.h"
+
+#include <catch2/catch.hpp>
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// Path to a store file which is removed when it goes out of scope.
+struct Temporary_store_path
+{
+	Temporary_store_path()
+		: path(std::filesystem::temp_directory_path() / ("analysis_store_test_" + std::to_string(::getpid()) + ".store"))
+	{}
+	~Temporary_store_path()
+	{
+		std::filesystem::remove(path);
+	}
+
+	std::filesystem::path path;
+};
+
+Analyzed_line make_line(std::vector<std::string> moves, int16_t centi_pawns)
+{
+	Analyzed_line line;
+	line.moves = std::move(moves);
+	line.evaluation.centi_pawns = centi_pawns;
+	return line;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("chess::uci::Analysis_store.Store and find positions", "[store], [chess], [uci]")
+{
+	Temporary_store_path store_path;
+	const std::string position = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+	{
+		Analysis_store store = Analysis_store::create(store_path.path, 100);
+		CHECK(store.num_slots() >= 100);
+		CHECK(store.size() == 0);
+		CHECK(!store.find(position).has_value());
+
+		std::vector<Analyzed_line> lines = {make_line({"e2e4", "e7e5"}, 31), make_line({"d2d4"}, 24)};
+		CHECK(store.insert(position, 20, lines));
+		// Positions are only added once, regardless of the move counters
+		CHECK(!store.insert("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 4 3", 25, lines));
+		CHECK(store.size() == 1);
+
+		// Only one process can write to the store at a time
+		CHECK_THROWS_AS(Analysis_store(store_path.path, Analysis_store::Access::read_write), std::system_error);
+
+		// Readers see the entries added by the writer while it's still open
+		Analysis_store reader(store_path.path, Analysis_store::Access::read_only);
+		CHECK(reader.find(position).has_value());
+		CHECK_THROWS_AS(reader.insert(position, 1, lines), std::logic_error);
+	}
+
+	// Entries are kept when the store is reopened
+	Analysis_store store(store_path.path, Analysis_store::Access::read_only);
+	CHECK(store.size() == 1);
+	std::optional<Stored_analysis> analysis = store.find(position);
+	REQUIRE(analysis.has_value());
+	CHECK(analysis->depth == 20);
+	REQUIRE(analysis->lines.size() == 2);
+	CHECK(to_string(analysis->lines[0].moves) == "e2e4 e7e5");
+	CHECK(*analysis->lines[0].evaluation.to_evaluation().centi_pawns == 31);
+	CHECK(to_string(analysis->lines[1].moves) == "d2d4");
+	CHECK(!store.find("8/8/8/4k3/8/8/6Q1/5R1K w - - 0 20").has_value());
+}
+
+TEST_CASE("chess::uci::Analysis_store.Full store", "[store], [chess], [uci]")
+{
+	Temporary_store_path store_path;
+	Analysis_store store = Analysis_store::create(store_path.path, 4);
+
+	// Fill the store with made up positions, until no more fit
+	size_t num_inserted = 0;
+	for (int i = 0; i < 100; ++i)
+		if (store.insert("8/8/8/8/8/8/8/8 w - - " + std::to_string(i) + " 1", 1, {make_line({"e2e4"}, i)}))
+			num_inserted += 1;
+	// The move counters are dropped when positions are normalized, so only the first one fits
+	CHECK(num_inserted == 1);
+
+	// Add distinct positions until the store is full. One slot is always left empty.
+	for (int file = 1; file <= 8; ++file)
+		for (int rank = 1; rank <= 8; ++rank)
+			store.insert(std::to_string(rank) + "K" + std::to_string(8 - rank) + "/8/8/8/8/8/8/" + std::to_string(file) + " w - -", 1, {make_line({"e2e4"}, 0)});
+	CHECK(store.size() == store.num_slots() - 1);
+	CHECK(!store.find("8/8/8/8/8/8/8/7K w - -").has_value());
+}
+
+} // namespace uci
+} // namespace chess
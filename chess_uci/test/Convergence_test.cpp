@@ -0,0 +1,60 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Convergence.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+namespace chess {
+namespace uci {
+
+TEST_CASE("chess::uci::Convergence_tracker.Stable best move converges", "[convergence], [chess], [uci]")
+{
+	Convergence_tracker tracker({4, 3, 10});
+
+	// Not deep enough yet, even though the best move is stable
+	CHECK(!tracker.update(parse_info("info depth 1 score cp 20 pv e2e4 e7e5")));
+	CHECK(!tracker.update(parse_info("info depth 2 score cp 25 pv e2e4 c7c5")));
+	CHECK(!tracker.update(parse_info("info depth 3 score cp 22 pv e2e4 e7e5")));
+	CHECK((tracker.num_stable_depths() == 3));
+	// Other lines than the best one don't count
+	CHECK(!tracker.update(parse_info("info depth 4 multipv 2 score cp 10 pv d2d4 d7d5")));
+	CHECK(tracker.update(parse_info("info depth 4 multipv 1 score cp 18 pv e2e4 e7e5")));
+	CHECK(tracker.has_converged());
+	// Once converged, it stays converged
+	CHECK(tracker.update(parse_info("info depth 5 score cp -200 pv d2d4")));
+}
+
+TEST_CASE("chess::uci::Convergence_tracker.Changes start over", "[convergence], [chess], [uci]")
+{
+	Convergence_tracker tracker({1, 3, 10});
+	CHECK(!tracker.update(parse_info("info depth 1 score cp 20 pv e2e4")));
+	CHECK(!tracker.update(parse_info("info depth 2 score cp 20 pv e2e4")));
+	// A new best move
+	CHECK(!tracker.update(parse_info("info depth 3 score cp 20 pv d2d4")));
+	CHECK((tracker.num_stable_depths() == 1));
+	CHECK(!tracker.update(parse_info("info depth 4 score cp 25 pv d2d4")));
+	// A score which changes too much
+	CHECK(!tracker.update(parse_info("info depth 5 score cp 60 pv d2d4")));
+	CHECK((tracker.num_stable_depths() == 1));
+	// A bound while the engine re-searches
+	CHECK(!tracker.update(parse_info("info depth 6 score cp 70 lowerbound pv d2d4")));
+	CHECK((tracker.num_stable_depths() == 0));
+	CHECK(!tracker.update(parse_info("info depth 6 score cp 65 pv d2d4")));
+	CHECK(!tracker.update(parse_info("info depth 7 score cp 66 pv d2d4")));
+	CHECK(tracker.update(parse_info("info depth 8 score cp 68 pv d2d4")));
+}
+
+TEST_CASE("chess::uci::Convergence_tracker.Mate scores", "[convergence], [chess], [uci]")
+{
+	Convergence_tracker tracker({1, 2, 1000});
+	CHECK(!tracker.update(parse_info("info depth 10 score mate 3 pv h5f7")));
+	// A shorter mate is a change, however large the allowed change in centi pawns
+	CHECK(!tracker.update(parse_info("info depth 11 score mate 2 pv h5f7")));
+	CHECK(!tracker.update(parse_info("info depth 12 score cp 500 pv h5f7")));
+	CHECK(tracker.update(parse_info("info depth 13 score cp 900 pv h5f7")));
+}
+
+} // namespace uci
+} // namespace chess
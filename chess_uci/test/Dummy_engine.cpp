@@ -1,29 +1,351 @@
+/**
+ * \file Dummy_engine.cpp
+ * \brief Fake UCI engine used to test (and load test) the engine interfaces without a real engine.
+ *
+ * Without options the engine answers every search with a single fixed info line and the best move
+ * e2e4. Searches with limits finish right away, infinite searches wait for stop, and pondering
+ * waits for ponderhit or stop.
+ *
+ * Options make the engine behave more like a real engine under load, e.g. sending info lines at a
+ * given rate with several lines and long principal variations, taking time to start and search,
+ * or misbehaving by crashing, hanging or writing garbage. Options are given on the command line, or, since
+ * the engine interfaces don't pass any arguments, in the DUMMY_ENGINE_ARGS environment variable,
+ * e.g. DUMMY_ENGINE_ARGS="--info-rate 100000 --multipv 3 --pv-length 20".
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* usage = R"(Usage: dummy_engine [options]
+
+Options (also read from the DUMMY_ENGINE_ARGS environment variable):
+  --info-rate N       Send N info lines per second while searching (default: a single
+                      info line per search).
+  --multipv N         Number of lines to report (default: the MultiPV option, 1).
+  --pv-length N       Number of moves in each reported line (default: 1).
+  --search-time MS    Time searches with limits take (default: 0, finish right away).
+  --startup-delay MS  Time to wait before replying to uci (default: 0).
+  --ready-delay MS    Time to wait before replying readyok (default: 0).
+  --crash-after N     Exit abruptly in the middle of search number N (default: never).
+  --hang-after N      Stop responding, also to stop and quit, at search number N (default: never).
+  --garbage-rate P    Probability, between 0 and 1, of writing a garbage line before each
+                      info line (default: 0).
+  --seed N            Seed for the varied scores and garbage (default: 1).
+)";
 
-int main()
+struct Config
 {
-	while (true) {
-		std::string command;
-		std::getline(std::cin, command);
+	double info_rate{0};
+	unsigned multipv{0};
+	unsigned pv_length{1};
+	std::chrono::milliseconds search_time{0};
+	std::chrono::milliseconds startup_delay{0};
+	std::chrono::milliseconds ready_delay{0};
+	unsigned crash_after{0};
+	unsigned hang_after{0};
+	double garbage_rate{0};
+	unsigned seed{1};
+};
+
+void parse_arguments(const std::vector<std::string>& arguments, Config& config)
+{
+	for (size_t i = 0; i < arguments.size(); ++i) {
+		const std::string& argument = arguments[i];
+		if (i + 1 >= arguments.size())
+			throw std::runtime_error("Missing value for " + argument);
+		const std::string& value = arguments[++i];
+		if (argument == "--info-rate")
+			config.info_rate = std::stod(value);
+		else if (argument == "--multipv")
+			config.multipv = std::stoul(value);
+		else if (argument == "--pv-length")
+			config.pv_length = std::stoul(value);
+		else if (argument == "--search-time")
+			config.search_time = std::chrono::milliseconds(std::stoul(value));
+		else if (argument == "--startup-delay")
+			config.startup_delay = std::chrono::milliseconds(std::stoul(value));
+		else if (argument == "--ready-delay")
+			config.ready_delay = std::chrono::milliseconds(std::stoul(value));
+		else if (argument == "--crash-after")
+			config.crash_after = std::stoul(value);
+		else if (argument == "--hang-after")
+			config.hang_after = std::stoul(value);
+		else if (argument == "--garbage-rate")
+			config.garbage_rate = std::stod(value);
+		else if (argument == "--seed")
+			config.seed = std::stoul(value);
+		else
+			throw std::runtime_error("Unknown option " + argument);
+	}
+}
+
+/// Moves the reported lines are made of. Not a legal game, but the parsers don't care.
+const std::vector<std::string> moves = {
+	"e2e4", "e7e5", "g1f3", "b8c6", "f1b5", "a7a6", "b5a4", "g8f6", "e1g1", "f8e7", "f1e1", "b7b5",
+	"a4b3", "d7d6", "c2c3", "e8g8", "h2h3", "c6a5", "b3c2", "c7c5", "d2d4", "d8c7", "b1d2", "c5d4"};
+/// First move of each reported line.
+const std::vector<std::string> first_moves = {"e2e4", "d2d4", "g1f3", "c2c4", "e2e3", "b1c3", "g2g3", "b2b3"};
+
+/// Writes lines to the standard output, from the thread reading commands and the search thread.
+class Output
+{
+public:
+	/// Write a line, without flushing.
+	void write(const std::string& line)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::fwrite(line.data(), 1, line.size(), stdout);
+		std::fputc('\n', stdout);
+	}
+
+	void flush()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::fflush(stdout);
+	}
+
+private:
+	std::mutex mutex_;
+};
+
+/**
+ * A running search. The search either finishes by itself, after the configured search time, or
+ * when it's stopped.
+ */
+class Search
+{
+public:
+	Search(const Config& config, Output& output, unsigned multipv, unsigned search_number, bool finishes_by_itself, std::mt19937& random)
+		: config_(config)
+		, output_(output)
+		, multipv_(multipv)
+		, search_number_(search_number)
+		, finishes_by_itself_(finishes_by_itself)
+		, random_(random)
+		, start_(std::chrono::steady_clock::now())
+	{
+		thread_ = std::thread([this]() {
+			run();
+		});
+	}
+
+	~Search()
+	{
+		stop();
+	}
+
+	/// Make the search finish by itself (e.g. after ponderhit).
+	void finish_by_itself()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		finishes_by_itself_ = true;
+		changed_.notify_all();
+	}
+
+	/// Stop the search, and wait until the best move has been sent.
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_requested_ = true;
+			changed_.notify_all();
+		}
+		if (thread_.joinable())
+			thread_.join();
+	}
+
+private:
+	void run()
+	{
+		uint64_t num_lines_sent = 0;
+		auto finish_time = start_ + config_.search_time;
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true) {
+			auto now = std::chrono::steady_clock::now();
+			// Send the lines which are due, in one go. Without a rate each line is sent once.
+			uint64_t num_due = multipv_;
+			if (config_.info_rate > 0)
+				num_due += static_cast<uint64_t>(std::chrono::duration<double>(now - start_).count() * config_.info_rate);
+			if (num_due > num_lines_sent) {
+				lock.unlock();
+				write_info_lines(num_due - num_lines_sent);
+				lock.lock();
+				num_lines_sent = num_due;
+			}
+
+			if (config_.crash_after != 0 && search_number_ == config_.crash_after) {
+				// Leave a partial line behind, as a crashing engine might
+				std::fputs("info depth 3 score", stdout);
+				std::fflush(stdout);
+				std::_Exit(EXIT_FAILURE);
+			}
+			if (stop_requested_ || (finishes_by_itself_ && now >= finish_time))
+				break;
+
+			auto next_wakeup = finishes_by_itself_ ? finish_time : now + std::chrono::hours(1);
+			if (config_.info_rate > 0)
+				next_wakeup = std::min(next_wakeup, now + std::chrono::milliseconds(1));
+			changed_.wait_until(lock, next_wakeup);
+		}
+		lock.unlock();
+		output_.write("bestmove e2e4 ponder e7e5");
+		output_.flush();
+	}
+
+	/// Write the given number of info lines, cycling through the multipv lines, and flush.
+	void write_info_lines(uint64_t num_lines)
+	{
+		for (uint64_t i = 0; i < num_lines; ++i) {
+			if (config_.garbage_rate > 0 && std::uniform_real_distribution<double>(0, 1)(random_) < config_.garbage_rate)
+				output_.write(garbage_line());
+			output_.write(info_line());
+		}
+		output_.flush();
+	}
+
+	std::string info_line()
+	{
+		unsigned line = next_line_ % multipv_;
+		if (line == 0)
+			depth_ += 1;
+		next_line_ += 1;
+		nodes_ += 1000;
+
+		if (config_.info_rate <= 0 && config_.pv_length == 1)
+			// The fixed reply of the plain dummy engine
+			return "info depth " + std::to_string(depth_) + " multipv " + std::to_string(line + 1) + " score cp " + std::to_string(30 - 5 * static_cast<int>(line))
+				   + " nodes " + std::to_string(nodes_) + " pv " + first_moves[line % first_moves.size()];
+
+		std::ostringstream info;
+		info << "info depth " << depth_ << " seldepth " << depth_ + 4 << " multipv " << line + 1 << " score ";
+		int score = std::uniform_int_distribution<int>(-150, 150)(random_);
+		if (score > 145)
+			info << "mate " << (score - 140);
+		else if (score < -145)
+			info << "mate " << (score + 140);
+		else
+			info << "cp " << score;
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+		info << " nodes " << nodes_ << " nps " << nodes_ * 1000 / (elapsed + 1) << " time " << elapsed << " pv " << first_moves[line % first_moves.size()];
+		for (unsigned i = 1; i < config_.pv_length; ++i)
+			info << ' ' << moves[(line + i) % moves.size()];
+		return info.str();
+	}
+
+	std::string garbage_line()
+	{
+		std::string line;
+		size_t length = std::uniform_int_distribution<size_t>(1, 80)(random_);
+		for (size_t i = 0; i < length; ++i)
+			line += static_cast<char>(std::uniform_int_distribution<int>('!', '~')(random_));
+		if (line.compare(0, 4, "info") == 0 || line.compare(0, 8, "bestmove") == 0)
+			line[0] = '#';
+		return line;
+	}
+
+	const Config& config_;
+	Output& output_;
+	unsigned multipv_;
+	unsigned search_number_;
+	bool finishes_by_itself_;
+	std::mt19937& random_;
+	std::chrono::steady_clock::time_point start_;
+
+	std::mutex mutex_;
+	std::condition_variable changed_;
+	bool stop_requested_{false};
+	unsigned depth_{0};
+	unsigned next_line_{0};
+	uint64_t nodes_{0};
+	std::thread thread_;
+};
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	Config config;
+	try {
+		std::vector<std::string> arguments(argv + 1, argv + argc);
+		if (const char* environment_arguments = std::getenv("DUMMY_ENGINE_ARGS")) {
+			std::istringstream stream(environment_arguments);
+			std::string argument;
+			while (stream >> argument)
+				arguments.push_back(argument);
+		}
+		parse_arguments(arguments, config);
+	} catch (const std::exception& error) {
+		std::cerr << "Error: " << error.what() << "\n\n"
+				  << usage;
+		return EXIT_FAILURE;
+	}
+
+	Output output;
+	std::mt19937 random(config.seed);
+	unsigned multipv_option = 1;
+	unsigned num_searches = 0;
+	std::unique_ptr<Search> search;
+	bool has_limit = false;
+
+	std::string command;
+	while (std::getline(std::cin, command)) {
 		if (command == "uci") {
-			std::cout << "uciok\n";
+			std::this_thread::sleep_for(config.startup_delay);
+			output.write("id name Dummy engine");
+			output.write("option name Threads type spin default 1 min 1 max 512");
+			output.write("option name Hash type spin default 16 min 1 max 33554432");
+			output.write("option name Clear Hash type button");
+			output.write("option name Ponder type check default false");
+			output.write("option name MultiPV type spin default 1 min 1 max 500");
+			output.write("option name Style type combo default Normal var Solid var Normal var Risky");
+			output.write("option name SyzygyPath type string default <empty>");
+			output.write("uciok");
+			output.flush();
 		}
 		if (command == "isready") {
-			std::cout << "readyok\n";
-		}
-		if (command == "stop") {
-			std::cout << "bestmove e2e4\n";
+			std::this_thread::sleep_for(config.ready_delay);
+			output.write("readyok");
+			output.flush();
 		}
+		const std::string multipv_prefix = "setoption name MultiPV value ";
+		if (command.compare(0, multipv_prefix.size(), multipv_prefix) == 0)
+			multipv_option = static_cast<unsigned>(std::max(1, std::atoi(command.c_str() + multipv_prefix.size())));
+		if (command == "stop" && search)
+			search.reset();
+		if (command == "ponderhit" && search && has_limit)
+			search->finish_by_itself();
 		if (command == "quit")
 			return 0;
 		if (command.substr(0, 2) == "go") {
-			std::cout << "info multipv 1 score cp 30 pv e2e4\n";
+			search.reset();
+			// Searches with limits finish by themselves, infinite searches wait for stop, and
+			// pondering waits for ponderhit or stop
+			bool ponder = command.find(" ponder") != std::string::npos;
+			has_limit = command != "go" && command != "go ponder" && command.find("infinite") == std::string::npos;
+			num_searches += 1;
+			if (num_searches == config.hang_after) {
+				// Never send the best move, and ignore all further commands
+				while (true)
+					std::this_thread::sleep_for(std::chrono::hours(1));
+			}
+			unsigned multipv = config.multipv != 0 ? config.multipv : multipv_option;
+			search = std::make_unique<Search>(config, output, multipv, num_searches, has_limit && !ponder, random);
 		}
-		if (command == "ucinewgame")
-			// Do nothing
-			;
-		if (command == "position startpos")
-			// Do nothing
-			;
-	}
-}
\ No newline at end of file
+		// Other commands, such as ucinewgame and position, are ignored
+	}
+	return 0;
+}
@@ -0,0 +1,101 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Engine_coroutines.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// Minimal coroutine type, which starts right away and isn't awaited.
+struct Detached_task
+{
+	struct promise_type
+	{
+		Detached_task get_return_object()
+		{
+			return {};
+		}
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+		void return_void() {}
+		void unhandled_exception()
+		{
+			std::terminate();
+		}
+	};
+};
+
+const std::string start_position = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+Detached_task analyze_twice(Engine& engine, std::promise<std::vector<size_t>>& result)
+{
+	std::vector<size_t> num_lines;
+	num_lines.push_back((co_await co_analyze(engine, start_position, Search_limits::for_depth(5))).size());
+	num_lines.push_back((co_await co_analyze(engine, "8/8/8/4k3/8/8/6Q1/5R1K w - - 0 20", Search_limits::for_nodes(1000))).size());
+	result.set_value(num_lines);
+}
+
+Detached_task analyze_until_stopped(Engine& engine, std::stop_token stop_token, std::promise<size_t>& result)
+{
+	std::vector<Analyzed_line> lines = co_await co_analyze(engine, start_position, Search_limits::infinite_search(), stop_token);
+	result.set_value(lines.size());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("chess::uci.Engine_coroutines.Await analysis", "[coroutines], [chess], [uci]")
+{
+	Engine engine("./dummy_engine");
+	engine.new_game();
+
+	std::promise<std::vector<size_t>> result;
+	analyze_twice(engine, result);
+	auto future = result.get_future();
+	using namespace std::chrono_literals;
+	REQUIRE((future.wait_for(5s) == std::future_status::ready));
+	CHECK((future.get() == std::vector<size_t>{1, 1}));
+}
+
+TEST_CASE("chess::uci.Engine_coroutines.Cancel analysis", "[coroutines], [chess], [uci]")
+{
+	Engine engine("./dummy_engine");
+	engine.new_game();
+
+	// The coroutine stays suspended until the analysis is cancelled
+	std::stop_source stop_source;
+	std::promise<size_t> result;
+	analyze_until_stopped(engine, stop_source.get_token(), result);
+	auto future = result.get_future();
+	using namespace std::chrono_literals;
+	CHECK((future.wait_for(50ms) == std::future_status::timeout));
+	stop_source.request_stop();
+	REQUIRE((future.wait_for(5s) == std::future_status::ready));
+	CHECK((future.get() == 1));
+
+	// Cancelled before starting
+	std::promise<size_t> cancelled_result;
+	analyze_until_stopped(engine, stop_source.get_token(), cancelled_result);
+	auto cancelled_future = cancelled_result.get_future();
+	REQUIRE((cancelled_future.wait_for(5s) == std::future_status::ready));
+	CHECK((cancelled_future.get() == 0));
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,112 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Engine_metrics.h"
+#include "chess_uci/Engine_pool.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <string>
+
+namespace chess {
+namespace uci {
+
+using namespace std::chrono_literals;
+
+TEST_CASE("chess::uci.Engine_metrics.Histogram", "[chess], [uci]")
+{
+	Latency_histogram histogram;
+	CHECK((histogram.snapshot().count() == 0));
+	CHECK((histogram.snapshot().quantile(0.5) == 0ns));
+
+	histogram.record(0ns);
+	histogram.record(1ns);
+	histogram.record(1000ns);
+	histogram.record(1500ns);
+	histogram.record(1ms);
+	Histogram_snapshot snapshot = histogram.snapshot();
+	CHECK((snapshot.count() == 5));
+	CHECK((snapshot.buckets[0] == 1));
+	CHECK((snapshot.buckets[1] == 1));
+	// 1000 and 1500 ns are both in [512, 1024) and [1024, 2048) respectively
+	CHECK((snapshot.buckets[10] == 1));
+	CHECK((snapshot.buckets[11] == 1));
+	CHECK((snapshot.sum == 1002501ns));
+	CHECK((snapshot.mean() == 200500ns));
+	CHECK((snapshot.quantile(0.5) == 1024ns));
+	CHECK((snapshot.quantile(1.0) == 1048576ns));
+
+	// Durations beyond the last bucket end up in the last bucket
+	histogram.record(std::chrono::hours(100));
+	CHECK((histogram.snapshot().buckets.back() == 1));
+
+	Histogram_snapshot total = snapshot;
+	total += histogram.snapshot();
+	CHECK((total.count() == 11));
+}
+
+TEST_CASE("chess::uci.Engine_metrics.Prometheus format", "[chess], [uci]")
+{
+	Metrics_snapshot metrics;
+	metrics.lines_read = 12;
+	metrics.searches_completed = 2;
+	Latency_histogram histogram;
+	histogram.record(3ns);
+	metrics.search_time = histogram.snapshot();
+
+	std::string text = to_prometheus(metrics, "uci", "pool=\"main\"");
+	CHECK((text.find("# TYPE uci_lines_read_total counter\n") != std::string::npos));
+	CHECK((text.find("uci_lines_read_total{pool=\"main\"} 12\n") != std::string::npos));
+	CHECK((text.find("uci_searches_completed_total{pool=\"main\"} 2\n") != std::string::npos));
+	CHECK((text.find("# TYPE uci_search_time_seconds histogram\n") != std::string::npos));
+	CHECK((text.find("uci_search_time_seconds_bucket{pool=\"main\",le=\"2e-09\"} 0\n") != std::string::npos));
+	CHECK((text.find("uci_search_time_seconds_bucket{pool=\"main\",le=\"4e-09\"} 1\n") != std::string::npos));
+	CHECK((text.find("uci_search_time_seconds_bucket{pool=\"main\",le=\"+Inf\"} 1\n") != std::string::npos));
+	CHECK((text.find("uci_search_time_seconds_count{pool=\"main\"} 1\n") != std::string::npos));
+
+	// Without labels
+	text = to_prometheus(metrics);
+	CHECK((text.find("chess_uci_lines_read_total 12\n") != std::string::npos));
+	CHECK((text.find("chess_uci_search_time_seconds_bucket{le=\"+Inf\"} 1\n") != std::string::npos));
+}
+
+TEST_CASE("chess::uci.Engine_metrics.Dummy engine metrics", "[chess], [uci]")
+{
+	Engine engine("./dummy_engine");
+	Metrics_snapshot metrics = engine.get_metrics();
+	CHECK((metrics.startup_time.count() == 1));
+	CHECK((metrics.ready_latency.count() == 1));
+	CHECK((metrics.lines_read > 2));
+	CHECK((metrics.searches_completed == 0));
+
+	engine.start_calculating(Search_limits::for_depth(5));
+	engine.wait_for_result();
+	engine.start_calculating(Search_limits::infinite_search());
+	engine.stop_calculating();
+	metrics = engine.get_metrics();
+	CHECK((metrics.searches_completed == 2));
+	CHECK((metrics.nodes_searched == 2000));
+	CHECK((metrics.search_time.count() == 2));
+	CHECK((metrics.first_info_latency.count() == 2));
+	CHECK((metrics.parse_time.count() == 2));
+	CHECK((metrics.stop_latency.count() == 1));
+	CHECK((metrics.bytes_read > metrics.lines_read));
+}
+
+TEST_CASE("chess::uci.Engine_metrics.Pool metrics", "[chess], [uci]")
+{
+	Engine_pool pool("./dummy_engine", 2);
+	Analysis_job job;
+	job.fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	job.limits = Search_limits::for_depth(5);
+	for (int i = 0; i < 4; ++i)
+		pool.submit(job).get();
+
+	Metrics_snapshot metrics = pool.get_metrics();
+	CHECK((metrics.startup_time.count() == 2));
+	CHECK((metrics.searches_completed == 4));
+	CHECK((metrics.nodes_searched == 4000));
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,84 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Engine_pool.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+TEST_CASE("chess::uci.Engine_pool.Analyze positions with dummy engines", "[pool], [chess], [uci]")
+{
+	Engine_pool pool("./dummy_engine", 3);
+	REQUIRE(pool.size() == 3);
+
+	// Submit more positions than there are engines, and make sure that all of them are analyzed
+	std::vector<std::future<std::vector<Analyzed_line>>> results;
+	for (int i = 0; i < 10; ++i)
+		results.push_back(pool.submit({"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", std::chrono::seconds(0)}));
+
+	for (auto& result : results) {
+		std::vector<Analyzed_line> lines = result.get();
+		REQUIRE((lines.size() == 1));
+		REQUIRE((lines.front().moves.size() == 1));
+		CHECK((lines.front().moves.front() == "e2e4"));
+		REQUIRE(lines.front().evaluation.centi_pawns.has_value());
+		CHECK((*lines.front().evaluation.centi_pawns == 30));
+	}
+}
+
+TEST_CASE("chess::uci.Engine_pool.Idle engines steal queued tasks", "[pool], [chess], [uci]")
+{
+	Engine_pool pool("./dummy_engine", 2);
+
+	// Occupy one engine with a slow task. Tasks queued behind it should be stolen
+	// and completed by the other engine while the slow task is still running.
+	std::promise<void> release_slow_task;
+	std::shared_future<void> slow_task_released = release_slow_task.get_future().share();
+	std::atomic<int> completed_fast_tasks{0};
+	pool.execute([slow_task_released](Engine&) {
+		slow_task_released.wait();
+	});
+	for (int i = 0; i < 6; ++i)
+		pool.execute([&completed_fast_tasks](Engine&) {
+			completed_fast_tasks += 1;
+		});
+
+	using namespace std::chrono_literals;
+	auto deadline = std::chrono::steady_clock::now() + 5s;
+	while (completed_fast_tasks < 6 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(1ms);
+	CHECK(completed_fast_tasks == 6);
+
+	release_slow_task.set_value();
+}
+
+TEST_CASE("chess::uci.Engine_pool.Replace hung engines", "[pool], [chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	// The engines stop responding in their second search (see Dummy_engine.cpp)
+	::setenv("DUMMY_ENGINE_ARGS", "--hang-after 2", 1);
+	{
+		Engine_pool pool("./dummy_engine", 1);
+		Analysis_job job{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0ms};
+		job.timeout = 200ms;
+		CHECK((pool.submit(job).get().size() == 1));
+		auto hung = pool.submit(job);
+		CHECK_THROWS_AS(hung.get(), std::runtime_error);
+		// The killed engine is replaced, so the pool can go on analyzing
+		CHECK((pool.submit(job).get().size() == 1));
+		CHECK((pool.num_replaced_engines() == 1));
+		CHECK((pool.get_metrics().timeouts == 1));
+	}
+	::unsetenv("DUMMY_ENGINE_ARGS");
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,118 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Engine_reactor.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+Analysis_job depth_job(const std::string& fen, uint16_t depth)
+{
+	Analysis_job job;
+	job.fen = fen;
+	job.new_game = false;
+	job.limits = Search_limits::for_depth(depth);
+	return job;
+}
+
+const std::string start_position = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+} // Anonymous namespace
+
+TEST_CASE("chess::uci.Engine_reactor.Analyze positions with dummy engines", "[reactor], [chess], [uci]")
+{
+	Engine_reactor reactor("./dummy_engine", 4);
+	REQUIRE(reactor.num_engines() == 4);
+
+	// Queue many more positions than there are engines, and make sure that all of them are analyzed
+	int num_completed = 0;
+	int num_failed = 0;
+	for (int i = 0; i < 100; ++i)
+		reactor.analyze(depth_job(start_position, 10), [&](const std::vector<Analyzed_line>& lines, std::exception_ptr error) {
+			if (error || lines.size() != 1 || lines.front().moves != std::vector<std::string>{"e2e4"})
+				num_failed += 1;
+			else
+				num_completed += 1;
+		});
+	CHECK(reactor.num_pending() == 100);
+
+	reactor.run();
+	CHECK(num_completed == 100);
+	CHECK(num_failed == 0);
+	CHECK(reactor.num_pending() == 0);
+	CHECK(reactor.num_engines() == 4);
+}
+
+TEST_CASE("chess::uci.Engine_reactor.Queue positions from callbacks", "[reactor], [chess], [uci]")
+{
+	Engine_reactor reactor("./dummy_engine", 2);
+
+	// Each result queues the analysis of the next position, as when walking through a game
+	int num_completed = 0;
+	Engine::Completion_callback on_completion = [&](const std::vector<Analyzed_line>& lines, std::exception_ptr error) {
+		REQUIRE_FALSE(error);
+		REQUIRE(lines.size() == 1);
+		num_completed += 1;
+		if (num_completed < 10) {
+			Analysis_job job = depth_job(start_position, 5);
+			job.new_game = true;
+			reactor.analyze(job, on_completion);
+		}
+	};
+	reactor.analyze(depth_job(start_position, 5), on_completion);
+	reactor.run();
+	CHECK(num_completed == 10);
+}
+
+TEST_CASE("chess::uci.Engine_reactor.Interleave with other work", "[reactor], [chess], [uci]")
+{
+	Engine_reactor reactor("./dummy_engine", 1);
+	bool completed = false;
+	reactor.analyze(depth_job(start_position, 1), [&](const std::vector<Analyzed_line>&, std::exception_ptr) {
+		completed = true;
+	});
+
+	using namespace std::chrono_literals;
+	auto deadline = std::chrono::steady_clock::now() + 5s;
+	while (!completed && std::chrono::steady_clock::now() < deadline)
+		reactor.run_once(10ms);
+	CHECK(completed);
+}
+
+TEST_CASE("chess::uci.Engine_reactor.Failing engines", "[reactor], [chess], [uci]")
+{
+	// An engine which exits right away fails the positions given to it
+	Engine_reactor reactor("/bin/true", 2);
+	std::vector<std::exception_ptr> errors;
+	for (int i = 0; i < 3; ++i)
+		reactor.analyze(depth_job(start_position, 1), [&](const std::vector<Analyzed_line>& lines, std::exception_ptr error) {
+			CHECK(lines.empty());
+			errors.push_back(error);
+		});
+	reactor.run();
+	CHECK(reactor.num_engines() == 0);
+	REQUIRE(errors.size() == 3);
+	for (const std::exception_ptr& error : errors)
+		CHECK_THROWS_AS(std::rethrow_exception(error), std::runtime_error);
+}
+
+TEST_CASE("chess::uci.Engine_reactor.Positions need limits", "[reactor], [chess], [uci]")
+{
+	Engine_reactor reactor("./dummy_engine", 1);
+	Analysis_job job = depth_job(start_position, 1);
+	job.limits = Search_limits::infinite_search();
+	CHECK_THROWS_AS(reactor.analyze(job, nullptr), std::invalid_argument);
+	CHECK(reactor.num_pending() == 0);
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,146 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Engine_pool.h"
+#include "chess_uci/Engine_server.h"
+
+#include <catch2/catch.hpp>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// Runs a server on a background thread for the duration of a test.
+struct Running_server
+{
+	Running_server(const Engine_endpoint& endpoint)
+		: server("./dummy_engine", endpoint)
+		, thread([this]() {
+			server.run();
+		})
+	{}
+
+	~Running_server()
+	{
+		server.stop();
+		thread.join();
+	}
+
+	Engine_server server;
+	std::thread thread;
+};
+
+/// Wait until the server runs the given number of engines, or give up after a while.
+bool wait_for_num_engines(const Engine_server& server, size_t num_engines)
+{
+	using namespace std::chrono_literals;
+	auto deadline = std::chrono::steady_clock::now() + 5s;
+	while (server.num_engines() != num_engines && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(10ms);
+	return server.num_engines() == num_engines;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("chess::uci.Engine_endpoint.Parse endpoints", "[server], [chess], [uci]")
+{
+	CHECK((Engine_endpoint::parse("./dummy_engine") == Engine_endpoint("./dummy_engine")));
+	CHECK((Engine_endpoint::parse("unix:/tmp/engine.sock") == Engine_endpoint::unix_socket("/tmp/engine.sock")));
+	CHECK((Engine_endpoint::parse("tcp:localhost:4000") == Engine_endpoint::tcp("localhost", 4000)));
+	CHECK((Engine_endpoint::parse("tcp:[::1]:4000") == Engine_endpoint::tcp("::1", 4000)));
+	for (const char* text : {"./dummy_engine", "unix:/tmp/engine.sock", "tcp:127.0.0.1:0", "tcp:[::1]:4000"})
+		CHECK((to_string(Engine_endpoint::parse(text)) == text));
+
+	CHECK_THROWS_AS(Engine_endpoint::parse("unix:"), std::invalid_argument);
+	CHECK_THROWS_AS(Engine_endpoint::parse("tcp:localhost"), std::invalid_argument);
+	CHECK_THROWS_AS(Engine_endpoint::parse("tcp:localhost:65536"), std::invalid_argument);
+	CHECK_THROWS_AS(Engine_endpoint::parse("tcp:localhost:port"), std::invalid_argument);
+}
+
+TEST_CASE("chess::uci.Engine_server.Analyze over TCP", "[server], [chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Running_server running(Engine_endpoint::tcp("127.0.0.1", 0));
+	const Engine_endpoint& address = running.server.address();
+	REQUIRE((address.kind == Engine_endpoint::Kind::tcp));
+	CHECK((address.port != 0));
+
+	{
+		Engine engine(address, 2);
+		CHECK((running.server.num_engines() == 1));
+		engine.reset_game();
+		engine.start_calculating(Search_limits::for_depth(10));
+		CHECK((engine.wait_for_result(std::chrono::steady_clock::now() + 5s) == Engine::Wait_status::finished));
+		auto lines = engine.get_top_suggested_move_sequences();
+		REQUIRE((lines.size() == 2));
+		REQUIRE(!lines.front().moves.empty());
+		CHECK((lines.front().moves.front() == "e2e4"));
+		CHECK(!engine.get_options().empty());
+	}
+	// The engine exits when the connection is closed
+	CHECK(wait_for_num_engines(running.server, 0));
+}
+
+TEST_CASE("chess::uci.Engine_server.Pool over a Unix domain socket", "[server], [chess], [uci]")
+{
+	std::string socket_path = "engine_server_test_" + std::to_string(::getpid()) + ".sock";
+	{
+		Running_server running(Engine_endpoint::unix_socket(socket_path));
+		CHECK((to_string(running.server.address()) == "unix:" + socket_path));
+
+		Engine_pool pool(Engine_endpoint::parse("unix:" + socket_path), 3);
+		CHECK((running.server.num_engines() == 3));
+		std::vector<std::future<std::vector<Analyzed_line>>> results;
+		for (int i = 0; i < 10; ++i)
+			results.push_back(pool.submit({"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", std::chrono::seconds(0)}));
+		for (auto& result : results) {
+			std::vector<Analyzed_line> lines = result.get();
+			REQUIRE((lines.size() == 1));
+			REQUIRE((lines.front().moves.size() == 1));
+			CHECK((lines.front().moves.front() == "e2e4"));
+		}
+	}
+	// The socket file is removed with the server
+	CHECK((::access(socket_path.c_str(), F_OK) != 0));
+}
+
+TEST_CASE("chess::uci.Engine_server.Remote engine hangs", "[server], [chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	// The served engines inherit the environment of the test, see Dummy_engine.cpp
+	::setenv("DUMMY_ENGINE_ARGS", "--hang-after 2", 1);
+	{
+		Running_server running(Engine_endpoint::tcp("127.0.0.1", 0));
+		Engine engine(running.server.address());
+		engine.start_calculating(Search_limits::for_depth(10));
+		CHECK((engine.wait_for_result(std::chrono::steady_clock::now() + 5s) == Engine::Wait_status::finished));
+
+		// Killing the engine cuts the connection, which wakes up the waiting reader
+		engine.start_calculating(Search_limits::for_depth(10));
+		auto deadline = std::chrono::steady_clock::now() + 200ms;
+		CHECK((engine.wait_for_result(deadline) == Engine::Wait_status::timed_out));
+		CHECK((std::chrono::steady_clock::now() < deadline + 100ms));
+		CHECK(engine.was_killed());
+		CHECK_THROWS_AS(engine.wait_until_ready(), std::runtime_error);
+	}
+	::unsetenv("DUMMY_ENGINE_ARGS");
+}
+
+TEST_CASE("chess::uci.Engine_server.Nothing to connect to", "[server], [chess], [uci]")
+{
+	std::string socket_path = "engine_server_test_missing_" + std::to_string(::getpid()) + ".sock";
+	CHECK_THROWS_AS(Engine(Engine_endpoint::unix_socket(socket_path)), std::runtime_error);
+	CHECK_THROWS_AS(Engine_server("./dummy_engine", Engine_endpoint("./dummy_engine")), std::invalid_argument);
+}
+
+} // namespace uci
+} // namespace chess
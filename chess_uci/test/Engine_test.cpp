@@ -4,12 +4,36 @@
 
 #include <catch2/catch.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <future>
+#include <optional>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
 namespace chess {
 namespace uci {
 
+namespace {
+
+/// Configures the dummy engines started while the object exists (see Dummy_engine.cpp).
+struct Dummy_engine_arguments
+{
+	explicit Dummy_engine_arguments(const char* arguments)
+	{
+		setenv("DUMMY_ENGINE_ARGS", arguments, 1);
+	}
+
+	~Dummy_engine_arguments()
+	{
+		unsetenv("DUMMY_ENGINE_ARGS");
+	}
+};
+
+} // Anonymous namespace
+
 TEST_CASE("chess::uci.Engine.Dummy engine", "[chess], [uci]")
 {
 	// Create an instance of the interface running the dummy engine, and make
@@ -32,6 +56,398 @@ TEST_CASE("chess::uci.Engine.Dummy engine", "[chess], [uci]")
 	CHECK((*lines.front().evaluation.centi_pawns == 30));
 }
 
+TEST_CASE("chess::uci.Engine.Dummy engine info callback", "[chess], [uci]")
+{
+	// Make sure that info messages are passed to the callback while the engine calculates
+	Engine engine("./dummy_engine");
+	std::promise<Info> first_info;
+	bool info_received = false;
+	engine.set_info_callback([&](const Info& info) {
+		if (!info_received)
+			first_info.set_value(info);
+		info_received = true;
+	});
+
+	engine.reset_game();
+	engine.start_calculating();
+
+	auto info_future = first_info.get_future();
+	using namespace std::chrono_literals;
+	REQUIRE((info_future.wait_for(5s) == std::future_status::ready));
+	Info info = info_future.get();
+	REQUIRE(info.evaluation.has_value());
+	REQUIRE(info.evaluation->centi_pawns.has_value());
+	CHECK((*info.evaluation->centi_pawns == 30));
+
+	engine.stop_calculating();
+	const auto& lines = engine.get_top_suggested_move_sequences();
+	REQUIRE((lines.size() == 1));
+	CHECK((lines.front().moves == std::vector<std::string>{"e2e4"}));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine positions within a game", "[chess], [uci]")
+{
+	// Walk through a game without starting a new game for each position
+	Engine engine("./dummy_engine");
+	engine.new_game();
+
+	engine.set_position_from_moves("e2e4");
+	engine.start_calculating();
+	engine.stop_calculating();
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+
+	// Changing the position invalidates the previous results
+	engine.play_moves("e7e5 g1f3");
+	CHECK(engine.get_top_suggested_move_sequences().empty());
+	engine.start_calculating();
+	engine.stop_calculating();
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+
+	engine.set_position_from_fen("8/8/8/4k3/8/8/6Q1/5R1K w - - 0 20", "g2g5");
+	engine.start_calculating();
+	engine.stop_calculating();
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine wait for result", "[chess], [uci]")
+{
+	// The dummy engine finishes right away when given a limit, so waiting for the result should return immediately
+	Engine engine("./dummy_engine");
+	engine.reset_game();
+
+	engine.start_calculating(Search_limits::for_depth(10));
+	const auto& lines = engine.wait_for_result();
+	REQUIRE((lines.size() == 1));
+	CHECK((lines.front().moves == std::vector<std::string>{"e2e4"}));
+	CHECK((&lines == &engine.get_top_suggested_move_sequences()));
+
+	// Waiting again, or stopping, after the engine has finished does nothing
+	engine.wait_for_result();
+	engine.stop_calculating();
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+
+	// The engine must still be in sync after a stop command it didn't need
+	engine.play_moves("e2e4");
+	using namespace std::chrono_literals;
+	engine.start_calculating(Search_limits::for_move_time(500us));
+	CHECK((engine.wait_for_result().size() == 1));
+
+	// Can't wait for a calculation which never ends
+	engine.start_calculating();
+	CHECK_THROWS_AS(engine.wait_for_result(), std::logic_error);
+	engine.stop_calculating();
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+}
+
+TEST_CASE("chess::uci.Engine.Stockfish wait for depth", "[chess], [uci]")
+{
+	// Waiting for a depth limited search should return as soon as the engine is done
+	Engine engine("/usr/games/stockfish");
+	engine.setup_game_from_fen("8/8/8/4k3/8/8/6Q1/5R1K w - - 0 20");
+
+	engine.start_calculating(Search_limits::for_depth(12));
+	const auto& lines = engine.wait_for_result();
+	REQUIRE((lines.size() == 1));
+	REQUIRE(engine.get_evaluation().white_can_mate_in.has_value());
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine asynchronous analysis", "[chess], [uci]")
+{
+	Engine engine("./dummy_engine");
+	engine.new_game();
+
+	// Analysis with a limit completes by itself
+	auto result = engine.analyze("8/8/8/4k3/8/8/6Q1/5R1K w - - 0 20", Search_limits::for_depth(10));
+	std::vector<Analyzed_line> lines = result.get();
+	REQUIRE((lines.size() == 1));
+	CHECK((lines.front().moves == std::vector<std::string>{"e2e4"}));
+
+	// Analysis without a limit completes when stopped, which can be done from another thread
+	result = engine.analyze("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", Search_limits::infinite_search());
+	using namespace std::chrono_literals;
+	CHECK((result.wait_for(50ms) == std::future_status::timeout));
+	std::thread([&engine]() {
+		engine.request_stop();
+	}).join();
+	REQUIRE((result.wait_for(5s) == std::future_status::ready));
+	CHECK((result.get().size() == 1));
+
+	// The results are also available from the engine once the calculation has been finished
+	engine.stop_calculating();
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine completion callback", "[chess], [uci]")
+{
+	// The completion callback may start the next calculation
+	Engine engine("./dummy_engine");
+	engine.new_game();
+	std::promise<size_t> second_result;
+	std::promise<void> first_started;
+	auto first_started_future = first_started.get_future();
+	engine.start_calculating(Search_limits::infinite_search(), [&](const std::vector<Analyzed_line>&, std::exception_ptr) {
+		first_started_future.wait();
+		engine.start_calculating(Search_limits::for_depth(1), [&](const std::vector<Analyzed_line>& lines, std::exception_ptr) {
+			second_result.set_value(lines.size());
+		});
+	});
+	first_started.set_value();
+	engine.request_stop();
+
+	auto second_future = second_result.get_future();
+	using namespace std::chrono_literals;
+	REQUIRE((second_future.wait_for(5s) == std::future_status::ready));
+	CHECK((second_future.get() == 1));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine pondering", "[chess], [uci]")
+{
+	Engine engine("./dummy_engine");
+	engine.reset_game();
+	CHECK_FALSE(engine.get_best_move().has_value());
+
+	engine.start_calculating(Search_limits::for_depth(5));
+	engine.wait_for_result();
+	REQUIRE(engine.get_best_move().has_value());
+	CHECK((engine.get_best_move()->move == "e2e4"));
+	CHECK((engine.get_best_move()->ponder == std::optional<std::string>("e7e5")));
+
+	// Play the best move and ponder on the expected reply. The engine doesn't finish while pondering.
+	engine.start_pondering(Search_limits::for_depth(5));
+	CHECK(engine.is_pondering());
+	CHECK_THROWS_AS(engine.wait_for_result(), std::logic_error);
+
+	// The opponent plays the expected move, so the engine carries on and then finishes by itself
+	engine.opponent_moved("e7e5");
+	CHECK_FALSE(engine.is_pondering());
+	CHECK((engine.wait_for_result().size() == 1));
+	CHECK((engine.get_ponder_statistics().hits == 1));
+	CHECK((engine.get_ponder_statistics().misses == 0));
+
+	// The opponent plays another move, so the engine starts over
+	engine.start_pondering("b8c6", Search_limits::for_depth(5));
+	engine.opponent_moved("g8f6");
+	CHECK_FALSE(engine.is_pondering());
+	CHECK((engine.wait_for_result().size() == 1));
+	CHECK((engine.get_ponder_statistics().hits == 1));
+	CHECK((engine.get_ponder_statistics().misses == 1));
+	CHECK((engine.get_ponder_statistics().hit_rate() == Approx(0.5)));
+
+	// Stopping ends pondering
+	engine.start_pondering("a7a6", Search_limits::for_depth(5));
+	engine.stop_calculating();
+	CHECK_FALSE(engine.is_pondering());
+	CHECK_THROWS_AS(engine.opponent_moved("a7a6"), std::logic_error);
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine options", "[chess], [uci]")
+{
+	Engine engine("./dummy_engine");
+	CHECK((engine.get_options().size() == 7));
+
+	const Engine_option* threads = engine.find_option("threads");
+	REQUIRE(threads != nullptr);
+	CHECK((threads->name == "Threads"));
+	CHECK((threads->type == Engine_option::Type::spin));
+	CHECK((threads->min == int64_t(1)));
+	CHECK((threads->max == int64_t(512)));
+	CHECK((engine.find_option("Contempt") == nullptr));
+
+	engine.set_threads(4);
+	engine.set_hash_size(256);
+	engine.set_option("Clear Hash");
+	engine.set_option("ponder", "true");
+	engine.set_option("Style", "risky");
+	engine.set_option("SyzygyPath", "/tmp/syzygy");
+	CHECK_THROWS_AS(engine.set_threads(0), std::invalid_argument);
+	CHECK_THROWS_AS(engine.set_threads(1000), std::invalid_argument);
+	CHECK_THROWS_AS(engine.set_option("Ponder", "yes"), std::invalid_argument);
+	CHECK_THROWS_AS(engine.set_option("Style", "Reckless"), std::invalid_argument);
+	CHECK_THROWS_AS(engine.set_option("MultiPV", "two"), std::invalid_argument);
+	CHECK_THROWS_AS(engine.set_option("Contempt", "20"), std::invalid_argument);
+
+	// The engine is still usable after the options are sent
+	engine.reset_game();
+	engine.start_calculating(Search_limits::for_depth(5));
+	CHECK((engine.wait_for_result().size() == 1));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine under load", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Dummy_engine_arguments arguments("--info-rate 20000 --pv-length 20 --garbage-rate 0.1 --startup-delay 50 --ready-delay 10");
+	Engine engine("./dummy_engine", 3);
+	CHECK((engine.get_metrics().startup_time.sum >= 60ms));
+
+	std::atomic<size_t> num_infos{0};
+	engine.set_info_callback([&num_infos](const Info&) {
+		++num_infos;
+	});
+	engine.start_calculating(Search_limits::infinite_search());
+	std::this_thread::sleep_for(200ms);
+	engine.stop_calculating();
+	// Lines are sent in bursts, so allow for some slack
+	CHECK((num_infos > 1000));
+	const auto& lines = engine.get_top_suggested_move_sequences();
+	REQUIRE((lines.size() == 3));
+	for (const auto& line : lines)
+		CHECK((line.moves.size() == 20));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine search time", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Dummy_engine_arguments arguments("--search-time 100");
+	Engine engine("./dummy_engine");
+	auto start = std::chrono::steady_clock::now();
+	engine.start_calculating(Search_limits::for_depth(10));
+	CHECK((engine.wait_for_result().size() == 1));
+	CHECK((std::chrono::steady_clock::now() - start >= 100ms));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engines start in parallel", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Dummy_engine_arguments arguments("--startup-delay 200");
+	auto start = std::chrono::steady_clock::now();
+	auto engines = Engine::start_engines("./dummy_engine", 8);
+	// Starting the engines one at a time would take at least 8 * 200 ms
+	CHECK((std::chrono::steady_clock::now() - start < 1000ms));
+	REQUIRE((engines.size() == 8));
+	for (auto& engine : engines)
+		CHECK((engine->get_metrics().startup_time.sum >= 200ms));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine crash", "[chess], [uci]")
+{
+	Dummy_engine_arguments arguments("--crash-after 2");
+	Engine engine("./dummy_engine");
+	engine.start_calculating(Search_limits::for_depth(10));
+	CHECK((engine.wait_for_result().size() == 1));
+	// The engine exits in the middle of the second search
+	engine.start_calculating(Search_limits::for_depth(10));
+	CHECK_THROWS_AS(engine.wait_for_result(), std::runtime_error);
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine live snapshot", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Dummy_engine_arguments arguments("--info-rate 2000 --multipv 3 --pv-length 5");
+	Engine engine("./dummy_engine", 3);
+	CHECK((engine.get_live_snapshot().calculation == 0));
+
+	// Poll the progress from another thread while the engine calculates
+	engine.start_calculating();
+	Live_snapshot snapshot;
+	std::thread poller([&engine, &snapshot]() {
+		auto deadline = std::chrono::steady_clock::now() + 5s;
+		do
+			snapshot = engine.get_live_snapshot();
+		while (snapshot.num_updates < 20 && std::chrono::steady_clock::now() < deadline);
+	});
+	poller.join();
+	CHECK((snapshot.calculation == 1));
+	CHECK(snapshot.is_calculating);
+	CHECK((snapshot.num_updates >= 20));
+	CHECK((snapshot.nodes > 0));
+	auto lines = snapshot.to_analyzed_lines();
+	REQUIRE((lines.size() == 3));
+	CHECK((lines.front().moves.size() == 5));
+
+	// Once the calculation has finished the snapshot holds the final result
+	engine.stop_calculating();
+	snapshot = engine.get_live_snapshot();
+	CHECK(!snapshot.is_calculating);
+	lines = snapshot.to_analyzed_lines();
+	const auto& final_lines = engine.get_top_suggested_move_sequences();
+	REQUIRE((lines.size() == final_lines.size()));
+	for (size_t i = 0; i < lines.size(); ++i) {
+		CHECK((lines[i].moves == final_lines[i].moves));
+		CHECK((Packed_evaluation(lines[i].evaluation) == Packed_evaluation(final_lines[i].evaluation)));
+	}
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine stops early once converged", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	// The dummy engine keeps the same best move, with scores that vary less than the allowed change
+	Dummy_engine_arguments arguments("--info-rate 1000");
+	Engine engine("./dummy_engine");
+
+	engine.start_calculating(Search_limits::for_move_time(200ms));
+	CHECK((engine.wait_for_result(std::chrono::steady_clock::now() + 5s) == Engine::Wait_status::finished));
+	CHECK(!engine.stopped_early());
+
+	engine.set_convergence_policy(Convergence_policy{5, 3, 1000});
+	// Without the policy the engine would calculate until told to stop
+	engine.start_calculating();
+	CHECK((engine.wait_for_result(std::chrono::steady_clock::now() + 5s) == Engine::Wait_status::finished));
+	CHECK(engine.stopped_early());
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+	CHECK(engine.get_live_snapshot().stopped_early);
+	CHECK((engine.get_metrics().searches_stopped_early == 1));
+
+	// Changing the position forgets about the last calculation
+	engine.set_position_from_moves("e2e4");
+	CHECK(!engine.stopped_early());
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine deadlines", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Dummy_engine_arguments arguments("--search-time 100");
+	Engine engine("./dummy_engine");
+
+	// A search which finishes before the deadline
+	engine.start_calculating(Search_limits::for_depth(10));
+	CHECK((engine.wait_for_result(std::chrono::steady_clock::now() + 5s) == Engine::Wait_status::finished));
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+
+	// A search without limits is stopped in time to get its best move by the deadline
+	engine.start_calculating();
+	auto deadline = std::chrono::steady_clock::now() + 200ms;
+	CHECK((engine.wait_for_result(deadline) == Engine::Wait_status::stopped));
+	CHECK((std::chrono::steady_clock::now() < deadline + 100ms));
+	CHECK((engine.get_top_suggested_move_sequences().size() == 1));
+	CHECK(engine.wait_until_ready(std::chrono::steady_clock::now() + 5s));
+	CHECK(!engine.was_killed());
+	CHECK((engine.get_metrics().timeouts == 0));
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine hangs", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Dummy_engine_arguments arguments("--hang-after 2");
+	Engine engine("./dummy_engine");
+	engine.start_calculating(Search_limits::for_depth(10));
+	CHECK((engine.wait_for_result(std::chrono::steady_clock::now() + 5s) == Engine::Wait_status::finished));
+
+	// The engine doesn't even reply to stop, so it's killed at the deadline
+	engine.start_calculating(Search_limits::for_depth(10));
+	auto deadline = std::chrono::steady_clock::now() + 200ms;
+	CHECK((engine.wait_for_result(deadline) == Engine::Wait_status::timed_out));
+	CHECK((std::chrono::steady_clock::now() < deadline + 100ms));
+	CHECK(engine.was_killed());
+	CHECK(engine.get_top_suggested_move_sequences().empty());
+	CHECK((engine.get_metrics().timeouts == 1));
+	CHECK_THROWS_AS(engine.start_calculating(Search_limits::for_depth(10)), std::runtime_error);
+	CHECK_THROWS_AS(engine.wait_until_ready(), std::runtime_error);
+}
+
+TEST_CASE("chess::uci.Engine.Dummy engine not ready in time", "[chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Dummy_engine_arguments arguments("--ready-delay 500");
+	auto start = std::chrono::steady_clock::now();
+	CHECK_THROWS_AS(Engine("./dummy_engine", 1, std::nullopt, 100ms), std::runtime_error);
+	CHECK((std::chrono::steady_clock::now() - start < 400ms));
+
+	Engine engine("./dummy_engine");
+	CHECK(!engine.wait_until_ready(std::chrono::steady_clock::now() + 100ms));
+	CHECK(engine.was_killed());
+	CHECK((engine.get_metrics().timeouts == 1));
+}
+
 TEST_CASE("chess::uci.Engine.Stockfish basic", "[chess], [uci]")
 {
 	// Create an instance of the interface running Stockfish, and make
@@ -92,5 +508,28 @@ TEST_CASE("chess::uci.Engine.Stockfish number of moves to mate", "[chess], [uci]
 	REQUIRE(best_line.moves.size() == 9);
 }
 
+TEST_CASE("chess::uci.Engine.Stockfish positions within a game", "[chess], [uci]")
+{
+	// Walk forward through a mating sequence without starting a new game. The engine
+	// should keep finding the mate as the position changes.
+	Engine engine("/usr/games/stockfish");
+	engine.setup_game_from_fen("8/8/8/4k3/8/8/6Q1/5R1K w - - 0 20");
+
+	using namespace std::chrono_literals;
+	engine.start_calculating(1s);
+	std::this_thread::sleep_for(1s);
+	engine.stop_calculating();
+	REQUIRE(engine.get_evaluation().white_can_mate_in.has_value());
+
+	const Analyzed_line& best_line = engine.get_top_suggested_move_sequences()[0];
+	REQUIRE(best_line.moves.size() >= 3);
+	engine.play_moves(best_line.moves[0] + " " + best_line.moves[1]);
+	engine.start_calculating(1s);
+	std::this_thread::sleep_for(1s);
+	engine.stop_calculating();
+	REQUIRE(engine.get_evaluation().white_can_mate_in.has_value());
+	CHECK(*engine.get_evaluation().white_can_mate_in <= 4);
+}
+
 } // namespace uci
 } // namespace chess
@@ -0,0 +1,49 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Engine_tuning.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+
+namespace chess {
+namespace uci {
+
+TEST_CASE("chess::uci.Engine_tuning.Candidate splits", "[chess], [uci]")
+{
+	auto splits = candidate_splits(6);
+	REQUIRE((splits.size() == 4));
+	CHECK((splits[0].num_engines == 1));
+	CHECK((splits[0].threads_per_engine == 6));
+	CHECK((splits[1].num_engines == 2));
+	CHECK((splits[1].threads_per_engine == 3));
+	CHECK((splits[2].num_engines == 3));
+	CHECK((splits[2].threads_per_engine == 2));
+	CHECK((splits[3].num_engines == 6));
+	CHECK((splits[3].threads_per_engine == 1));
+
+	splits = candidate_splits(1);
+	REQUIRE((splits.size() == 1));
+	CHECK((splits[0].num_engines == 1));
+	CHECK((splits[0].threads_per_engine == 1));
+}
+
+TEST_CASE("chess::uci.Engine_tuning.Dummy engine tuning", "[chess], [uci]")
+{
+	// The dummy engine finishes right away, so the throughput of the splits is just noise, but
+	// the best split should be the measured split with the highest throughput
+	auto result = tune_thread_split("./dummy_engine", 4, std::chrono::milliseconds(50));
+	REQUIRE((result.measurements.size() == 3));
+	double best_nodes_per_second = 0;
+	for (const auto& measurement : result.measurements) {
+		CHECK((measurement.nodes_per_second > 0));
+		CHECK((measurement.split.num_engines * measurement.split.threads_per_engine == 4));
+		if (measurement.split.num_engines == result.best.num_engines)
+			best_nodes_per_second = measurement.nodes_per_second;
+	}
+	for (const auto& measurement : result.measurements)
+		CHECK((measurement.nodes_per_second <= best_nodes_per_second));
+}
+
+} // namespace uci
+} // namespace chess
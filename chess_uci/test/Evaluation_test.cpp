@@ -4,6 +4,9 @@
 
 #include <catch2/catch.hpp>
 
+#include <string>
+#include <vector>
+
 namespace chess {
 namespace uci {
 
@@ -19,6 +22,8 @@ TEST_CASE("chess::uci::Evaluation.Evaluation to string", "[evaluation], [chess],
 		CHECK(to_string(evaluation) == "+0.08");
 		evaluation.centi_pawns = -131;
 		CHECK(to_string(evaluation) == "-1.31");
+		evaluation.centi_pawns = -5;
+		CHECK(to_string(evaluation) == "-0.05");
 		evaluation.centi_pawns = 0;
 		CHECK(to_string(evaluation) == "0.00");
 	}
@@ -48,5 +53,72 @@ TEST_CASE("chess::uci::Evaluation.Evaluation to string", "[evaluation], [chess],
 	}
 }
 
+TEST_CASE("chess::uci::Evaluation.Packed evaluation conversion", "[evaluation], [chess], [uci]")
+{
+	std::vector<Evaluation> evaluations(6);
+	evaluations[0].centi_pawns = -32768;
+	evaluations[1].centi_pawns = 32767;
+	evaluations[2].centi_pawns_lower_bound = -12;
+	evaluations[3].centi_pawns_upper_bound = 47;
+	evaluations[4].white_can_mate_in = 1;
+	evaluations[5].black_can_mate_in = 255;
+
+	// Packing is lossless
+	for (const Evaluation& evaluation : evaluations) {
+		Evaluation unpacked = Packed_evaluation(evaluation).to_evaluation();
+		CHECK(unpacked.centi_pawns == evaluation.centi_pawns);
+		CHECK(unpacked.centi_pawns_lower_bound == evaluation.centi_pawns_lower_bound);
+		CHECK(unpacked.centi_pawns_upper_bound == evaluation.centi_pawns_upper_bound);
+		CHECK(unpacked.white_can_mate_in == evaluation.white_can_mate_in);
+		CHECK(unpacked.black_can_mate_in == evaluation.black_can_mate_in);
+	}
+	CHECK(Packed_evaluation(Evaluation()).kind() == Packed_evaluation::Kind::none);
+
+	// Formatting into a buffer gives the same result as to_string
+	for (const Evaluation& evaluation : evaluations) {
+		char buffer[max_evaluation_string_length];
+		auto result = to_chars(buffer, buffer + sizeof(buffer), Packed_evaluation(evaluation));
+		REQUIRE(result.ec == std::errc());
+		CHECK(std::string(buffer, result.ptr) == to_string(evaluation));
+	}
+	char small_buffer[3];
+	CHECK(to_chars(small_buffer, small_buffer + sizeof(small_buffer), Packed_evaluation(evaluations[4])).ec == std::errc::value_too_large);
+}
+
+TEST_CASE("chess::uci::Evaluation.Packed evaluation ordering", "[evaluation], [chess], [uci]")
+{
+	auto centi_pawns = [](int16_t cp) {
+		Evaluation evaluation;
+		evaluation.centi_pawns = cp;
+		return Packed_evaluation(evaluation);
+	};
+	auto white_mate = [](uint8_t moves) {
+		Evaluation evaluation;
+		evaluation.white_can_mate_in = moves;
+		return Packed_evaluation(evaluation);
+	};
+	auto black_mate = [](uint8_t moves) {
+		Evaluation evaluation;
+		evaluation.black_can_mate_in = moves;
+		return Packed_evaluation(evaluation);
+	};
+	Evaluation lower_bound;
+	lower_bound.centi_pawns_lower_bound = 10;
+	Evaluation upper_bound;
+	upper_bound.centi_pawns_upper_bound = 10;
+
+	CHECK(black_mate(1) < black_mate(2));
+	CHECK(black_mate(200) < centi_pawns(-32768));
+	CHECK(centi_pawns(-20) < centi_pawns(-3));
+	CHECK(centi_pawns(-3) < centi_pawns(4));
+	CHECK(Packed_evaluation(upper_bound) < centi_pawns(10));
+	CHECK(centi_pawns(10) < Packed_evaluation(lower_bound));
+	CHECK(Packed_evaluation(lower_bound) < centi_pawns(11));
+	CHECK(centi_pawns(32767) < white_mate(30));
+	CHECK(white_mate(30) < white_mate(2));
+	CHECK(white_mate(2) == white_mate(2));
+	CHECK(Packed_evaluation() < black_mate(1));
+}
+
 } // namespace uci
 } // namespace chess
@@ -0,0 +1,61 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Game_analysis.h"
+
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+const std::vector<std::string> game_moves = {
+	"e2e4", "c7c5", "g1f3", "e7e6", "c2c4", "b8c6", "d2d4", "c5d4", "f3d4", "f8c5"};
+
+void check_analysis(const std::vector<Ply_analysis>& analysis)
+{
+	REQUIRE((analysis.size() == game_moves.size() + 1));
+	for (size_t ply = 0; ply < analysis.size(); ++ply) {
+		CHECK((analysis[ply].ply == ply));
+		REQUIRE((analysis[ply].lines.size() == 1));
+		CHECK((analysis[ply].lines.front().moves == std::vector<std::string>{"e2e4"}));
+		REQUIRE(analysis[ply].evaluation.centi_pawns.has_value());
+		CHECK((*analysis[ply].evaluation.centi_pawns == 30));
+		REQUIRE(analysis[ply].best_move.has_value());
+		CHECK((analysis[ply].best_move->move == "e2e4"));
+	}
+}
+
+} // Anonymous namespace
+
+TEST_CASE("chess::uci.Game_analysis.Analyze game on one engine", "[game], [chess], [uci]")
+{
+	Engine engine("./dummy_engine");
+	auto analysis = analyze_game(engine, game_moves, Search_limits::for_depth(10));
+	check_analysis(analysis);
+
+	// The engine is only asked whether it's ready at startup and when the game starts, not for each position
+	Metrics_snapshot metrics = engine.get_metrics();
+	CHECK((metrics.ready_latency.count() == 2));
+	CHECK((metrics.searches_completed == game_moves.size() + 1));
+
+	CHECK_THROWS_AS(analyze_game(engine, game_moves, Search_limits::infinite_search()), std::invalid_argument);
+	CHECK((analyze_game(engine, {}, Search_limits::for_depth(10)).size() == 1));
+}
+
+TEST_CASE("chess::uci.Game_analysis.Analyze game on a pool", "[game], [chess], [uci]")
+{
+	Engine_pool pool("./dummy_engine", 3);
+	auto analysis = analyze_game(pool, game_moves, Search_limits::for_depth(10), "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	check_analysis(analysis);
+	// Each engine analyzes its own stretch of the game
+	CHECK((pool.get_metrics().searches_completed == game_moves.size() + 1));
+	CHECK((pool.get_metrics().ready_latency.count() == 2 * pool.size()));
+}
+
+} // namespace uci
+} // namespace chess
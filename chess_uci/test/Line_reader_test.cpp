@@ -0,0 +1,173 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Line_reader.h"
+#include "chess_uci/Read_messages.h"
+
+#include <catch2/catch.hpp>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+namespace {
+
+/// Pipe whose ends are closed when it goes out of scope.
+struct Test_pipe
+{
+	Test_pipe()
+	{
+		REQUIRE(::pipe(fds) == 0);
+	}
+	~Test_pipe()
+	{
+		close_write_end();
+		::close(fds[0]);
+	}
+	void write(const std::string& data)
+	{
+		REQUIRE(::write(fds[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+	}
+	void close_write_end()
+	{
+		if (fds[1] != -1)
+			::close(fds[1]);
+		fds[1] = -1;
+	}
+
+	int fds[2];
+};
+
+} // Anonymous namespace
+
+TEST_CASE("chess::uci::Line_reader.Split buffer into lines", "[communication], [chess], [uci]")
+{
+	Line_buffer buffer(8);
+
+	// Write a line in two parts, and make sure that it's only handed out once complete
+	std::string part = "info ";
+	std::copy(part.begin(), part.end(), buffer.prepare());
+	buffer.commit(part.size());
+	CHECK(!buffer.next_line().has_value());
+	part = "pv\nbest";
+	REQUIRE(buffer.writable_size() >= 3);
+	std::copy(part.begin(), part.begin() + 3, buffer.prepare());
+	buffer.commit(3);
+	// The buffer is full, so the next line is moved to the start of the buffer
+	auto line = buffer.next_line();
+	REQUIRE(line.has_value());
+	CHECK(*line == "info pv");
+	std::string rest = "best";
+	char* destination = buffer.prepare();
+	REQUIRE(buffer.writable_size() >= rest.size());
+	std::copy(rest.begin(), rest.end(), destination);
+	buffer.commit(rest.size());
+	CHECK(!buffer.next_line().has_value());
+	CHECK(buffer.take_remaining() == "best");
+}
+
+TEST_CASE("chess::uci::Line_reader.Read lines from pipe", "[communication], [chess], [uci]")
+{
+	Test_pipe pipe;
+	// Use a small buffer, to make sure that lines longer than the buffer are handled
+	Line_reader reader(pipe.fds[0], 4);
+
+	pipe.write("id name Fake engine\nuci");
+	pipe.write("ok\n");
+	auto line = reader.read_line();
+	REQUIRE(line.has_value());
+	CHECK(*line == "id name Fake engine");
+	line = reader.read_line();
+	REQUIRE(line.has_value());
+	CHECK(*line == "uciok");
+
+	// Lines arriving later are waited for
+	std::thread writer([&pipe]() {
+		pipe.write("readyok\nunterminated");
+		pipe.close_write_end();
+	});
+	line = reader.read_line();
+	REQUIRE(line.has_value());
+	CHECK(*line == "readyok");
+	line = reader.read_line();
+	REQUIRE(line.has_value());
+	CHECK(*line == "unterminated");
+	CHECK(!reader.read_line().has_value());
+	writer.join();
+}
+
+TEST_CASE("chess::uci::Line_reader.Read engine replies from pipe", "[communication], [chess], [uci]")
+{
+	Test_pipe pipe;
+	Line_reader reader(pipe.fds[0]);
+
+	pipe.write("id name Fake engine\nid author Santa\nuciok\n");
+	std::vector<std::string> messages = read_uci_replies(reader);
+	REQUIRE(messages.size() == 3);
+	CHECK(messages[0] == "id name Fake engine");
+	CHECK(messages[1] == "id author Santa");
+	CHECK(messages[2] == "uciok");
+
+	pipe.write("info score cp 20 pv e2e4\nbestmove e2e4\n");
+	std::vector<std::string> info_messages;
+	std::string bestmove = read_go_replies(reader, [&info_messages](std::string_view message) {
+		info_messages.emplace_back(message);
+	});
+	REQUIRE(info_messages.size() == 1);
+	CHECK(info_messages[0] == "info score cp 20 pv e2e4");
+	CHECK(bestmove == "bestmove e2e4");
+
+	// A reply which never arrives is reported as an error instead of waiting forever
+	pipe.write("Hello from engine\n");
+	pipe.close_write_end();
+	CHECK_THROWS_AS(read_isready_replies(reader), std::runtime_error);
+}
+
+TEST_CASE("chess::uci::Line_reader.Read with deadline", "[communication], [chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	Test_pipe pipe;
+	Line_reader reader(pipe.fds[0]);
+
+	// A partial line isn't handed out, but is kept until the rest arrives
+	pipe.write("uci");
+	std::string_view line;
+	auto start = std::chrono::steady_clock::now();
+	CHECK((reader.read_line(start + 50ms, line) == Line_reader::Status::timeout));
+	CHECK((std::chrono::steady_clock::now() - start >= 50ms));
+	pipe.write("ok\n");
+	REQUIRE((reader.read_line(std::chrono::steady_clock::now() + 1s, line) == Line_reader::Status::line));
+	CHECK(line == "uciok");
+
+	// Replies which don't arrive in time are reported as timeouts, and can still be read later
+	pipe.write("id name Fake engine\n");
+	CHECK(!read_uci_replies(reader, std::chrono::steady_clock::now() + 10ms).has_value());
+	pipe.write("readyok\n");
+	auto ready_replies = read_isready_replies(reader, std::chrono::steady_clock::now() + 1s);
+	REQUIRE(ready_replies.has_value());
+	CHECK((ready_replies->size() == 1));
+
+	std::vector<std::string> info_messages;
+	auto on_message = [&info_messages](std::string_view message) {
+		info_messages.emplace_back(message);
+	};
+	pipe.write("info depth 1 pv e2e4\n");
+	CHECK(!read_go_replies(reader, on_message, std::chrono::steady_clock::now() + 10ms).has_value());
+	pipe.write("bestmove e2e4\n");
+	auto bestmove = read_go_replies(reader, on_message, std::chrono::steady_clock::now() + 1s);
+	REQUIRE(bestmove.has_value());
+	CHECK(*bestmove == "bestmove e2e4");
+	CHECK((info_messages.size() == 1));
+
+	// The end of the stream is still an error, rather than a timeout
+	pipe.close_write_end();
+	CHECK_THROWS_AS(read_isready_replies(reader, std::chrono::steady_clock::now() + 1s), std::runtime_error);
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,70 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Live_snapshot.h"
+#include "chess_uci/Seqlock.h"
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chess {
+namespace uci {
+
+TEST_CASE("chess::uci::Seqlock.Readers never see a torn value", "[live], [chess], [uci]")
+{
+	// A value spanning several words, whose words are all equal when it's consistent
+	using Value = std::array<uint64_t, 17>;
+	Seqlock<Value> seqlock;
+	CHECK((seqlock.version() == 0));
+	CHECK((seqlock.load() == Value{}));
+
+	std::atomic<bool> stop{false};
+	std::atomic<uint64_t> num_torn_reads{0};
+	std::thread reader([&]() {
+		while (!stop) {
+			Value value = seqlock.load();
+			for (uint64_t word : value)
+				if (word != value.front())
+					num_torn_reads += 1;
+		}
+	});
+	const uint64_t num_stores = 100000;
+	for (uint64_t i = 1; i <= num_stores; ++i) {
+		Value value;
+		value.fill(i);
+		seqlock.store(value);
+	}
+	stop = true;
+	reader.join();
+
+	CHECK((num_torn_reads == 0));
+	CHECK((seqlock.version() == num_stores));
+	CHECK((seqlock.load().back() == num_stores));
+}
+
+TEST_CASE("chess::uci::Live_snapshot.Convert to analyzed lines", "[live], [chess], [uci]")
+{
+	Live_snapshot snapshot;
+	snapshot.num_lines = 3;
+	snapshot.lines[0].moves = Move_sequence::from_lan("e2e4 e7e5");
+	snapshot.lines[0].evaluation = Packed_evaluation(Evaluation{30});
+	// The second slot hasn't been reported yet
+	snapshot.lines[2].moves = Move_sequence::from_lan("d2d4");
+	snapshot.lines[2].evaluation = Packed_evaluation(Evaluation{10});
+
+	Seqlock<Live_snapshot> seqlock;
+	seqlock.store(snapshot);
+	auto lines = seqlock.load().to_analyzed_lines();
+	REQUIRE((lines.size() == 2));
+	CHECK((lines[0].moves == std::vector<std::string>{"e2e4", "e7e5"}));
+	CHECK((lines[0].evaluation.centi_pawns == 30));
+	CHECK((lines[1].moves == std::vector<std::string>{"d2d4"}));
+}
+
+} // namespace uci
+} // namespace chess
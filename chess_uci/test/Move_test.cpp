@@ -0,0 +1,71 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Line.h"
+#include "chess_uci/Move.h"
+
+#include <catch2/catch.hpp>
+
+namespace chess {
+namespace uci {
+
+TEST_CASE("chess::uci::Move.Convert moves to and from long algebraic notation", "[move], [chess], [uci]")
+{
+	Move move = Move::from_lan("e2e4");
+	CHECK(move.from() == 12);
+	CHECK(move.to() == 28);
+	CHECK(move.promotion() == Move::Promotion::none);
+	CHECK(to_string(move) == "e2e4");
+
+	move = Move::from_lan("a7a8q");
+	CHECK(move.from() == 48);
+	CHECK(move.to() == 56);
+	CHECK(move.promotion() == Move::Promotion::queen);
+	CHECK(to_string(move) == "a7a8q");
+	CHECK(to_string(Move::from_lan("h2h1N")) == "h2h1n");
+
+	move = Move::from_lan("0000");
+	CHECK(move.is_null());
+	CHECK(to_string(move) == "0000");
+
+	CHECK(Move::from_bits(Move::from_lan("g8f6").bits()) == Move::from_lan("g8f6"));
+
+	CHECK_THROWS_AS(Move::from_lan("e2e"), std::runtime_error);
+	CHECK_THROWS_AS(Move::from_lan("e2e9"), std::runtime_error);
+	CHECK_THROWS_AS(Move::from_lan("e7e8k"), std::runtime_error);
+}
+
+TEST_CASE("chess::uci::Move.Move sequences", "[move], [chess], [uci]")
+{
+	Move_sequence moves = Move_sequence::from_lan("d2d4  g8f6 c2c4");
+	REQUIRE(moves.size() == 3);
+	CHECK(moves[1] == Move::from_lan("g8f6"));
+	CHECK(to_string(moves) == "d2d4 g8f6 c2c4");
+	CHECK(moves.to_strings() == std::vector<std::string>{"d2d4", "g8f6", "c2c4"});
+	CHECK(Move_sequence::from_strings({"d2d4", "g8f6", "c2c4"}) == moves);
+
+	// Moves beyond the capacity are dropped
+	Move_sequence full;
+	for (size_t i = 0; i < Move_sequence::capacity; ++i)
+		CHECK(full.push_back(Move::from_lan("e2e4")));
+	CHECK(!full.push_back(Move::from_lan("e7e5")));
+	CHECK(full.size() == Move_sequence::capacity);
+}
+
+TEST_CASE("chess::uci::Move.Compact analyzed lines", "[move], [chess], [uci]")
+{
+	Analyzed_line line;
+	line.moves = {"e2e4", "e7e5", "g1f3"};
+	line.evaluation.centi_pawns = 35;
+
+	Compact_analyzed_line compact_line = to_compact_line(line);
+	CHECK(compact_line.moves.size() == 3);
+	CHECK(compact_line.evaluation == Packed_evaluation(line.evaluation));
+
+	Analyzed_line converted_line = to_analyzed_line(compact_line);
+	CHECK(converted_line.moves == line.moves);
+	REQUIRE(converted_line.evaluation.centi_pawns.has_value());
+	CHECK(*converted_line.evaluation.centi_pawns == 35);
+}
+
+} // namespace uci
+} // namespace chess
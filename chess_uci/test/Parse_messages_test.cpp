@@ -118,8 +118,10 @@ TEST_CASE("chess::uci::Parse_messages.Parse info", "[parsing], [chess], [uci]")
 
 	info = parse_info("info depth 7 seldepth 8 multipv 1 score cp 45 upperbound nodes 3036 nps 233538 tbhits 0 time 13 pv d2d4 c7c6");
 	REQUIRE(info.evaluation.has_value());
-	REQUIRE(info.evaluation->centi_pawns.has_value());
-	CHECK(*info.evaluation->centi_pawns == 45);
+	// The bound is kept even when other entries follow the score
+	CHECK(!info.evaluation->centi_pawns.has_value());
+	REQUIRE(info.evaluation->centi_pawns_upper_bound.has_value());
+	CHECK(*info.evaluation->centi_pawns_upper_bound == 45);
 	REQUIRE(info.line_index.has_value());
 	CHECK(info.line_index == 0);
 	REQUIRE(info.nodes.has_value());
@@ -143,5 +145,114 @@ TEST_CASE("chess::uci::Parse_messages.Parse info", "[parsing], [chess], [uci]")
 	CHECK(*info.time == 21);
 }
 
+TEST_CASE("chess::uci::Parse_messages.Parse bestmove", "[parsing], [chess], [uci]")
+{
+	Best_move best_move = parse_bestmove("bestmove e2e4 ponder e7e5");
+	CHECK(best_move.move == "e2e4");
+	REQUIRE(best_move.ponder.has_value());
+	CHECK(*best_move.ponder == "e7e5");
+
+	best_move = parse_bestmove("bestmove g7g8q");
+	CHECK(best_move.move == "g7g8q");
+	CHECK_FALSE(best_move.ponder.has_value());
+
+	best_move = parse_bestmove("bestmove (none)");
+	CHECK(best_move.move == "(none)");
+
+	CHECK_THROWS_AS(parse_bestmove("info depth 1"), std::runtime_error);
+	CHECK_THROWS_AS(parse_bestmove("bestmove"), std::runtime_error);
+}
+
+TEST_CASE("chess::uci::Parse_messages.Parse option", "[parsing], [chess], [uci]")
+{
+	CHECK(!parse_option("id name Stockfish 16").has_value());
+
+	auto option = parse_option("option name Hash type spin default 16 min 1 max 33554432");
+	REQUIRE(option.has_value());
+	CHECK(option->name == "Hash");
+	CHECK(option->type == Engine_option::Type::spin);
+	CHECK(option->default_value == std::string("16"));
+	CHECK(option->min == int64_t(1));
+	CHECK(option->max == int64_t(33554432));
+
+	// Names may contain spaces, and options may lack a default value
+	option = parse_option("option name Clear Hash type button");
+	REQUIRE(option.has_value());
+	CHECK(option->name == "Clear Hash");
+	CHECK(option->type == Engine_option::Type::button);
+	CHECK(!option->default_value.has_value());
+
+	option = parse_option("option name Style type combo default Normal var Solid var Normal var Risky");
+	REQUIRE(option.has_value());
+	CHECK(option->type == Engine_option::Type::combo);
+	CHECK(option->values == std::vector<std::string>{"Solid", "Normal", "Risky"});
+
+	option = parse_option("option name SyzygyPath type string default <empty>");
+	REQUIRE(option.has_value());
+	CHECK(option->type == Engine_option::Type::string);
+	CHECK(option->default_value == std::string(""));
+
+	option = parse_option("option name Ponder type check default false");
+	REQUIRE(option.has_value());
+	CHECK(option->type == Engine_option::Type::check);
+	CHECK(option->default_value == std::string("false"));
+
+	CHECK_THROWS_AS(parse_option("option type spin default 1"), std::runtime_error);
+	CHECK_THROWS_AS(parse_option("option name Hash"), std::runtime_error);
+	CHECK_THROWS_AS(parse_option("option name Hash type slider"), std::runtime_error);
+	CHECK_THROWS_AS(parse_option("option name Hash type spin min 10 max 1"), std::runtime_error);
+}
+
+TEST_CASE("chess::uci::Parse_messages.Parse all info entries", "[parsing], [chess], [uci]")
+{
+	Info info = parse_info("info depth 24 seldepth 31 multipv 2 score cp -17 lowerbound nodes 5123456789 nps 1874512 hashfull 412 tbhits 7 time 2733 pv e7e5 g1f3 b8c6");
+	CHECK(info.depth == 24u);
+	CHECK(info.selective_depth == 31u);
+	CHECK(info.line_index == 1);
+	REQUIRE(info.evaluation.has_value());
+	REQUIRE(info.evaluation->centi_pawns_lower_bound.has_value());
+	CHECK(*info.evaluation->centi_pawns_lower_bound == -17);
+	CHECK(!info.evaluation->centi_pawns.has_value());
+	CHECK(info.nodes == uint64_t(5123456789));
+	CHECK(info.nodes_per_second == uint64_t(1874512));
+	CHECK(info.hash_full == 412u);
+	CHECK(info.table_base_hits == uint64_t(7));
+	CHECK(info.time == 2733u);
+	REQUIRE(info.sequence_of_moves.has_value());
+	CHECK(*info.sequence_of_moves == std::vector<std::string>{"e7e5", "g1f3", "b8c6"});
+	CHECK(!info.current_move.has_value());
+
+	info = parse_info("info depth 12 currmove e1g1 currmovenumber 3");
+	CHECK(info.depth == 12u);
+	CHECK(info.current_move == std::string("e1g1"));
+	CHECK(info.current_move_number == 3u);
+	CHECK(!info.evaluation.has_value());
+	CHECK(!info.sequence_of_moves.has_value());
+
+	info = parse_info("info depth 9 score mate -2 upperbound pv h7h8q");
+	REQUIRE(info.evaluation.has_value());
+	REQUIRE(info.evaluation->black_can_mate_in.has_value());
+	CHECK(*info.evaluation->black_can_mate_in == 2);
+	CHECK(*info.sequence_of_moves == std::vector<std::string>{"h7h8q"});
+}
+
+TEST_CASE("chess::uci::Parse_messages.Parse info with keywords inside other entries", "[parsing], [chess], [uci]")
+{
+	// Keywords only count as whole tokens at the position of an entry
+	Info info = parse_info("info string time to improve the pv nodes");
+	CHECK(!info.time.has_value());
+	CHECK(!info.sequence_of_moves.has_value());
+	CHECK(!info.nodes.has_value());
+
+	info = parse_info("info multipv 1 depth 3 score cp 5 nodes 120 nps 60000 time 2 pv e2e4");
+	CHECK(info.time == 2u);
+	CHECK(info.nodes == uint64_t(120));
+	CHECK(info.nodes_per_second == uint64_t(60000));
+
+	// Malformed numbers are reported as errors
+	CHECK_THROWS_AS(parse_info("info depth x"), std::runtime_error);
+	CHECK_THROWS_AS(parse_info("info score cp"), std::runtime_error);
+}
+
 } // namespace uci
 } // namespace chess
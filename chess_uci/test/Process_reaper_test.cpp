@@ -0,0 +1,56 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Engine.h"
+#include "chess_uci/Process_reaper.h"
+
+#include <boost/process.hpp>
+#include <catch2/catch.hpp>
+
+#include <signal.h>
+
+#include <cerrno>
+#include <chrono>
+
+namespace chess {
+namespace uci {
+
+using namespace std::chrono_literals;
+
+TEST_CASE("chess::uci.Process_reaper.Kill processes which don't exit", "[chess], [uci]")
+{
+	Process_reaper& reaper = Process_reaper::instance();
+	uint64_t num_killed = reaper.num_killed();
+
+	boost::process::child process("/bin/sleep", "10");
+	auto pid = process.id();
+	auto start = std::chrono::steady_clock::now();
+	reaper.reap(std::move(process), 50ms);
+	reaper.wait_until_empty();
+	CHECK((std::chrono::steady_clock::now() - start < 5s));
+	CHECK((reaper.num_killed() == num_killed + 1));
+	// The process has been waited for, so it's gone
+	CHECK((::kill(pid, 0) == -1));
+	CHECK((errno == ESRCH));
+}
+
+TEST_CASE("chess::uci.Process_reaper.Engines quit when destroyed", "[chess], [uci]")
+{
+	Process_reaper& reaper = Process_reaper::instance();
+	uint64_t num_killed = reaper.num_killed();
+
+	auto engines = Engine::start_engines("./dummy_engine", 4);
+	REQUIRE((engines.size() == 4));
+	for (auto& engine : engines) {
+		engine->start_calculating(Search_limits::for_depth(1));
+		CHECK((engine->wait_for_result().size() == 1));
+	}
+	// Destroying the engines doesn't wait for them to exit
+	engines.clear();
+	reaper.wait_until_empty();
+	CHECK((reaper.num_pending() == 0));
+	// The engines quit by themselves
+	CHECK((reaper.num_killed() == num_killed));
+}
+
+} // namespace uci
+} // namespace chess
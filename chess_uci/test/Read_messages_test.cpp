@@ -58,5 +58,25 @@ TEST_CASE("chess::uci::Read_engine_messages.Read go messages", "[communication],
 	REQUIRE(messages[1] == "bestmove e2e4");
 }
 
+TEST_CASE("chess::uci::Read_engine_messages.Stream go messages", "[communication], [chess], [uci]")
+{
+	std::stringstream stream;
+
+	// Write fake engine messages to the stream
+	stream << "info depth 1 score cp 20 pv e2e4\n";
+	stream << "info depth 2 score cp 25 pv e2e4 e7e5\n";
+	stream << "bestmove e2e4\n";
+
+	// Read engine messages, one at a time
+	std::vector<std::string> messages;
+	std::string bestmove = read_go_replies(stream, [&messages](const std::string& message) {
+		messages.push_back(message);
+	});
+	REQUIRE(messages.size() == 2);
+	REQUIRE(messages[0] == "info depth 1 score cp 20 pv e2e4");
+	REQUIRE(messages[1] == "info depth 2 score cp 25 pv e2e4 e7e5");
+	REQUIRE(bestmove == "bestmove e2e4");
+}
+
 } // namespace uci
 } // namespace chess
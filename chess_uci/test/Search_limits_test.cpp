@@ -0,0 +1,69 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Search_limits.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+
+namespace chess {
+namespace uci {
+
+TEST_CASE("chess::uci::Search_limits.Go command", "[search limits], [chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	CHECK(to_go_command(Search_limits()) == "go infinite");
+	CHECK(to_go_command(Search_limits::infinite_search()) == "go infinite");
+	CHECK(to_go_command(Search_limits::for_depth(20)) == "go depth 20");
+	CHECK(to_go_command(Search_limits::for_nodes(5000000000)) == "go nodes 5000000000");
+	CHECK(to_go_command(Search_limits::for_mate(3)) == "go mate 3");
+	CHECK(to_go_command(Search_limits::for_move_time(1500ms)) == "go movetime 1500");
+
+	Search_limits limits;
+	limits.depth = 12;
+	limits.move_time = 2s;
+	CHECK(to_go_command(limits) == "go depth 12 movetime 2000");
+
+	Search_limits clock;
+	clock.white_time = 60s;
+	clock.black_time = 45s;
+	clock.white_increment = 2s;
+	clock.black_increment = 2s;
+	clock.moves_to_go = 20;
+	CHECK(clock.is_finite());
+	CHECK(to_go_command(clock) == "go wtime 60000 btime 45000 winc 2000 binc 2000 movestogo 20");
+
+	// Pondering doesn't finish until the opponent has moved, after which the other limits apply
+	Search_limits ponder = Search_limits::for_depth(12);
+	ponder.ponder = true;
+	CHECK_FALSE(ponder.is_finite());
+	CHECK(to_go_command(ponder) == "go ponder depth 12");
+	ponder.depth.reset();
+	CHECK(to_go_command(ponder) == "go ponder infinite");
+
+	// Infinite overrides the other limits
+	limits.infinite = true;
+	CHECK_FALSE(limits.is_finite());
+	CHECK(to_go_command(limits) == "go depth 12 movetime 2000 infinite");
+}
+
+TEST_CASE("chess::uci::Search_limits.Sub millisecond move times", "[search limits], [chess], [uci]")
+{
+	using namespace std::chrono_literals;
+	// Move times are rounded up to whole milliseconds, and never sent as 0 since that means no limit to some engines
+	CHECK(to_go_command(Search_limits::for_move_time(1ms)) == "go movetime 1");
+	CHECK(to_go_command(Search_limits::for_move_time(1001us)) == "go movetime 2");
+	CHECK(to_go_command(Search_limits::for_move_time(250us)) == "go movetime 1");
+	CHECK(to_go_command(Search_limits::for_move_time(0us)) == "go movetime 1");
+}
+
+TEST_CASE("chess::uci::Search_limits.Comparison", "[search limits], [chess], [uci]")
+{
+	CHECK(Search_limits::for_depth(10) == Search_limits::for_depth(10));
+	CHECK(Search_limits::for_depth(10) != Search_limits::for_depth(11));
+	CHECK(Search_limits::for_depth(10) != Search_limits::for_nodes(10));
+	CHECK(Search_limits() != Search_limits::infinite_search());
+}
+
+} // namespace uci
+} // namespace chess
@@ -0,0 +1,55 @@
+#define CATCH_CONFIG_MAIN
+
+#include "chess_uci/Spare_engines.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace chess {
+namespace uci {
+
+TEST_CASE("chess::uci.Spare_engines.Take ready engines", "[chess], [uci]")
+{
+	std::atomic<int> num_setups{0};
+	Spare_engines spares("./dummy_engine", 2, 1, [&num_setups](Engine& engine) {
+		engine.set_threads(2);
+		++num_setups;
+	});
+	spares.wait_until_ready();
+	CHECK((spares.num_ready() == 2));
+	CHECK((num_setups == 2));
+
+	auto engine = spares.take();
+	REQUIRE(engine != nullptr);
+	engine->start_calculating(Search_limits::for_depth(1));
+	CHECK((engine->wait_for_result().size() == 1));
+
+	// A replacement is started in the background
+	spares.wait_until_ready();
+	CHECK((spares.num_ready() == 2));
+	CHECK((num_setups == 3));
+
+	// Taking more engines than there are spares starts the missing ones right away
+	auto first = spares.take();
+	auto second = spares.take();
+	auto third = spares.take();
+	CHECK((first != nullptr));
+	CHECK((second != nullptr));
+	CHECK((third != nullptr));
+}
+
+TEST_CASE("chess::uci.Spare_engines.Engine which fails to start", "[chess], [uci]")
+{
+	// The engine exits right away, without replying to uci
+	Spare_engines spares("/bin/true", 1);
+	spares.wait_until_ready();
+	CHECK((spares.num_ready() == 0));
+	CHECK_THROWS_AS(spares.take(), std::runtime_error);
+}
+
+} // namespace uci
+} // namespace chess
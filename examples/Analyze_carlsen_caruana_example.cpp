@@ -2,7 +2,6 @@
 
 #include <chrono>
 #include <iostream>
-#include <thread>
 
 int main()
 {
@@ -17,11 +16,10 @@ int main()
 	std::string moves_lan = "e2e4 c7c5 g1f3 e7e6 c2c4 b8c6 d2d4 c5d4 f3d4 f8c5 d4c2 g8f6 b1c3 e8g8 c1e3 b7b6 f1e2 c8b7 e1g1 d8e7";
 	engine.setup_game_from_moves(moves_lan);
 
-	// Let engine calculate for 1 s
-	engine.start_calculating();
+	// Let engine calculate for 1 s, and wait for it to finish
 	using namespace std::chrono_literals;
-	std::this_thread::sleep_for(1s);
-	engine.stop_calculating();
+	engine.start_calculating(Search_limits::for_move_time(1s));
+	engine.wait_for_result();
 
 	// Print the best lines given by the engine and their evaluation
 	for (const Analyzed_line& line : engine.get_top_suggested_move_sequences()) {
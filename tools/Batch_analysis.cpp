@@ -0,0 +1,354 @@
+/**
+ * \file Batch_analysis.cpp
+ * \brief Command line tool analyzing a stream of positions with a pool of engines, writing the
+ * results as newline delimited JSON.
+ *
+ * Positions are read one per line, in EPD or FEN format, from a file or the standard input. Only a
+ * bounded number of positions are read ahead of the results written, so memory use doesn't depend
+ * on the size of the input.
+ */
+
+#include "chess_uci/Engine_pool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace chess::uci;
+
+const char* usage = R"(Usage: batch_analysis --engine ENGINE [options] [INPUT]
+
+Analyze positions read from INPUT (or the standard input if INPUT is missing or '-'),
+one position per line in EPD or FEN format, and write one JSON object per position
+to the standard output.
+
+Options:
+  --engine ENGINE     Path to the UCI engine executable, or unix:PATH or tcp:HOST:PORT for an
+                      engine served by engine_host (required).
+  --engines N         Number of engines to run (default: number of cores).
+  --lines N           Number of best lines to calculate per position (default: 1).
+  --movetime MS       Time to analyze each position, in milliseconds (default: 1000).
+  --depth N           Depth to analyze each position to.
+  --nodes N           Number of nodes to search in each position.
+                      If several limits are given, the analysis stops at the first
+                      one reached. If only --depth or --nodes is given there is no
+                      time limit.
+  --order ORDER       Write results in 'input' order (default) or 'completion' order.
+  --window N          Maximum number of positions being analyzed or waiting to be
+                      written at the same time (default: 4 times the number of engines).
+  --new-game          Tell the engines a new game starts before each position.
+)";
+
+struct Options
+{
+	std::string engine;
+	size_t num_engines{std::max(1u, std::thread::hardware_concurrency())};
+	int num_lines{1};
+	Search_limits limits;
+	bool input_order{true};
+	size_t window{0};
+	bool new_game{false};
+	std::string input{"-"};
+};
+
+/// A position read from the input.
+struct Position
+{
+	/// Index of the position in the input, starting from zero.
+	uint64_t index{0};
+	/// Position in FEN format.
+	std::string fen;
+	/// EPD 'id' operation, if any.
+	std::string id;
+};
+
+Options parse_options(int argc, char* argv[])
+{
+	Options options;
+	auto value = [&](int& i) -> std::string {
+		if (i + 1 >= argc)
+			throw std::runtime_error(std::string("Missing value for ") + argv[i]);
+		return argv[++i];
+	};
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--engine")
+			options.engine = value(i);
+		else if (argument == "--engines")
+			options.num_engines = std::stoul(value(i));
+		else if (argument == "--lines")
+			options.num_lines = std::stoi(value(i));
+		else if (argument == "--movetime")
+			options.limits.move_time = std::chrono::milliseconds(std::stoul(value(i)));
+		else if (argument == "--depth")
+			options.limits.depth = static_cast<uint16_t>(std::stoul(value(i)));
+		else if (argument == "--nodes")
+			options.limits.nodes = std::stoull(value(i));
+		else if (argument == "--order") {
+			std::string order = value(i);
+			if (order != "input" && order != "completion")
+				throw std::runtime_error("Unknown order " + order);
+			options.input_order = order == "input";
+		} else if (argument == "--window")
+			options.window = std::stoul(value(i));
+		else if (argument == "--new-game")
+			options.new_game = true;
+		else if (argument == "--help" || argument == "-h")
+			throw std::runtime_error("");
+		else if (argument.size() > 1 && argument[0] == '-' && argument != "-")
+			throw std::runtime_error("Unknown option " + argument);
+		else
+			options.input = argument;
+	}
+	if (options.engine.empty())
+		throw std::runtime_error("No engine given");
+	if (options.num_engines == 0 || options.num_lines < 1 || options.num_lines > 255)
+		throw std::runtime_error("Invalid option value");
+	if (!options.limits.is_finite())
+		options.limits.move_time = std::chrono::seconds(1);
+	if (options.window == 0)
+		options.window = 4 * options.num_engines;
+	return options;
+}
+
+/**
+ * Parse a line of EPD or FEN.
+ *
+ * EPD lines have the same first four fields as FEN, followed by operations such as 'bm e4; id "x";'.
+ * FEN lines instead end with the half move clock and full move number.
+ */
+bool parse_position(const std::string& line, Position& position)
+{
+	std::istringstream stream(line);
+	std::vector<std::string> fields(4);
+	for (std::string& field : fields)
+		if (!(stream >> field))
+			return false;
+	std::string rest;
+	std::getline(stream, rest);
+
+	position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+	position.id.clear();
+	std::istringstream rest_stream(rest);
+	std::string half_moves;
+	std::string full_moves;
+	bool is_fen = (rest_stream >> half_moves >> full_moves)
+		&& half_moves.find_first_not_of("0123456789") == std::string::npos
+		&& full_moves.find_first_not_of("0123456789") == std::string::npos;
+	if (is_fen) {
+		position.fen += " " + half_moves + " " + full_moves;
+		return true;
+	}
+
+	position.fen += " 0 1";
+	if (size_t pos = rest.find("id \""); pos != std::string::npos) {
+		size_t end = rest.find('"', pos + 4);
+		if (end != std::string::npos)
+			position.id = rest.substr(pos + 4, end - pos - 4);
+	}
+	return true;
+}
+
+std::string json_string(const std::string& string)
+{
+	std::string json = "\"";
+	for (char c : string) {
+		switch (c) {
+		case '"':
+			json += "\\\"";
+			break;
+		case '\\':
+			json += "\\\\";
+			break;
+		case '\n':
+			json += "\\n";
+			break;
+		case '\t':
+			json += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				json += escaped;
+			} else {
+				json += c;
+			}
+		}
+	}
+	return json + "\"";
+}
+
+std::string json_evaluation(const Evaluation& evaluation)
+{
+	std::string json;
+	if (evaluation.centi_pawns.has_value())
+		json = "\"cp\":" + std::to_string(*evaluation.centi_pawns);
+	else if (evaluation.centi_pawns_lower_bound.has_value())
+		json = "\"cp\":" + std::to_string(*evaluation.centi_pawns_lower_bound) + ",\"bound\":\"lower\"";
+	else if (evaluation.centi_pawns_upper_bound.has_value())
+		json = "\"cp\":" + std::to_string(*evaluation.centi_pawns_upper_bound) + ",\"bound\":\"upper\"";
+	else if (evaluation.white_can_mate_in.has_value())
+		json = "\"mate\":" + std::to_string(*evaluation.white_can_mate_in);
+	else if (evaluation.black_can_mate_in.has_value())
+		json = "\"mate\":-" + std::to_string(*evaluation.black_can_mate_in);
+	else
+		return "";
+	return json + ",\"evaluation\":" + json_string(to_string(evaluation));
+}
+
+std::string to_json(const Position& position, const std::vector<Analyzed_line>& lines)
+{
+	std::string json = "{\"index\":" + std::to_string(position.index);
+	if (!position.id.empty())
+		json += ",\"id\":" + json_string(position.id);
+	json += ",\"fen\":" + json_string(position.fen) + ",\"lines\":[";
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (i > 0)
+			json += ",";
+		json += "{";
+		std::string evaluation = json_evaluation(lines[i].evaluation);
+		if (!evaluation.empty())
+			json += evaluation + ",";
+		json += "\"pv\":[";
+		for (size_t j = 0; j < lines[i].moves.size(); ++j) {
+			if (j > 0)
+				json += ",";
+			json += json_string(lines[i].moves[j]);
+		}
+		json += "]}";
+	}
+	return json + "]}";
+}
+
+std::string to_json(const Position& position, const std::string& error)
+{
+	std::string json = "{\"index\":" + std::to_string(position.index);
+	if (!position.id.empty())
+		json += ",\"id\":" + json_string(position.id);
+	return json + ",\"fen\":" + json_string(position.fen) + ",\"error\":" + json_string(error) + "}";
+}
+
+/// Writes results to the standard output, in input order or completion order, and limits the number
+/// of positions in flight.
+class Result_writer
+{
+public:
+	Result_writer(bool input_order, size_t window)
+		: input_order_(input_order)
+		, window_(window)
+	{}
+
+	/// Wait until there's room for another position.
+	void wait_for_room()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		room_available_.wait(lock, [this]() {
+			return in_flight_ < window_;
+		});
+		in_flight_ += 1;
+	}
+
+	void write(uint64_t index, std::string json)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!input_order_) {
+			std::cout << json << '\n';
+			in_flight_ -= 1;
+		} else {
+			// Hold results back until all earlier results have been written
+			pending_.emplace(index, std::move(json));
+			for (auto it = pending_.begin(); it != pending_.end() && it->first == next_index_; it = pending_.erase(it)) {
+				std::cout << it->second << '\n';
+				next_index_ += 1;
+				in_flight_ -= 1;
+			}
+		}
+		room_available_.notify_all();
+	}
+
+	/// Wait until all positions have been written.
+	void wait_until_done()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		room_available_.wait(lock, [this]() {
+			return in_flight_ == 0;
+		});
+		std::cout << std::flush;
+	}
+
+private:
+	const bool input_order_;
+	const size_t window_;
+	std::mutex mutex_;
+	std::condition_variable room_available_;
+	size_t in_flight_{0};
+	std::map<uint64_t, std::string> pending_;
+	uint64_t next_index_{0};
+};
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	try {
+		options = parse_options(argc, argv);
+	} catch (std::exception& e) {
+		if (*e.what() != '\0')
+			std::cerr << "Error: " << e.what() << "\n\n";
+		std::cerr << usage;
+		return 1;
+	}
+
+	std::ifstream input_file;
+	if (options.input != "-") {
+		input_file.open(options.input);
+		if (!input_file) {
+			std::cerr << "Error: Failed to open " << options.input << std::endl;
+			return 1;
+		}
+	}
+	std::istream& input = options.input == "-" ? std::cin : input_file;
+
+	std::ios::sync_with_stdio(false);
+	Engine_pool pool(Engine_endpoint::parse(options.engine), options.num_engines, static_cast<uint8_t>(options.num_lines));
+	Result_writer writer(options.input_order, options.window);
+
+	std::string line;
+	Position position;
+	uint64_t num_positions = 0;
+	while (std::getline(input, line)) {
+		if (line.empty() || line[0] == '#' || !parse_position(line, position))
+			continue;
+		position.index = num_positions++;
+
+		writer.wait_for_room();
+		Analysis_job job;
+		job.fen = position.fen;
+		job.new_game = options.new_game;
+		job.limits = options.limits;
+		pool.execute([&writer, position, job](Engine& engine) {
+			std::string json;
+			try {
+				json = to_json(position, run_analysis_job(engine, job));
+			} catch (std::exception& e) {
+				json = to_json(position, e.what());
+			}
+			writer.write(position.index, std::move(json));
+		});
+	}
+
+	writer.wait_until_done();
+	return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * \file Engine_host.cpp
+ * \brief Command line tool serving a UCI engine on a Unix domain socket or TCP port, so that
+ * engines can run on another machine (or in another container) than the analysis.
+ *
+ * Each connection gets its own engine process. Connect with e.g. 'batch_analysis --engine
+ * tcp:HOST:PORT', or by giving the address to chess::uci::Engine as an Engine_endpoint.
+ */
+
+#include "chess_uci/Engine_server.h"
+
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using namespace chess::uci;
+
+const char* usage = R"(Usage: engine_host --engine PATH --listen ADDRESS [options]
+
+Serves a UCI engine, starting an engine process for each connection.
+
+Options:
+  --engine PATH       Path to the UCI engine executable (required).
+  --listen ADDRESS    Where to listen: unix:PATH for a Unix domain socket, or tcp:HOST:PORT for
+                      TCP (required). Port 0 picks a free port. The address listened on is
+                      printed on the standard output.
+  --max-engines N     Maximum number of engines to run at the same time (default: no limit).
+)";
+
+struct Options
+{
+	std::string engine;
+	std::string listen;
+	size_t max_engines{0};
+};
+
+Options parse_options(int argc, char* argv[])
+{
+	Options options;
+	auto value = [&](int& i) -> std::string {
+		if (i + 1 >= argc)
+			throw std::runtime_error(std::string("Missing value for ") + argv[i]);
+		return argv[++i];
+	};
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		if (argument == "--engine")
+			options.engine = value(i);
+		else if (argument == "--listen")
+			options.listen = value(i);
+		else if (argument == "--max-engines")
+			options.max_engines = std::stoul(value(i));
+		else if (argument == "--help" || argument == "-h")
+			throw std::runtime_error("");
+		else
+			throw std::runtime_error("Unknown option " + argument);
+	}
+	if (options.engine.empty())
+		throw std::runtime_error("No engine given");
+	if (options.listen.empty())
+		throw std::runtime_error("No address to listen on given");
+	return options;
+}
+
+/// Server to stop when the program is interrupted.
+Engine_server* running_server = nullptr;
+
+extern "C" void stop_server(int)
+{
+	// Only writes to a pipe, which is safe in a signal handler
+	if (running_server != nullptr)
+		running_server->stop();
+}
+
+} // Anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	Engine_endpoint endpoint;
+	try {
+		options = parse_options(argc, argv);
+		endpoint = Engine_endpoint::parse(options.listen);
+		if (endpoint.kind == Engine_endpoint::Kind::process)
+			throw std::runtime_error("Expected unix:PATH or tcp:HOST:PORT to listen on, got " + options.listen);
+	} catch (std::exception& e) {
+		if (*e.what() != '\0')
+			std::cerr << "Error: " << e.what() << "\n\n";
+		std::cerr << usage;
+		return 1;
+	}
+
+	try {
+		Engine_server server(options.engine, endpoint, options.max_engines);
+		running_server = &server;
+		std::signal(SIGINT, stop_server);
+		std::signal(SIGTERM, stop_server);
+
+		std::cout << "Listening on " << to_string(server.address()) << std::endl;
+		server.run();
+		running_server = nullptr;
+	} catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}